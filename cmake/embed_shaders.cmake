@@ -0,0 +1,40 @@
+# Turns compiled SPIR-V files into constexpr uint32_t arrays and a lookup table for findEmbeddedShader()
+# Usage: cmake -DSPIRV_FILES="a.spv;b.spv" -DOUTPUT=embedded_shaders.cpp -P embed_shaders.cmake
+
+set(CONTENTS "// Generated by cmake/embed_shaders.cmake, do not edit\n")
+string(APPEND CONTENTS "#include \"engine/pipeline/embedded_shaders/embedded_shaders.hpp\"\n\n")
+string(APPEND CONTENTS "namespace Renderer{\n")
+
+set(TABLE "")
+set(COUNT 0)
+foreach(SPIRV ${SPIRV_FILES})
+    get_filename_component(FILE_NAME ${SPIRV} NAME)
+    string(MAKE_C_IDENTIFIER ${FILE_NAME} IDENTIFIER)
+
+    # SPIR-V is a stream of little endian 32 bit words, so the bytes of each word are swapped into a hex literal
+    file(READ ${SPIRV} HEX HEX)
+    string(LENGTH "${HEX}" HEX_LENGTH)
+    math(EXPR BYTE_COUNT "${HEX_LENGTH} / 2")
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])" "0x\\4\\3\\2\\1," WORDS "${HEX}")
+    string(REGEX REPLACE "((0x[0-9a-f]+,){8})" "\\1\n        " WORDS "${WORDS}")
+
+    string(APPEND CONTENTS "    static constexpr uint32_t ${IDENTIFIER}[] = {\n        ${WORDS}\n    };\n\n")
+    string(APPEND TABLE "        { \"${FILE_NAME}\", ${IDENTIFIER}, ${BYTE_COUNT} },\n")
+    math(EXPR COUNT "${COUNT} + 1")
+endforeach()
+
+# Zero sized arrays aren't allowed, keep a placeholder entry that the count excludes
+if (COUNT EQUAL 0)
+    set(TABLE "        { \"\", nullptr, 0 },\n")
+endif()
+
+string(APPEND CONTENTS "    extern const EmbeddedShader embeddedShaders[] = {\n${TABLE}    };\n")
+string(APPEND CONTENTS "    extern const size_t embeddedShaderCount = ${COUNT};\n}\n")
+
+# Only rewrite when something changed so the generated file doesn't trigger needless recompiles
+if (EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} PREVIOUS)
+endif()
+if (NOT PREVIOUS STREQUAL CONTENTS)
+    file(WRITE ${OUTPUT} "${CONTENTS}")
+endif()
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "engine/bvh/bvh.hpp"
+#include "engine/camera/camera.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+// Measures insert, refit, rebuild, query and remove times of the scene BVH, by default over one million objects.
+// Usage: bvh_bench [objectCount]
+namespace{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start){
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void report(const std::string& name, double milliseconds, size_t operations){
+        std::cout << name << ": " << milliseconds << " ms (" << (milliseconds * 1e6 / operations) << " ns/op)" << '\n';
+    }
+
+    Renderer::AABB randomBox(std::mt19937& rng, float worldSize){
+        std::uniform_real_distribution<float> position{-worldSize, worldSize};
+        std::uniform_real_distribution<float> size{0.25f, 2.f};
+        glm::vec3 center{position(rng), position(rng), position(rng)};
+        glm::vec3 extent{size(rng), size(rng), size(rng)};
+        Renderer::AABB box;
+        box.min = center - extent;
+        box.max = center + extent;
+        return box;
+    }
+}
+
+int main(int argc, char** argv){
+    const size_t objectCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const size_t queryCount = 1000;
+    const float worldSize = 1000.f;
+
+    std::mt19937 rng{1234};
+    std::vector<Renderer::AABB> boxes(objectCount);
+    for(auto& box : boxes)
+        box = randomBox(rng, worldSize);
+
+    std::cout << "Objects: " << objectCount << '\n';
+    Renderer::BVH bvh{};
+    std::vector<int32_t> proxies(objectCount);
+
+    auto start = Clock::now();
+    for(size_t i = 0; i < objectCount; i++)
+        proxies[i] = bvh.createProxy(boxes[i], i);
+    report("Insert", elapsedMs(start), objectCount);
+    std::cout << "Height after inserts: " << bvh.getHeight() << ", SAH cost: " << bvh.getAreaCost() << '\n';
+
+    start = Clock::now();
+    bvh.rebuild();
+    report("Rebuild", elapsedMs(start), objectCount);
+    std::cout << "Height after rebuild: " << bvh.getHeight() << ", SAH cost: " << bvh.getAreaCost() << '\n';
+
+    // Move every object a little, most should stay within their fattened bounds
+    std::uniform_real_distribution<float> jitter{-0.3f, 0.3f};
+    start = Clock::now();
+    size_t changed = 0;
+    for(size_t i = 0; i < objectCount; i++){
+        glm::vec3 offset{jitter(rng), jitter(rng), jitter(rng)};
+        boxes[i].min += offset;
+        boxes[i].max += offset;
+        changed += bvh.moveProxy(proxies[i], boxes[i]);
+    }
+    report("Move", elapsedMs(start), objectCount);
+    std::cout << "Proxies refit or reinserted: " << changed << ", rebuild recommended: " << (bvh.shouldRebuild() ? "yes" : "no") << '\n';
+
+    Renderer::Camera camera{};
+    size_t hits = 0;
+    auto countHit = [&hits](int32_t){ hits++; return true; };
+
+    std::uniform_real_distribution<float> position{-worldSize, worldSize};
+    start = Clock::now();
+    for(size_t i = 0; i < queryCount; i++){
+        glm::vec3 center{position(rng), position(rng), position(rng)};
+        Renderer::AABB box;
+        box.min = center - glm::vec3{25.f};
+        box.max = center + glm::vec3{25.f};
+        bvh.queryBox(box, countHit);
+    }
+    report("Box query", elapsedMs(start), queryCount);
+    std::cout << "Average box hits: " << static_cast<double>(hits) / queryCount << '\n';
+
+    hits = 0;
+    start = Clock::now();
+    for(size_t i = 0; i < queryCount; i++)
+        bvh.querySphere({{position(rng), position(rng), position(rng)}, 25.f}, countHit);
+    report("Sphere query", elapsedMs(start), queryCount);
+    std::cout << "Average sphere hits: " << static_cast<double>(hits) / queryCount << '\n';
+
+    hits = 0;
+    start = Clock::now();
+    for(size_t i = 0; i < queryCount; i++){
+        Renderer::Ray ray{{position(rng), position(rng), position(rng)}, glm::normalize(glm::vec3{position(rng), position(rng), position(rng)})};
+        bvh.queryRay(ray, 200.f, [&hits](int32_t, float){ hits++; return true; });
+    }
+    report("Ray query", elapsedMs(start), queryCount);
+    std::cout << "Average ray hits: " << static_cast<double>(hits) / queryCount << '\n';
+
+    hits = 0;
+    start = Clock::now();
+    for(size_t i = 0; i < queryCount; i++){
+        camera.setPerspectiveProjection(glm::radians(90.f), 16.f / 9.f, 0.1f, 250.f);
+        camera.setViewYXZ({position(rng), position(rng), position(rng)}, {0.f, glm::radians(position(rng)), 0.f});
+        bvh.queryFrustum(camera.getFrustum(), countHit);
+    }
+    report("Frustum query", elapsedMs(start), queryCount);
+    std::cout << "Average frustum hits: " << static_cast<double>(hits) / queryCount << '\n';
+
+    start = Clock::now();
+    for(size_t i = 0; i < objectCount; i++)
+        bvh.destroyProxy(proxies[i]);
+    report("Remove", elapsedMs(start), objectCount);
+
+    return 0;
+}
\ No newline at end of file
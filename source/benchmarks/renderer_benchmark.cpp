@@ -0,0 +1,542 @@
+#include "engine/device/device.hpp"
+#include "engine/renderer/renderer.hpp"
+#include "engine/systems/render_system/render_system.hpp"
+#include "engine/threading/thread_pool.hpp"
+#include "engine/camera/camera.hpp"
+#include "engine/profiling/gpu_profiler.hpp"
+#include "engine/profiling/cpu_profiler.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <vector>
+#include <map>
+#include <functional>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <cctype>
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/resource.h>
+#endif
+
+#ifndef RENDERER_ASSET_DIR
+    #define RENDERER_ASSET_DIR "source/"
+#endif
+
+// Renders a procedurally generated scene headless along a scripted camera path and writes frame times, CPU/GPU zone
+// timings, draw counts and memory use as JSON. Given a baseline JSON from an earlier run, timings and draw counts that
+// got worse by more than the tolerance are reported and the exit code is 2. With --msaa tiers the path is flown again at
+// every MSAA tier the device supports and each tier's frame cost is reported, the main run uses 4x.
+// Usage: renderer_bench [--objects N] [--models M] [--materials K] [--textures T] [--frames F] [--warmup W]
+//                       [--width W] [--height H] [--frames-in-flight N] [--culling none|cpu|gpu] [--msaa 1|2|4|8|tiers] [--seed S]
+//                       [--assets dir] [--output results.json] [--baseline baseline.json] [--tolerance 0.1] [--trace trace.json]
+namespace{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options{
+        uint32_t objectCount = 1000;
+        uint32_t modelCount = 3;
+        uint32_t materialCount = 8;
+        uint32_t textureCount = 4;
+        uint32_t frameCount = 600;
+        uint32_t warmupFrames = 60;
+        uint32_t width = 1280, height = 720;
+        uint32_t framesInFlight = 2;
+        std::string culling = "gpu";
+        VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_4_BIT;
+        bool msaaTiers = false;
+        uint32_t seed = 1;
+        std::string assetDirectory = RENDERER_ASSET_DIR;
+        std::string outputPath = "renderer_bench.json";
+        std::string baselinePath;
+        double tolerance = 0.1;
+        std::string tracePath;
+    };
+
+    Options parseOptions(int argc, char** argv){
+        Options options{};
+        for(int i = 1; i < argc; i++){
+            std::string argument = argv[i];
+            if(i + 1 >= argc)
+                throw std::runtime_error("Missing value for " + argument);
+            std::string value = argv[++i];
+            auto toUint = [&value](){ return static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10)); };
+
+            if(argument == "--objects") options.objectCount = toUint();
+            else if(argument == "--models") options.modelCount = std::max(toUint(), 1u);
+            else if(argument == "--materials") options.materialCount = std::max(toUint(), 1u);
+            else if(argument == "--textures") options.textureCount = toUint();
+            else if(argument == "--frames") options.frameCount = std::max(toUint(), 1u);
+            else if(argument == "--warmup") options.warmupFrames = toUint();
+            else if(argument == "--width") options.width = toUint();
+            else if(argument == "--height") options.height = toUint();
+            else if(argument == "--frames-in-flight") options.framesInFlight = std::clamp(toUint(), 1u, static_cast<uint32_t>(Renderer::SwapChain::MAX_FRAMES_IN_FLIGHT));
+            else if(argument == "--culling") options.culling = value;
+            else if(argument == "--msaa"){
+                options.msaaTiers = value == "tiers";
+                if(!options.msaaTiers){
+                    uint32_t samples = toUint();
+                    if(samples != 1 && samples != 2 && samples != 4 && samples != 8)
+                        throw std::runtime_error("--msaa must be 1, 2, 4, 8 or tiers");
+                    options.msaaSamples = static_cast<VkSampleCountFlagBits>(samples);
+                }
+            }
+            else if(argument == "--seed") options.seed = toUint();
+            else if(argument == "--assets") options.assetDirectory = value + "/";
+            else if(argument == "--output") options.outputPath = value;
+            else if(argument == "--baseline") options.baselinePath = value;
+            else if(argument == "--tolerance") options.tolerance = std::strtod(value.c_str(), nullptr);
+            else if(argument == "--trace") options.tracePath = value;
+            else
+                throw std::runtime_error("Unknown argument: " + argument);
+        }
+        return options;
+    }
+
+    Renderer::RenderSystem::CullingMode toCullingMode(const std::string& name){
+        if(name == "none") return Renderer::RenderSystem::CullingMode::None;
+        if(name == "cpu") return Renderer::RenderSystem::CullingMode::CPU;
+        if(name == "gpu") return Renderer::RenderSystem::CullingMode::GPU;
+        throw std::runtime_error("Unknown culling mode: " + name);
+    }
+
+    // Sorted so the same files are picked on every machine
+    std::vector<std::string> listFiles(const std::string& directory, const std::vector<std::string>& extensions){
+        std::vector<std::string> files;
+        for(const auto& entry : std::filesystem::directory_iterator{directory})
+            if(entry.is_regular_file() && std::find(extensions.begin(), extensions.end(), entry.path().extension().string()) != extensions.end())
+                files.push_back(entry.path().string());
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    // Objects on a jittered cube grid centered on the origin, returns half the grid's size
+    float buildScene(const Options& options, Renderer::Device& device, Renderer::Scene& scene){
+        std::vector<std::string> modelPaths = listFiles(options.assetDirectory + "models", {".obj"});
+        std::vector<std::string> texturePaths = listFiles(options.assetDirectory + "textures", {".png", ".jpg"});
+        if(modelPaths.empty())
+            throw std::runtime_error("No models found in " + options.assetDirectory + "models");
+
+        Renderer::Sampler::SamplerConfig samplerConfig{};
+        samplerConfig.anisotropyEnable = VK_TRUE;
+        samplerConfig.maxAnisotropy = 16.f;
+        samplerConfig.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        samplerConfig.maxLod = 100.f;
+        auto sampler = scene.createSampler(device, samplerConfig);
+
+        // More models or textures than there are files load the same files again as separate assets
+        std::vector<Renderer::Model::Id> models;
+        for(uint32_t i = 0; i < options.modelCount; i++)
+            models.push_back(scene.loadModel(device, modelPaths[i % modelPaths.size()]));
+        std::vector<Renderer::Texture::Id> textures;
+        for(uint32_t i = 0; !texturePaths.empty() && i < options.textureCount; i++)
+            textures.push_back(scene.loadTexture(device, texturePaths[i % texturePaths.size()], sampler));
+
+        std::vector<Renderer::Material::Id> materials;
+        for(uint32_t i = 0; i < options.materialCount; i++){
+            materials.push_back(scene.createMaterial());
+            if(!textures.empty())
+                scene.materials[materials.back()].diffuseTextureIds.push_back(textures[i % textures.size()]);
+        }
+
+        // One mesh per model and material pair that is actually used
+        std::map<std::pair<uint32_t, uint32_t>, Renderer::Mesh::Id> meshes;
+        std::mt19937 rng{options.seed};
+        std::uniform_real_distribution<float> jitter{-0.5f, 0.5f};
+        std::uniform_real_distribution<float> angle{0.f, glm::two_pi<float>()};
+        std::uniform_real_distribution<float> scale{0.5f, 1.5f};
+
+        const float spacing = 3.f;
+        uint32_t side = std::max(static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(options.objectCount)))), 1u);
+        float halfSize = side * spacing * 0.5f;
+        for(uint32_t i = 0; i < options.objectCount; i++){
+            uint32_t model = rng() % options.modelCount, material = rng() % options.materialCount;
+            auto [meshIt, inserted] = meshes.emplace(std::make_pair(model, material), Renderer::Mesh::Id{});
+            if(inserted)
+                meshIt->second = scene.createMesh(models[model], materials[material]);
+
+            glm::vec3 cell{static_cast<float>(i % side), static_cast<float>(i / side % side), static_cast<float>(i / (side * side))};
+            auto object = scene.createObject();
+            auto& transform = scene.objects[object].transform;
+            transform.translation = (cell + 0.5f) * spacing - halfSize + glm::vec3{jitter(rng), jitter(rng), jitter(rng)};
+            transform.rotation = {angle(rng), angle(rng), angle(rng)};
+            transform.scale = glm::vec3{scale(rng)};
+            scene.objects[object].meshIds.push_back(meshIt->second);
+        }
+        return halfSize;
+    }
+
+    // One orbit around the scene over the whole run, bobbing up and down, so culling sees every side of it
+    void updateCamera(Renderer::Camera& camera, float sceneHalfSize, float aspect, uint32_t frame, uint32_t frameCount){
+        float t = static_cast<float>(frame) / frameCount * glm::two_pi<float>();
+        float radius = std::max(sceneHalfSize * 1.5f, 3.f);
+        glm::vec3 position{radius * std::cos(t), sceneHalfSize * 0.5f * std::sin(2.f * t), radius * std::sin(t)};
+        camera.setViewTarget(position, glm::vec3{0.f});
+        camera.setPerspectiveProjection(glm::radians(90.f), aspect, 0.1f, radius * 3.f);
+    }
+
+    // Frame cost of one MSAA tier over the camera path
+    struct MsaaTierResult{
+        VkSampleCountFlagBits samples;
+        double averageMilliseconds;
+        double p95Milliseconds;
+        // GPU time of the Draw pass, where the fill and resolve cost shows up
+        double drawGpuMilliseconds;
+    };
+
+    double percentile(const std::vector<double>& sorted, double fraction){
+        if(sorted.empty())
+            return 0.0;
+        size_t index = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+        return sorted[std::clamp<size_t>(index, 1, sorted.size()) - 1];
+    }
+
+    uint64_t getPeakResidentBytes(){
+#if defined(__APPLE__)
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#elif defined(__unix__)
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#else
+        return 0;
+#endif
+    }
+
+    std::string escape(const std::string& text){
+        std::string escaped;
+        for(char c : text){
+            if(c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    // Reads the JSON this benchmark writes into "path.to.key" -> number, strings and arrays aren't needed for comparisons
+    class FlatJsonReader{
+        public:
+            explicit FlatJsonReader(const std::string& text) : text{text}{}
+
+            std::map<std::string, double> read(){
+                std::map<std::string, double> values;
+                skipWhitespace();
+                readValue("", values);
+                return values;
+            }
+
+        private:
+            void readValue(const std::string& path, std::map<std::string, double>& values){
+                skipWhitespace();
+                if(position >= text.size())
+                    throw std::runtime_error("Unexpected end of JSON.");
+                char c = text[position];
+                if(c == '{'){
+                    position++;
+                    skipWhitespace();
+                    while(position < text.size() && text[position] != '}'){
+                        std::string key = readString();
+                        skipWhitespace();
+                        expect(':');
+                        readValue(path.empty() ? key : path + "." + key, values);
+                        skipWhitespace();
+                        if(text[position] == ',')
+                            position++;
+                        skipWhitespace();
+                    }
+                    expect('}');
+                }
+                else if(c == '['){
+                    position++;
+                    skipWhitespace();
+                    for(uint32_t index = 0; position < text.size() && text[position] != ']'; index++){
+                        readValue(path + "." + std::to_string(index), values);
+                        skipWhitespace();
+                        if(text[position] == ',')
+                            position++;
+                        skipWhitespace();
+                    }
+                    expect(']');
+                }
+                else if(c == '"')
+                    readString();
+                else if(text.compare(position, 4, "true") == 0){
+                    values[path] = 1.0;
+                    position += 4;
+                }
+                else if(text.compare(position, 5, "false") == 0){
+                    values[path] = 0.0;
+                    position += 5;
+                }
+                else if(text.compare(position, 4, "null") == 0)
+                    position += 4;
+                else{
+                    char* end = nullptr;
+                    values[path] = std::strtod(text.c_str() + position, &end);
+                    if(end == text.c_str() + position)
+                        throw std::runtime_error("Invalid JSON value at offset " + std::to_string(position));
+                    position = end - text.c_str();
+                }
+            }
+
+            std::string readString(){
+                expect('"');
+                std::string value;
+                while(position < text.size() && text[position] != '"'){
+                    if(text[position] == '\\')
+                        position++;
+                    value += text[position++];
+                }
+                expect('"');
+                return value;
+            }
+
+            void expect(char c){
+                if(position >= text.size() || text[position] != c)
+                    throw std::runtime_error(std::string("Expected '") + c + "' in JSON at offset " + std::to_string(position));
+                position++;
+            }
+
+            void skipWhitespace(){
+                while(position < text.size() && std::isspace(static_cast<unsigned char>(text[position])))
+                    position++;
+            }
+
+            const std::string& text;
+            size_t position = 0;
+    };
+
+    std::map<std::string, double> readFlatJson(const std::string& text){
+        return FlatJsonReader{text}.read();
+    }
+
+    // Lower is better for every compared metric, tiny absolute differences are treated as noise
+    bool isComparedMetric(const std::string& key){
+        auto endsWith = [&key](const std::string& suffix){ return key.size() >= suffix.size() && key.compare(key.size() - suffix.size(), suffix.size(), suffix) == 0; };
+        if(key == "setupMilliseconds" || key.rfind("frameTimeMs.", 0) == 0)
+            return true;
+        if(key.rfind("draws.", 0) == 0)
+            return key != "draws.exact" && key != "draws.objects";
+        return (key.rfind("cpuZonesMs.", 0) == 0 || key.rfind("gpuZonesMs.", 0) == 0 || key.rfind("msaaTiers.", 0) == 0) && endsWith(".average");
+    }
+
+    uint32_t compareWithBaseline(const std::map<std::string, double>& results, const std::map<std::string, double>& baseline, double tolerance){
+        const double noiseFloor = 0.05;
+        uint32_t regressions = 0;
+        for(const auto& [key, baselineValue] : baseline){
+            auto it = results.find(key);
+            if(!isComparedMetric(key) || it == results.end())
+                continue;
+            double change = baselineValue != 0.0 ? (it->second - baselineValue) / baselineValue : 0.0;
+            bool regressed = it->second > baselineValue * (1.0 + tolerance) && it->second - baselineValue > noiseFloor;
+            regressions += regressed;
+            if(regressed || std::abs(change) > tolerance)
+                std::cout << (regressed ? "REGRESSION " : "improvement ") << key << ": " << baselineValue << " -> " << it->second
+                    << " (" << (change >= 0 ? "+" : "") << change * 100.0 << "%)" << '\n';
+        }
+        return regressions;
+    }
+}
+
+int main(int argc, char** argv){
+    try{
+        Options options = parseOptions(argc, argv);
+
+        Renderer::ThreadPool threadPool{};
+        Renderer::Device device{"renderer_bench_pipeline_cache.bin"};
+        Renderer::SwapChainSettings swapChainSettings{};
+        swapChainSettings.framesInFlight = options.framesInFlight;
+        swapChainSettings.msaaSamples = options.msaaSamples;
+        Renderer::Renderer renderer{device, VkExtent2D{options.width, options.height}, swapChainSettings};
+        Renderer::RenderSystem renderSystem{device, renderer.getSwapChainRenderTarget(), threadPool, renderer.getFramesInFlight()};
+        renderSystem.cullingMode = toCullingMode(options.culling);
+
+        // Asset loading, uploads and pipeline compilation
+        float sceneHalfSize = 0.f;
+        auto setupStart = Clock::now();
+        renderSystem.initializeRenderSystem([&](Renderer::Device& device, Renderer::Scene& scene){
+            sceneHalfSize = buildScene(options, device, scene);
+        });
+        renderSystem.waitForPipelines();
+        double setupMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - setupStart).count();
+
+        // The rolling window only covers the measured frames
+        Renderer::GpuProfiler gpuProfiler{device, renderer.getFramesInFlight(), 32, options.frameCount};
+        Renderer::Camera camera{};
+        std::vector<double> frameTimes;
+        frameTimes.reserve(options.frameCount);
+        Renderer::RenderSystem::DrawStats drawTotals{};
+
+        // Flies the camera path after the warmup frames, calling onMeasuredFrame after each measured frame with its time
+        auto renderPath = [&](Renderer::GpuProfiler& profiler, const std::function<void(double frameTime)>& onMeasuredFrame){
+            auto lastFrameTime = Clock::now();
+            for(uint32_t frame = 0; frame < options.warmupFrames + options.frameCount; frame++){
+                if(frame == options.warmupFrames)
+                    Renderer::CpuProfiler::clear();
+                RENDERER_PROFILE_FRAME();
+
+                // Warmup frames fly the start of the path so the measured run always starts from the same view
+                uint32_t pathFrame = frame < options.warmupFrames ? 0 : frame - options.warmupFrames;
+                updateCamera(camera, sceneHalfSize, renderer.getAspectRatio(), pathFrame, options.frameCount);
+
+                if(auto commandBuffer = renderer.beginFrame()){
+                    int frameIndex = renderer.getFrameIndex();
+                    profiler.beginFrame(commandBuffer, frameIndex);
+                    renderSystem.beginFrame(frameIndex);
+                    renderSystem.updateUniformBuffer(camera, frameIndex);
+                    Renderer::RenderGraph& graph = renderer.getRenderGraph();
+                    auto targets = renderer.importSwapChainTargets();
+                    renderSystem.addPasses(graph, camera, frameIndex, targets.colour, targets.depth, targets.resolve, [&renderer](VkCommandBuffer secondary){
+                        renderer.setViewportAndScissor(secondary);
+                    });
+                    graph.execute(commandBuffer, &profiler);
+                    renderer.endFrame();
+                }
+
+                auto now = Clock::now();
+                if(frame >= options.warmupFrames)
+                    onMeasuredFrame(std::chrono::duration<double, std::milli>(now - lastFrameTime).count());
+                lastFrameTime = now;
+            }
+            vkDeviceWaitIdle(device.getDevice());
+        };
+
+        renderPath(gpuProfiler, [&](double frameTime){
+            frameTimes.push_back(frameTime);
+            const auto& drawStats = renderSystem.getDrawStats();
+            drawTotals.objectCount = drawStats.objectCount;
+            drawTotals.visibleObjectCount += drawStats.visibleObjectCount;
+            drawTotals.drawCommandCount += drawStats.drawCommandCount;
+            drawTotals.modelRunCount += drawStats.modelRunCount;
+            drawTotals.triangleCount += drawStats.triangleCount;
+            drawTotals.exact = drawStats.exact;
+        });
+        VkSampleCountFlagBits mainRunSamples = renderer.getSampleCount();
+
+        std::vector<double> sortedFrameTimes = frameTimes;
+        std::sort(sortedFrameTimes.begin(), sortedFrameTimes.end());
+        double totalFrameTime = 0.0;
+        for(double frameTime : frameTimes)
+            totalFrameTime += frameTime;
+        double frames = static_cast<double>(frameTimes.size());
+        Renderer::Device::MemoryUsage memoryUsage = device.getDeviceLocalMemoryUsage();
+        // Taken before the tier runs, which would otherwise be mixed into the zones and the trace
+        auto cpuZones = Renderer::CpuProfiler::summarizeZones();
+        if(!options.tracePath.empty())
+            Renderer::CpuProfiler::writeChromeTrace(options.tracePath);
+
+        std::vector<MsaaTierResult> msaaTierResults;
+        std::vector<VkSampleCountFlagBits> tiers;
+        if(options.msaaTiers)
+            tiers = {VK_SAMPLE_COUNT_1_BIT, VK_SAMPLE_COUNT_2_BIT, VK_SAMPLE_COUNT_4_BIT, VK_SAMPLE_COUNT_8_BIT};
+        for(VkSampleCountFlagBits samples : tiers){
+            if(samples > device.getMaxUsableSampleCount())
+                break;
+            swapChainSettings.msaaSamples = samples;
+            renderer.setSwapChainSettings(swapChainSettings);
+            renderSystem.setRenderTarget(renderer.getSwapChainRenderTarget());
+            renderSystem.waitForPipelines();
+
+            Renderer::GpuProfiler tierProfiler{device, renderer.getFramesInFlight(), 32, options.frameCount};
+            std::vector<double> tierFrameTimes;
+            tierFrameTimes.reserve(options.frameCount);
+            renderPath(tierProfiler, [&tierFrameTimes](double frameTime){ tierFrameTimes.push_back(frameTime); });
+
+            MsaaTierResult result{samples, 0.0, 0.0, 0.0};
+            for(double frameTime : tierFrameTimes)
+                result.averageMilliseconds += frameTime / tierFrameTimes.size();
+            std::sort(tierFrameTimes.begin(), tierFrameTimes.end());
+            result.p95Milliseconds = percentile(tierFrameTimes, 0.95);
+            for(const auto& zone : tierProfiler.getStats())
+                if(zone.name == "Draw")
+                    result.drawGpuMilliseconds = zone.milliseconds.average;
+            msaaTierResults.push_back(result);
+            std::cout << "MSAA " << samples << "x: " << result.averageMilliseconds << " ms average, " << result.p95Milliseconds 
+                << " ms p95, " << result.drawGpuMilliseconds << " ms GPU draw" << '\n';
+        }
+
+        std::ostringstream json;
+        json << "{\n";
+        json << "  \"config\": {\"objects\": " << options.objectCount << ", \"models\": " << options.modelCount << ", \"materials\": " << options.materialCount
+            << ", \"textures\": " << options.textureCount << ", \"frames\": " << options.frameCount << ", \"warmupFrames\": " << options.warmupFrames
+            << ", \"width\": " << options.width << ", \"height\": " << options.height << ", \"framesInFlight\": " << options.framesInFlight
+            << ", \"culling\": \"" << escape(options.culling) << "\", \"msaa\": " << mainRunSamples << ", \"seed\": " << options.seed << "},\n";
+        json << "  \"device\": \"" << escape(device.getProperties().deviceName) << "\",\n";
+        json << "  \"setupMilliseconds\": " << setupMilliseconds << ",\n";
+        json << "  \"frameTimeMs\": {\"average\": " << totalFrameTime / frames << ", \"p50\": " << percentile(sortedFrameTimes, 0.5)
+            << ", \"p90\": " << percentile(sortedFrameTimes, 0.9) << ", \"p95\": " << percentile(sortedFrameTimes, 0.95)
+            << ", \"p99\": " << percentile(sortedFrameTimes, 0.99) << ", \"max\": " << sortedFrameTimes.back() << "},\n";
+
+        json << "  \"cpuZonesMs\": {";
+        bool first = true;
+        for(const auto& zone : cpuZones){
+            json << (first ? "\n" : ",\n") << "    \"" << escape(zone.name) << "\": {\"average\": " << zone.totalMilliseconds / zone.count
+                << ", \"max\": " << zone.maxMilliseconds << ", \"count\": " << zone.count << "}";
+            first = false;
+        }
+        json << "\n  },\n";
+
+        json << "  \"gpuZonesMs\": {";
+        first = true;
+        for(const auto& zone : gpuProfiler.getStats()){
+            json << (first ? "\n" : ",\n") << "    \"" << escape(zone.name) << "\": {\"average\": " << zone.milliseconds.average
+                << ", \"p95\": " << zone.milliseconds.p95 << ", \"max\": " << zone.milliseconds.max << "}";
+            first = false;
+        }
+        json << "\n  },\n";
+
+        // Per frame averages, upper bounds when exact is false (GPU culling)
+        json << "  \"draws\": {\"objects\": " << drawTotals.objectCount << ", \"visibleObjects\": " << drawTotals.visibleObjectCount / frames
+            << ", \"drawCommands\": " << drawTotals.drawCommandCount / frames << ", \"modelRuns\": " << drawTotals.modelRunCount / frames
+            << ", \"triangles\": " << drawTotals.triangleCount / frames << ", \"exact\": " << (drawTotals.exact ? "true" : "false") << "},\n";
+        if(!msaaTierResults.empty()){
+            json << "  \"msaaTiers\": {";
+            first = true;
+            for(const auto& tier : msaaTierResults){
+                json << (first ? "\n" : ",\n") << "    \"" << tier.samples << "x\": {\"frameTimeMs\": {\"average\": " << tier.averageMilliseconds
+                    << ", \"p95\": " << tier.p95Milliseconds << "}, \"drawGpuMs\": {\"average\": " << tier.drawGpuMilliseconds << "}}";
+                first = false;
+            }
+            json << "\n  },\n";
+        }
+        json << "  \"memory\": {\"deviceLocalUsageBytes\": " << memoryUsage.usage << ", \"deviceLocalBudgetBytes\": " << memoryUsage.budget
+            << ", \"peakResidentBytes\": " << getPeakResidentBytes() << "}\n";
+        json << "}\n";
+
+        std::ofstream output{options.outputPath, std::ios::trunc};
+        if(!output.is_open())
+            throw std::runtime_error("Failed to open output file: " + options.outputPath);
+        output << json.str();
+        output.close();
+        std::cout << json.str() << "Wrote results to " << options.outputPath << '\n';
+
+        if(!options.baselinePath.empty()){
+            std::ifstream baselineFile{options.baselinePath};
+            if(!baselineFile.is_open())
+                throw std::runtime_error("Failed to open baseline file: " + options.baselinePath);
+            std::stringstream baselineText;
+            baselineText << baselineFile.rdbuf();
+
+            uint32_t regressions = compareWithBaseline(readFlatJson(json.str()), readFlatJson(baselineText.str()), options.tolerance);
+            std::cout << regressions << " regression(s) against " << options.baselinePath << " at " << options.tolerance * 100.0 << "% tolerance" << '\n';
+            if(regressions > 0)
+                return 2;
+        }
+    }
+    catch(const std::exception& exception){
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
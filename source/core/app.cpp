@@ -4,15 +4,21 @@
 #include <chrono>
 #include <iostream>
 #include <unordered_map>
+#include <algorithm>
+#include <iterator>
+#include <cstdlib>
+#include <fstream>
 
 #include "engine/systems/render_system/render_system.hpp"
 #include "engine/camera/camera.hpp"
 #include "engine/camera/camera_controller/camera_controller.hpp"
 #include "engine/material/texture/texture.hpp"
 #include "engine/material/sampler/sampler.hpp"
+#include "engine/pipeline/pipeline_cache/pipeline_cache.hpp"
 
 namespace Application{
-    App::App(){
+    App::App(const AppSettings& settings) : appSettings{settings}{
+        renderSystem.assetDirectory = appSettings.assetDirectory;
         renderSystem.initializeRenderSystem();
     }
 
@@ -22,28 +28,70 @@ namespace Application{
         // Camera creation
         Renderer::Camera camera{};
         Renderer::KeyboardMovementController cameraController{};
-        auto viewerObject = Renderer::Object::createObject();
+        Renderer::Object viewerObject{};
         viewerObject.transform.translation.z = -2.5f;
 
+        bool recordingInput = !appSettings.recordInputPath.empty();
+        bool replayingInput = !appSettings.replayInputPath.empty();
+        if(replayingInput){
+            inputRecording = Renderer::InputRecording::load(appSettings.replayInputPath);
+            viewerObject.transform.translation = inputRecording.startTranslation;
+            viewerObject.transform.rotation = inputRecording.startRotation;
+            std::cout << "Replaying " << inputRecording.frames.size() << " frames of input from " << appSettings.replayInputPath << '\n';
+        }
+        else if(recordingInput){
+            inputRecording = {};
+            inputRecording.startTranslation = viewerObject.transform.translation;
+            inputRecording.startRotation = viewerObject.transform.rotation;
+        }
+
         float intervalTime = 0;
         auto currentTime = std::chrono::steady_clock::now();
 
-        while(!window.shouldClose()){
-            glfwPollEvents();
+        if(const char* traceAfter = std::getenv("RENDERER_TRACE_AFTER_FRAMES"))
+            traceAfterFrames = std::strtoull(traceAfter, nullptr, 10);
+
+        auto runStartTime = currentTime;
+        while(appSettings.frameCount == 0 || frameCount < appSettings.frameCount){
+            if(replayingInput && frameCount >= inputRecording.frames.size())
+                break;
+            RENDERER_PROFILE_FRAME();
+            if(window){
+                if(window->shouldClose())
+                    break;
+                glfwPollEvents();
+                handleSwapChainSettingsInput();
+            }
             // Frametime Calculation
             auto newTime = std::chrono::steady_clock::now();
             float frameTime = std::chrono::duration<float, std::chrono::milliseconds::period>(newTime - currentTime).count();
             currentTime = newTime;
+            // frameTime and the swap chain timings both belong to the previous iteration
+            if(frameCount > 0)
+                frameStats.addFrame(frameTime, renderer.getLastFrameTimings());
             intervalTime += frameTime;
             if(intervalTime >= 3000){
-                std::cout << "Frametime: " << frameTime << " ms" << '\n';
+                frameStats.print();
+                gpuProfiler.printStats();
                 intervalTime = 0;
             }
 
             // Camera Setup
             cameraController.moveSpeed = (0.0035f); //TODO: should probably add a "look sensitivity" option, also need to add mouse controls alongside existing keyboard controls
             cameraController.lookSpeed = (0.0035f);
-            cameraController.moveInPlaneXZ(window.getGLFWwindow(), frameTime, viewerObject);
+            Renderer::KeyboardMovementController::Input input = 0;
+            float cameraDelta = frameTime;
+            if(replayingInput){
+                input = inputRecording.frames[frameCount].input;
+                cameraDelta = inputRecording.frames[frameCount].deltaMilliseconds;
+            }
+            else if(window)
+                input = cameraController.readInput(window->getGLFWwindow());
+            if(appSettings.fixedTimestepMilliseconds > 0.f)
+                cameraDelta = appSettings.fixedTimestepMilliseconds;
+            if(recordingInput)
+                inputRecording.frames.push_back({input, cameraDelta});
+            cameraController.move(input, cameraDelta, viewerObject);
             camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
             float aspect = renderer.getAspectRatio();
             camera.setPerspectiveProjection(glm::radians(90.f), aspect, 0.1f, 100.f);
@@ -51,17 +99,110 @@ namespace Application{
             if (auto commandBuffer = renderer.beginFrame()) {
                 int frameIndex = renderer.getFrameIndex();
                 // Update
+                gpuProfiler.beginFrame(commandBuffer, frameIndex);
+                renderSystem.beginFrame(frameIndex);
                 renderSystem.updateUniformBuffer(camera, frameIndex);
-                // Start Renderpass
-                renderer.beginSwapChainRenderPass(commandBuffer);
-                // Draw Objects
-                renderSystem.drawScene(commandBuffer, frameIndex);
-                // End Renderpass
-                renderer.endSwapChainRenderPass(commandBuffer);
+                // Culling and drawing go through the render graph, which times each pass it records
+                Renderer::RenderGraph& graph = renderer.getRenderGraph();
+                auto targets = renderer.importSwapChainTargets();
+                renderSystem.addPasses(graph, camera, frameIndex, targets.colour, targets.depth, targets.resolve, [this](VkCommandBuffer secondary){
+                    renderer.setViewportAndScissor(secondary);
+                });
+                graph.execute(commandBuffer, &gpuProfiler);
                 renderer.endFrame();
             }
+            frameCount++;
+            handleTraceCapture();
+            // Checkpoint the cache once the startup compiles have drained, so a run that never shuts down cleanly still keeps them
+            if(!pipelineCacheCheckpointed && renderSystem.arePipelinesReady()){
+                device.getPipelineCache().save();
+                pipelineCacheCheckpointed = true;
+            }
         }
         vkDeviceWaitIdle(device.getDevice());
+
+        if(recordingInput){
+            inputRecording.save(appSettings.recordInputPath);
+            std::cout << "Recorded " << inputRecording.frames.size() << " frames of input to " << appSettings.recordInputPath << '\n';
+        }
+
+        if(!window){
+            float runTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - runStartTime).count();
+            std::cout << "Rendered " << frameCount << " frames offscreen in " << runTime << " ms" << '\n';
+            frameStats.print();
+            gpuProfiler.printStats();
+            if(!appSettings.capturePath.empty())
+                writeCapture(appSettings.capturePath);
+        }
+    }
+
+    void App::handleSwapChainSettingsInput(){
+        // Acted on when the key goes down, not every frame it is held
+        bool presentModePressed = glfwGetKey(window->getGLFWwindow(), GLFW_KEY_F1) == GLFW_PRESS;
+        bool framesInFlightPressed = glfwGetKey(window->getGLFWwindow(), GLFW_KEY_F2) == GLFW_PRESS;
+        bool msaaPressed = glfwGetKey(window->getGLFWwindow(), GLFW_KEY_F4) == GLFW_PRESS;
+        Renderer::SwapChainSettings settings = renderer.getSwapChainSettings();
+        bool changed = false;
+
+        if(presentModePressed && !presentModeKeyDown){
+            // Lowest latency first, FIFO (vsync) last
+            static constexpr VkPresentModeKHR presentModes[] = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR };
+            size_t current = std::find(std::begin(presentModes), std::end(presentModes), settings.presentMode) - std::begin(presentModes);
+            settings.presentMode = presentModes[(current + 1) % std::size(presentModes)];
+            changed = true;
+        }
+        if(framesInFlightPressed && !framesInFlightKeyDown){
+            settings.framesInFlight = settings.framesInFlight % Renderer::SwapChain::MAX_FRAMES_IN_FLIGHT + 1;
+            changed = true;
+        }
+        if(msaaPressed && !msaaKeyDown){
+            // Off, 2x, 4x, 8x, wrapping around past the device's maximum
+            settings.msaaSamples = renderer.getSampleCount() >= std::min(VK_SAMPLE_COUNT_8_BIT, device.getMaxUsableSampleCount()) ? VK_SAMPLE_COUNT_1_BIT 
+                : static_cast<VkSampleCountFlagBits>(renderer.getSampleCount() << 1);
+            changed = true;
+        }
+        presentModeKeyDown = presentModePressed;
+        framesInFlightKeyDown = framesInFlightPressed;
+        msaaKeyDown = msaaPressed;
+
+        if(changed){
+            renderer.setSwapChainSettings(settings);
+            renderSystem.setFramesInFlight(renderer.getFramesInFlight());
+            renderSystem.setRenderTarget(renderer.getSwapChainRenderTarget());
+            gpuProfiler.setFramesInFlight(renderer.getFramesInFlight());
+            // Percentiles from before the change would hide its effect
+            frameStats.clear();
+            std::cout << "Present mode: " << renderer.getPresentMode() << ", frames in flight: " << renderer.getFramesInFlight() 
+                << ", MSAA: " << renderer.getSampleCount() << "x" << '\n';
+        }
+    }
+
+    void App::handleTraceCapture(){
+        static constexpr const char* tracePath = "cpu_trace.json";
+        if(window){
+            bool tracePressed = glfwGetKey(window->getGLFWwindow(), GLFW_KEY_F3) == GLFW_PRESS;
+            if(tracePressed && !traceKeyDown)
+                Renderer::CpuProfiler::writeChromeTrace(tracePath);
+            traceKeyDown = tracePressed;
+        }
+
+        if(frameCount == traceAfterFrames)
+            Renderer::CpuProfiler::writeChromeTrace(tracePath);
+    }
+
+    void App::writeCapture(const std::string& filepath){
+        std::vector<uint8_t> pixels;
+        renderer.readLastFrame(pixels);
+        VkExtent2D extent = renderer.getExtent();
+
+        std::ofstream file{filepath, std::ios::binary};
+        if(!file.is_open())
+            throw std::runtime_error("Failed to open capture file: " + filepath);
+        // Binary PPM, RGB without alpha
+        file << "P6\n" << extent.width << ' ' << extent.height << "\n255\n";
+        for(size_t i = 0; i < pixels.size(); i += 4)
+            file.write(reinterpret_cast<const char*>(&pixels[i]), 3);
+        std::cout << "Wrote frame capture to " << filepath << '\n';
     }
 
     /*void App::createObjects(){
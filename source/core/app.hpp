@@ -4,26 +4,78 @@
 #include "engine/swap_chain/swap_chain.hpp"
 #include "engine/renderer/renderer.hpp"
 #include "engine/object/object.hpp"
+#include "engine/threading/thread_pool.hpp"
+#include "engine/profiling/gpu_profiler.hpp"
+#include "engine/profiling/cpu_profiler.hpp"
+#include "engine/profiling/frame_stats.hpp"
+#include "engine/input_recording/input_recording.hpp"
 
 #include <vector>
 #include <unordered_map>
+#include <memory>
+#include <string>
 
 namespace Application{
+    struct AppSettings{
+        // Render offscreen without opening a window, for machines without a display
+        bool headless = false;
+        // Frames to render before exiting, 0 runs until the window is closed
+        uint64_t frameCount = 0;
+        // Headless only, the last frame is written here as a binary PPM when set
+        std::string capturePath;
+        // Frames slower than this write a trace of the frames around them to hitches/, 0 disables the captures
+        float hitchThresholdMilliseconds = 50.f;
+        // Camera input of every frame is saved here on exit when set
+        std::string recordInputPath;
+        // Drives the camera from a recording instead of the keyboard and stops when it runs out
+        std::string replayInputPath;
+        // Moves the camera by this instead of the measured frame time when above 0, so runs don't depend on frame rate
+        float fixedTimestepMilliseconds = 0.f;
+        // Directory the scene's models and textures are loaded from, empty uses the one the build was configured with
+        std::string assetDirectory;
+        // Initial swap chain settings, F1, F2 and F4 change them at runtime
+        Renderer::SwapChainSettings swapChain{};
+    };
+
     // Class containing all essential, basic functions and variables needed to run the app
     class App{
         public:
-            App();
+            App(const AppSettings& settings = {});
             ~App();
 
             void run();
             void createObjects();
         private:
+            // F1 cycles the present mode, F2 the number of frames in flight, F4 the MSAA tier
+            void handleSwapChainSettingsInput();
+            // F3 writes the captured CPU zones to cpu_trace.json, as does reaching RENDERER_TRACE_AFTER_FRAMES frames when that is set
+            void handleTraceCapture();
+            void writeCapture(const std::string& filepath);
+
+            AppSettings appSettings;
+
+            // Declared first so worker threads outlive every system that submits work to them
+            Renderer::ThreadPool threadPool{};
 
             VkExtent2D windowExtent = {1280, 720};
-            Renderer::Window window{static_cast<int>(windowExtent.width), static_cast<int>(windowExtent.height), "Renderer View"};
-            Renderer::Device device{window};
-            Renderer::Renderer renderer{device, window};
-            Renderer::RenderSystem renderSystem{device, renderer.getSwapChainRenderPass()};
+            // Null when headless
+            std::unique_ptr<Renderer::Window> window = appSettings.headless ? nullptr 
+                : std::make_unique<Renderer::Window>(static_cast<int>(windowExtent.width), static_cast<int>(windowExtent.height), "Renderer View");
+            Renderer::Device device = window ? Renderer::Device{*window} : Renderer::Device{"pipeline_cache.bin"};
+            Renderer::Renderer renderer = window ? Renderer::Renderer{device, *window, appSettings.swapChain} 
+                : Renderer::Renderer{device, windowExtent, appSettings.swapChain};
+            Renderer::RenderSystem renderSystem{device, renderer.getSwapChainRenderTarget(), threadPool, renderer.getFramesInFlight()};
+            Renderer::GpuProfiler gpuProfiler{device, renderer.getFramesInFlight()};
+            Renderer::FrameStats frameStats{&gpuProfiler, Renderer::FrameStatsSettings{appSettings.hitchThresholdMilliseconds}};
+
+            bool presentModeKeyDown = false, framesInFlightKeyDown = false, msaaKeyDown = false, traceKeyDown = false;
+            uint64_t frameCount = 0;
+            bool pipelineCacheCheckpointed = false;
+            // 0 when RENDERER_TRACE_AFTER_FRAMES isn't set
+            uint64_t traceAfterFrames = 0;
+
+            // Filled while recording, loaded when replaying
+            Renderer::InputRecording inputRecording;
 
             std::shared_ptr<Renderer::Sampler> textureSampler;
     };
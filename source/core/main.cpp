@@ -1,10 +1,55 @@
 #include "app.hpp"
 
 #include <iostream>
+#include <string>
+#include <cstdlib>
 
-int main(){
-    Application::App app{};
+int main(int argc, char** argv){
+    // --headless [--frames N] [--capture frame.ppm] [--hitch-threshold ms] [--record input.bin | --replay input.bin] [--fixed-timestep ms] [--msaa 1|2|4|8] [--assets dir]
+    Application::AppSettings settings{};
+    for(int i = 1; i < argc; i++){
+        std::string argument = argv[i];
+        if(argument == "--headless")
+            settings.headless = true;
+        else if(argument == "--frames" && i + 1 < argc)
+            settings.frameCount = std::strtoull(argv[++i], nullptr, 10);
+        else if(argument == "--capture" && i + 1 < argc)
+            settings.capturePath = argv[++i];
+        else if(argument == "--hitch-threshold" && i + 1 < argc)
+            settings.hitchThresholdMilliseconds = std::strtof(argv[++i], nullptr);
+        else if(argument == "--record" && i + 1 < argc)
+            settings.recordInputPath = argv[++i];
+        else if(argument == "--replay" && i + 1 < argc)
+            settings.replayInputPath = argv[++i];
+        else if(argument == "--fixed-timestep" && i + 1 < argc)
+            settings.fixedTimestepMilliseconds = std::strtof(argv[++i], nullptr);
+        else if(argument == "--msaa" && i + 1 < argc){
+            unsigned long samples = std::strtoul(argv[++i], nullptr, 10);
+            if(samples != 1 && samples != 2 && samples != 4 && samples != 8){
+                std::cerr << "--msaa must be 1, 2, 4 or 8" << '\n';
+                return EXIT_FAILURE;
+            }
+            // The sample count bits are the sample counts
+            settings.swapChain.msaaSamples = static_cast<VkSampleCountFlagBits>(samples);
+        }
+        else if(argument == "--assets" && i + 1 < argc)
+            settings.assetDirectory = std::string{argv[++i]} + "/";
+        else{
+            std::cerr << "Unknown argument: " << argument << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    if(!settings.recordInputPath.empty() && !settings.replayInputPath.empty()){
+        std::cerr << "--record and --replay can't be used together" << '\n';
+        return EXIT_FAILURE;
+    }
+    // There is no window to close, so headless runs always stop on their own, replays stop at the end of the recording
+    if(settings.headless && settings.frameCount == 0 && settings.replayInputPath.empty())
+        settings.frameCount = 1000;
+
+    // Inside the try so a scene or device that fails to load is reported instead of terminating
     try{
+        Application::App app{settings};
         app.run();
     }
     catch(const std::exception &exception){
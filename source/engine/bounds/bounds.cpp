@@ -0,0 +1,127 @@
+#include "bounds.hpp"
+
+#include <algorithm>
+
+namespace Renderer{
+    void AABB::expand(const glm::vec3& point){
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void AABB::expand(const AABB& other){
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    float AABB::surfaceArea() const {
+        if(isEmpty())
+            return 0.f;
+        glm::vec3 size = max - min;
+        return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    bool AABB::contains(const AABB& other) const {
+        return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+            max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+    }
+
+    bool AABB::overlaps(const AABB& other) const {
+        return min.x <= other.max.x && max.x >= other.min.x &&
+            min.y <= other.max.y && max.y >= other.min.y &&
+            min.z <= other.max.z && max.z >= other.min.z;
+    }
+
+    AABB AABB::transformed(const glm::mat4& matrix) const {
+        if(isEmpty())
+            return *this;
+        // Arvo's method: transform the center and project the extent onto each world axis
+        glm::vec3 center = getCenter();
+        glm::vec3 extent = getExtent();
+        glm::vec3 newCenter = glm::vec3(matrix * glm::vec4(center, 1.f));
+        glm::vec3 newExtent{0.f};
+        for(int row = 0; row < 3; row++)
+            for(int column = 0; column < 3; column++)
+                newExtent[row] += glm::abs(matrix[column][row]) * extent[column];
+
+        AABB result;
+        result.min = newCenter - newExtent;
+        result.max = newCenter + newExtent;
+        return result;
+    }
+
+    AABB AABB::merge(const AABB& a, const AABB& b){
+        AABB result = a;
+        result.expand(b);
+        return result;
+    }
+
+    bool BoundingSphere::overlaps(const AABB& box) const {
+        glm::vec3 closest = glm::min(glm::max(center, box.min), box.max);
+        glm::vec3 offset = closest - center;
+        return glm::dot(offset, offset) <= radius * radius;
+    }
+
+    bool Ray::intersects(const AABB& box, float maxDistance, float& hitDistance) const {
+        float tMin = 0.f;
+        float tMax = maxDistance;
+        for(int axis = 0; axis < 3; axis++){
+            float inverseDirection = 1.f / direction[axis]; // Infinity for axis-parallel rays, which the comparisons below handle
+            float t0 = (box.min[axis] - origin[axis]) * inverseDirection;
+            float t1 = (box.max[axis] - origin[axis]) * inverseDirection;
+            if(t0 > t1)
+                std::swap(t0, t1);
+            tMin = std::max(tMin, t0);
+            tMax = std::min(tMax, t1);
+            if(tMin > tMax)
+                return false;
+        }
+        hitDistance = tMin;
+        return true;
+    }
+
+    Frustum Frustum::fromMatrix(const glm::mat4& viewProjection){
+        // Gribb/Hartmann plane extraction, glm is column-major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+        auto row = [&viewProjection](int i){
+            return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        };
+
+        Frustum frustum;
+        frustum.planes[0] = row(3) + row(0);    // Left
+        frustum.planes[1] = row(3) - row(0);    // Right
+        frustum.planes[2] = row(3) + row(1);    // Bottom
+        frustum.planes[3] = row(3) - row(1);    // Top
+        frustum.planes[4] = row(2);             // Near (depth range is [0, 1])
+        frustum.planes[5] = row(3) - row(2);    // Far
+
+        for(auto& plane : frustum.planes)
+            plane = plane / glm::length(glm::vec3(plane.x, plane.y, plane.z));
+        return frustum;
+    }
+
+    bool Frustum::overlaps(const BoundingSphere& sphere) const {
+        for(const auto& plane : planes)
+            if(glm::dot(glm::vec3(plane.x, plane.y, plane.z), sphere.center) + plane.w < -sphere.radius)
+                return false;
+        return true;
+    }
+
+    bool Frustum::overlaps(const AABB& box) const {
+        return classify(box) != Containment::Outside;
+    }
+
+    Frustum::Containment Frustum::classify(const AABB& box) const {
+        glm::vec3 center = box.getCenter();
+        glm::vec3 extent = box.getExtent();
+        Containment result = Containment::Inside;
+        for(const auto& plane : planes){
+            glm::vec3 normal{plane.x, plane.y, plane.z};
+            float distance = glm::dot(normal, center) + plane.w;
+            float projectedExtent = glm::dot(extent, glm::abs(normal));
+            if(distance < -projectedExtent)
+                return Containment::Outside;
+            if(distance < projectedExtent)
+                result = Containment::Intersecting;
+        }
+        return result;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <limits>
+
+namespace Renderer{
+    // Axis-aligned bounding box, an empty box has min > max so that expanding it by any point gives that point.
+    struct AABB{
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{-std::numeric_limits<float>::max()};
+
+        bool isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+        glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+        glm::vec3 getExtent() const { return (max - min) * 0.5f; }
+
+        void expand(const glm::vec3& point);
+        void expand(const AABB& other);
+        float surfaceArea() const;
+        bool contains(const AABB& other) const;
+        bool overlaps(const AABB& other) const;
+
+        // Bounds of this box after being transformed by the given matrix (still axis-aligned, so possibly larger)
+        AABB transformed(const glm::mat4& matrix) const;
+
+        static AABB merge(const AABB& a, const AABB& b);
+    };
+
+    struct BoundingSphere{
+        glm::vec3 center{0.f};
+        float radius = 0.f;
+
+        bool overlaps(const AABB& box) const;
+    };
+
+    struct Ray{
+        glm::vec3 origin{0.f};
+        glm::vec3 direction{0.f, 0.f, 1.f};
+
+        // Slab test, returns the entry distance along the ray in hitDistance if the box is hit within maxDistance
+        bool intersects(const AABB& box, float maxDistance, float& hitDistance) const;
+    };
+
+    // Six planes (left, right, bottom, top, near, far) with normals pointing inwards, stored as (normal, distance)
+    struct Frustum{
+        enum class Containment{ Outside, Intersecting, Inside };
+
+        glm::vec4 planes[6];
+
+        // Extracts planes from a projection * view matrix using Vulkan's [0, 1] depth range
+        static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+        bool overlaps(const BoundingSphere& sphere) const;
+        bool overlaps(const AABB& box) const;
+        Containment classify(const AABB& box) const;
+    };
+}
\ No newline at end of file
@@ -52,7 +52,7 @@ namespace Renderer{
         }
     }
 
-    void Buffer::writeToBuffer(void *data, VkDeviceSize size, VkDeviceSize offset){
+    void Buffer::writeToBuffer(const void *data, VkDeviceSize size, VkDeviceSize offset){
         assert(mapped && "Cannot copy to unmapped buffer.");
         if (size == VK_WHOLE_SIZE)
             memcpy(mapped, data, bufferSize);
@@ -14,11 +14,12 @@ namespace Renderer{
 
             VkBuffer getBuffer(){ return buffer; }
             VkDeviceSize getSize() { return bufferSize; }
+            void* getMappedMemory() { return mapped; }
 
             VkResult map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
             void unmap();
             
-            void writeToBuffer(void *data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+            void writeToBuffer(const void *data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
             void copyBuffer(VkBuffer dstBuffer, VkDeviceSize size);
             void copyBufferToImage(VkImage image, uint32_t width, uint32_t height);
             VkDescriptorBufferInfo descriptorInfo(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
@@ -0,0 +1,370 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Renderer{
+    BVH::BVH() : BVH(BuildSettings{}) {}
+
+    BVH::BVH(BuildSettings settings) : settings{settings} {}
+
+    int32_t BVH::allocateNode(){
+        if(freeList == nullNode){
+            nodes.emplace_back();
+            return static_cast<int32_t>(nodes.size() - 1);
+        }
+        int32_t nodeId = freeList;
+        freeList = nodes[nodeId].parent;
+        nodes[nodeId] = Node{};
+        return nodeId;
+    }
+
+    void BVH::freeNode(int32_t nodeId){
+        nodes[nodeId].parent = freeList;
+        nodes[nodeId].height = -1;
+        freeList = nodeId;
+    }
+
+    int32_t BVH::createProxy(const AABB& bounds, uint64_t userData){
+        int32_t proxyId = allocateNode();
+        glm::vec3 margin{settings.fatMargin};
+        nodes[proxyId].bounds.min = bounds.min - margin;
+        nodes[proxyId].bounds.max = bounds.max + margin;
+        nodes[proxyId].userData = userData;
+        nodes[proxyId].height = 0;
+        insertLeaf(proxyId);
+        proxyCount++;
+        return proxyId;
+    }
+
+    void BVH::destroyProxy(int32_t proxyId){
+        assert(proxyId >= 0 && proxyId < static_cast<int32_t>(nodes.size()) && nodes[proxyId].isLeaf() && "Invalid BVH proxy.");
+        removeLeaf(proxyId);
+        freeNode(proxyId);
+        proxyCount--;
+    }
+
+    bool BVH::moveProxy(int32_t proxyId, const AABB& bounds){
+        assert(proxyId >= 0 && proxyId < static_cast<int32_t>(nodes.size()) && nodes[proxyId].isLeaf() && "Invalid BVH proxy.");
+        Node& leaf = nodes[proxyId];
+        if(leaf.bounds.contains(bounds))
+            return false;
+
+        glm::vec3 margin{settings.fatMargin};
+        AABB fatBounds;
+        fatBounds.min = bounds.min - margin;
+        fatBounds.max = bounds.max + margin;
+
+        // Objects that jumped further than their own size would drag their whole branch with them, reinsert those instead
+        glm::vec3 displacement = glm::abs(fatBounds.getCenter() - leaf.bounds.getCenter());
+        glm::vec3 size = leaf.bounds.max - leaf.bounds.min;
+        if(displacement.x > size.x || displacement.y > size.y || displacement.z > size.z){
+            removeLeaf(proxyId);
+            nodes[proxyId].bounds = fatBounds;
+            insertLeaf(proxyId);
+            return true;
+        }
+
+        leaf.bounds = fatBounds;
+        refitAncestors(leaf.parent, false);
+        refitsSinceBuild++;
+        return true;
+    }
+
+    void BVH::insertLeaf(int32_t leaf){
+        if(root == nullNode){
+            root = leaf;
+            nodes[root].parent = nullNode;
+            return;
+        }
+
+        // Descend towards the sibling that minimises the increase in surface area (Box2D style branch selection)
+        AABB leafBounds = nodes[leaf].bounds;
+        int32_t index = root;
+        while(!nodes[index].isLeaf()){
+            int32_t child1 = nodes[index].child1;
+            int32_t child2 = nodes[index].child2;
+
+            float area = nodes[index].bounds.surfaceArea();
+            float combinedArea = AABB::merge(nodes[index].bounds, leafBounds).surfaceArea();
+
+            // Cost of making a new parent for this node and the new leaf
+            float cost = 2.f * combinedArea;
+            // Minimum cost of pushing the leaf further down the tree
+            float inheritanceCost = 2.f * (combinedArea - area);
+
+            auto descendCost = [&](int32_t child){
+                float mergedArea = AABB::merge(leafBounds, nodes[child].bounds).surfaceArea();
+                if(nodes[child].isLeaf())
+                    return mergedArea + inheritanceCost;
+                return mergedArea - nodes[child].bounds.surfaceArea() + inheritanceCost;
+            };
+            float cost1 = descendCost(child1);
+            float cost2 = descendCost(child2);
+
+            if(cost < cost1 && cost < cost2)
+                break;
+            index = cost1 < cost2 ? child1 : child2;
+        }
+        int32_t sibling = index;
+
+        int32_t oldParent = nodes[sibling].parent;
+        int32_t newParent = allocateNode();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].bounds = AABB::merge(leafBounds, nodes[sibling].bounds);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+
+        if(oldParent != nullNode){
+            if(nodes[oldParent].child1 == sibling)
+                nodes[oldParent].child1 = newParent;
+            else
+                nodes[oldParent].child2 = newParent;
+        }
+        else
+            root = newParent;
+
+        refitAncestors(nodes[leaf].parent, true);
+    }
+
+    void BVH::removeLeaf(int32_t leaf){
+        if(leaf == root){
+            root = nullNode;
+            return;
+        }
+
+        int32_t parent = nodes[leaf].parent;
+        int32_t grandParent = nodes[parent].parent;
+        int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        if(grandParent != nullNode){
+            // Replace the parent with the sibling and fix up the branch above it
+            if(nodes[grandParent].child1 == parent)
+                nodes[grandParent].child1 = sibling;
+            else
+                nodes[grandParent].child2 = sibling;
+            nodes[sibling].parent = grandParent;
+            freeNode(parent);
+            refitAncestors(grandParent, true);
+        }
+        else{
+            root = sibling;
+            nodes[sibling].parent = nullNode;
+            freeNode(parent);
+        }
+    }
+
+    void BVH::refitAncestors(int32_t nodeId, bool rebalance){
+        while(nodeId != nullNode){
+            if(rebalance)
+                nodeId = balance(nodeId);
+
+            Node& node = nodes[nodeId];
+            const Node& child1 = nodes[node.child1];
+            const Node& child2 = nodes[node.child2];
+            AABB newBounds = AABB::merge(child1.bounds, child2.bounds);
+            int32_t newHeight = 1 + std::max(child1.height, child2.height);
+
+            // Nothing above can change once a node's bounds and height are unchanged
+            if(!rebalance && newHeight == node.height && newBounds.min == node.bounds.min && newBounds.max == node.bounds.max)
+                return;
+            node.bounds = newBounds;
+            node.height = newHeight;
+            nodeId = node.parent;
+        }
+    }
+
+    // Performs a left or right rotation if the subtree rooted at nodeId is imbalanced, returns the new subtree root
+    int32_t BVH::balance(int32_t iA){
+        Node& A = nodes[iA];
+        if(A.isLeaf() || A.height < 2)
+            return iA;
+
+        int32_t iB = A.child1;
+        int32_t iC = A.child2;
+        int32_t heightDifference = nodes[iC].height - nodes[iB].height;
+
+        // Rotate C up (or B up in the mirrored case)
+        auto rotate = [this, iA](int32_t iUp, int32_t iOther, bool upIsChild2){
+            Node& A = nodes[iA];
+            Node& up = nodes[iUp];
+            int32_t iF = up.child1;
+            int32_t iG = up.child2;
+
+            up.child1 = iA;
+            up.parent = A.parent;
+            A.parent = iUp;
+
+            if(up.parent != nullNode){
+                if(nodes[up.parent].child1 == iA)
+                    nodes[up.parent].child1 = iUp;
+                else
+                    nodes[up.parent].child2 = iUp;
+            }
+            else
+                root = iUp;
+
+            // Keep the taller grandchild beside A and move the shorter one under A
+            int32_t iKeep = nodes[iF].height > nodes[iG].height ? iF : iG;
+            int32_t iMove = iKeep == iF ? iG : iF;
+            up.child2 = iKeep;
+            if(upIsChild2)
+                A.child2 = iMove;
+            else
+                A.child1 = iMove;
+            nodes[iMove].parent = iA;
+
+            A.bounds = AABB::merge(nodes[iOther].bounds, nodes[iMove].bounds);
+            up.bounds = AABB::merge(A.bounds, nodes[iKeep].bounds);
+            A.height = 1 + std::max(nodes[iOther].height, nodes[iMove].height);
+            up.height = 1 + std::max(A.height, nodes[iKeep].height);
+            return iUp;
+        };
+
+        if(heightDifference > 1)
+            return rotate(iC, iB, true);
+        if(heightDifference < -1)
+            return rotate(iB, iC, false);
+        return iA;
+    }
+
+    float BVH::getAreaCost() const {
+        if(root == nullNode)
+            return 0.f;
+        float rootArea = nodes[root].bounds.surfaceArea();
+        if(rootArea <= 0.f)
+            return 0.f;
+        float totalArea = 0.f;
+        for(const auto& node : nodes)
+            if(node.height > 0)
+                totalArea += node.bounds.surfaceArea();
+        return totalArea / rootArea;
+    }
+
+    bool BVH::shouldRebuild() const {
+        if(proxyCount < 2 || refitsSinceBuild == 0)
+            return false;
+        if(refitsSinceBuild >= proxyCount * settings.rebuildRefitFraction)
+            return true;
+        return getAreaCost() > costAtLastBuild * settings.rebuildCostRatio;
+    }
+
+    void BVH::rebuild(){
+        // Gather the leaves and release every internal node, leaves keep their indices so proxy IDs stay valid
+        std::vector<int32_t> leaves;
+        leaves.reserve(proxyCount);
+        for(int32_t i = 0; i < static_cast<int32_t>(nodes.size()); i++){
+            if(nodes[i].height < 0)
+                continue;
+            if(nodes[i].isLeaf())
+                leaves.push_back(i);
+            else
+                freeNode(i);
+        }
+
+        root = leaves.empty() ? nullNode : buildRecursive(leaves.data(), static_cast<int32_t>(leaves.size()));
+        if(root != nullNode)
+            nodes[root].parent = nullNode;
+
+        costAtLastBuild = getAreaCost();
+        refitsSinceBuild = 0;
+    }
+
+    int32_t BVH::buildRecursive(int32_t* leaves, int32_t count){
+        if(count == 1)
+            return leaves[0];
+
+        // Bin leaf centroids along the widest axis of the centroid bounds
+        AABB centroidBounds;
+        for(int32_t i = 0; i < count; i++)
+            centroidBounds.expand(nodes[leaves[i]].bounds.getCenter());
+        glm::vec3 centroidSize = centroidBounds.max - centroidBounds.min;
+        int axis = 0;
+        if(centroidSize.y > centroidSize[axis]) axis = 1;
+        if(centroidSize.z > centroidSize[axis]) axis = 2;
+
+        int32_t splitCount = count / 2;
+        if(centroidSize[axis] > 0.f){
+            constexpr int binCount = 16;
+            AABB binBounds[binCount];
+            int32_t binLeafCounts[binCount] = {};
+            float binScale = binCount / centroidSize[axis];
+            auto binIndex = [&](int32_t leaf){
+                int bin = static_cast<int>((nodes[leaf].bounds.getCenter()[axis] - centroidBounds.min[axis]) * binScale);
+                return std::min(bin, binCount - 1);
+            };
+            for(int32_t i = 0; i < count; i++){
+                int bin = binIndex(leaves[i]);
+                binBounds[bin].expand(nodes[leaves[i]].bounds);
+                binLeafCounts[bin]++;
+            }
+
+            // Sweep from the right to get the area and count of every possible right-hand side
+            float rightAreas[binCount - 1];
+            AABB rightBounds;
+            int32_t rightCount = 0;
+            int32_t rightCounts[binCount - 1];
+            for(int i = binCount - 1; i > 0; i--){
+                rightBounds.expand(binBounds[i]);
+                rightCount += binLeafCounts[i];
+                rightAreas[i - 1] = rightBounds.surfaceArea();
+                rightCounts[i - 1] = rightCount;
+            }
+
+            // Then from the left to find the split with the lowest SAH cost
+            AABB leftBounds;
+            int32_t leftCount = 0;
+            float bestCost = std::numeric_limits<float>::max();
+            int bestSplit = -1;
+            for(int i = 0; i < binCount - 1; i++){
+                leftBounds.expand(binBounds[i]);
+                leftCount += binLeafCounts[i];
+                if(leftCount == 0 || rightCounts[i] == 0)
+                    continue;
+                float cost = leftBounds.surfaceArea() * leftCount + rightAreas[i] * rightCounts[i];
+                if(cost < bestCost){
+                    bestCost = cost;
+                    bestSplit = i;
+                }
+            }
+
+            if(bestSplit >= 0){
+                int32_t* middle = std::partition(leaves, leaves + count, [&](int32_t leaf){ return binIndex(leaf) <= bestSplit; });
+                splitCount = static_cast<int32_t>(middle - leaves);
+            }
+        }
+
+        // All centroids coincide or binning failed to separate them, fall back to a median split
+        if(splitCount == 0 || splitCount == count){
+            splitCount = count / 2;
+            std::nth_element(leaves, leaves + splitCount, leaves + count, [&](int32_t a, int32_t b){
+                return nodes[a].bounds.getCenter()[axis] < nodes[b].bounds.getCenter()[axis];
+            });
+        }
+
+        int32_t child1 = buildRecursive(leaves, splitCount);
+        int32_t child2 = buildRecursive(leaves + splitCount, count - splitCount);
+
+        int32_t nodeId = allocateNode();
+        Node& node = nodes[nodeId];
+        node.child1 = child1;
+        node.child2 = child2;
+        node.bounds = AABB::merge(nodes[child1].bounds, nodes[child2].bounds);
+        node.height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[child1].parent = nodeId;
+        nodes[child2].parent = nodeId;
+        return nodeId;
+    }
+
+    void BVH::clear(){
+        nodes.clear();
+        root = nullNode;
+        freeList = nullNode;
+        proxyCount = 0;
+        costAtLastBuild = 0.f;
+        refitsSinceBuild = 0;
+    }
+}
\ No newline at end of file
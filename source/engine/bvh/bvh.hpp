@@ -0,0 +1,157 @@
+#pragma once
+
+#include "engine/bounds/bounds.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace Renderer{
+    // Dynamic AABB tree. Leaves store a fattened copy of the bounds they were given so that small movements don't touch the tree,
+    // inserts pick their sibling with a surface area heuristic and larger movements refit the affected ancestors in place.
+    // Refitting slowly degrades the tree, shouldRebuild() tells when a full top-down binned SAH rebuild is worth its cost.
+    // Proxy IDs are leaf node indices and stay valid across rebuilds.
+    class BVH{
+        public:
+            static constexpr int32_t nullNode = -1;
+
+            struct BuildSettings{
+                float fatMargin = 0.1f;             // Added to every side of a leaf's bounds
+                float rebuildCostRatio = 1.5f;      // Rebuild once the SAH cost has grown by this factor since the last build
+                float rebuildRefitFraction = 0.5f;  // Rebuild once this fraction of the leaves has been refit since the last build
+            };
+
+            BVH();
+            BVH(BuildSettings settings);
+
+            int32_t createProxy(const AABB& bounds, uint64_t userData);
+            void destroyProxy(int32_t proxyId);
+            // Returns false if the new bounds still fit inside the proxy's fattened bounds and the tree was left untouched.
+            bool moveProxy(int32_t proxyId, const AABB& bounds);
+
+            uint64_t getUserData(int32_t proxyId) const { return nodes[proxyId].userData; }
+            const AABB& getFatBounds(int32_t proxyId) const { return nodes[proxyId].bounds; }
+            uint32_t getProxyCount() const { return proxyCount; }
+            int32_t getHeight() const { return root == nullNode ? 0 : nodes[root].height; }
+
+            // Sum of internal node areas relative to the root's, proportional to the expected cost of a query. O(n).
+            float getAreaCost() const;
+            bool shouldRebuild() const;
+            void rebuild();
+
+            void clear();
+
+            // Callbacks receive the proxy ID (and the entry distance for rays) and return false to stop the query early.
+            template<typename Callback>
+            void queryBox(const AABB& box, Callback&& callback) const;
+            template<typename Callback>
+            void querySphere(const BoundingSphere& sphere, Callback&& callback) const;
+            template<typename Callback>
+            void queryFrustum(const Frustum& frustum, Callback&& callback) const;
+            template<typename Callback>
+            void queryRay(const Ray& ray, float maxDistance, Callback&& callback) const;
+
+        private:
+            struct Node{
+                AABB bounds{};
+                uint64_t userData = 0;
+                int32_t parent = nullNode;  // Next free node while on the free list
+                int32_t child1 = nullNode;
+                int32_t child2 = nullNode;
+                int32_t height = 0;         // 0 for leaves, -1 for free nodes
+
+                bool isLeaf() const { return child1 == nullNode; }
+            };
+
+            int32_t allocateNode();
+            void freeNode(int32_t nodeId);
+
+            void insertLeaf(int32_t leaf);
+            void removeLeaf(int32_t leaf);
+            void refitAncestors(int32_t nodeId, bool rebalance);
+            int32_t balance(int32_t nodeId);
+            int32_t buildRecursive(int32_t* leaves, int32_t count);
+
+            template<typename Overlaps, typename Callback>
+            void query(Overlaps&& overlaps, Callback&& callback) const;
+
+            BuildSettings settings;
+
+            std::vector<Node> nodes;
+            int32_t root = nullNode;
+            int32_t freeList = nullNode;
+            uint32_t proxyCount = 0;
+
+            float costAtLastBuild = 0.f;
+            uint32_t refitsSinceBuild = 0;
+    };
+
+    template<typename Overlaps, typename Callback>
+    void BVH::query(Overlaps&& overlaps, Callback&& callback) const {
+        if(root == nullNode)
+            return;
+        std::vector<int32_t> stack;
+        stack.reserve(64);
+        stack.push_back(root);
+        while(!stack.empty()){
+            int32_t nodeId = stack.back();
+            stack.pop_back();
+            const Node& node = nodes[nodeId];
+            if(!overlaps(node.bounds))
+                continue;
+            if(node.isLeaf()){
+                if(!callback(nodeId))
+                    return;
+            }
+            else{
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+    }
+
+    template<typename Callback>
+    void BVH::queryBox(const AABB& box, Callback&& callback) const {
+        query([&box](const AABB& bounds){ return box.overlaps(bounds); }, callback);
+    }
+
+    template<typename Callback>
+    void BVH::querySphere(const BoundingSphere& sphere, Callback&& callback) const {
+        query([&sphere](const AABB& bounds){ return sphere.overlaps(bounds); }, callback);
+    }
+
+    template<typename Callback>
+    void BVH::queryRay(const Ray& ray, float maxDistance, Callback&& callback) const {
+        float hitDistance = 0.f;
+        query([&](const AABB& bounds){ return ray.intersects(bounds, maxDistance, hitDistance); },
+            [&](int32_t proxyId){ return callback(proxyId, hitDistance); });
+    }
+
+    template<typename Callback>
+    void BVH::queryFrustum(const Frustum& frustum, Callback&& callback) const {
+        if(root == nullNode)
+            return;
+        // Each stack entry carries whether its parent was already fully inside, in which case no more plane tests are needed
+        std::vector<std::pair<int32_t, bool>> stack;
+        stack.reserve(64);
+        stack.push_back({root, false});
+        while(!stack.empty()){
+            auto [nodeId, inside] = stack.back();
+            stack.pop_back();
+            const Node& node = nodes[nodeId];
+            if(!inside){
+                auto containment = frustum.classify(node.bounds);
+                if(containment == Frustum::Containment::Outside)
+                    continue;
+                inside = containment == Frustum::Containment::Inside;
+            }
+            if(node.isLeaf()){
+                if(!callback(nodeId))
+                    return;
+            }
+            else{
+                stack.push_back({node.child1, inside});
+                stack.push_back({node.child2, inside});
+            }
+        }
+    }
+}
\ No newline at end of file
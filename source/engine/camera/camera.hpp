@@ -4,6 +4,8 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include "engine/bounds/bounds.hpp"
+
 namespace Renderer{
     class Camera{
         public:
@@ -17,6 +19,7 @@ namespace Renderer{
             const glm::mat4& getView() const { return viewMatrix; }
             const glm::mat4& getInverseView() const { return inverseViewMatrix; }
             const glm::vec3 getPosition() const { return glm::vec3(inverseViewMatrix[3]); }
+            Frustum getFrustum() const { return Frustum::fromMatrix(projectionMatrix * viewMatrix); }
 
             bool enableFrustumCulling = true;
 
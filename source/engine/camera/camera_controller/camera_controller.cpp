@@ -1,15 +1,27 @@
 #include "camera_controller.hpp"
 
 #include <limits>
+#include <utility>
 
 namespace Renderer{
-    void KeyboardMovementController::moveInPlaneXZ(
-        GLFWwindow* window, float dt, Object& object) {
+    KeyboardMovementController::Input KeyboardMovementController::readInput(GLFWwindow* window) const {
+        const std::pair<int, Action> bindings[] = {
+            {keys.moveLeft, MoveLeft}, {keys.moveRight, MoveRight}, {keys.moveForward, MoveForward}, {keys.moveBackward, MoveBackward},
+            {keys.moveUp, MoveUp}, {keys.moveDown, MoveDown}, {keys.lookLeft, LookLeft}, {keys.lookRight, LookRight},
+            {keys.lookUp, LookUp}, {keys.lookDown, LookDown}
+        };
+        Input input = 0;
+        for (const auto& [key, action] : bindings)
+            if (glfwGetKey(window, key) == GLFW_PRESS) input |= action;
+        return input;
+    }
+
+    void KeyboardMovementController::move(Input input, float dt, Object& object) const {
         glm::vec3 rotate{0};
-        if (glfwGetKey(window, keys.lookRight) == GLFW_PRESS) rotate.y += 1.f;
-        if (glfwGetKey(window, keys.lookLeft) == GLFW_PRESS) rotate.y -= 1.f;
-        if (glfwGetKey(window, keys.lookUp) == GLFW_PRESS) rotate.x += 1.f;
-        if (glfwGetKey(window, keys.lookDown) == GLFW_PRESS) rotate.x -= 1.f;
+        if (input & LookRight) rotate.y += 1.f;
+        if (input & LookLeft) rotate.y -= 1.f;
+        if (input & LookUp) rotate.x += 1.f;
+        if (input & LookDown) rotate.x -= 1.f;
 
         if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon()) {
           object.transform.rotation += lookSpeed * dt * glm::normalize(rotate);
@@ -25,14 +37,19 @@ namespace Renderer{
         const glm::vec3 upDir{0.f, -1.f, 0.f};
 
         glm::vec3 moveDir{0.f};
-        if (glfwGetKey(window, keys.moveForward) == GLFW_PRESS) moveDir += forwardDir;
-        if (glfwGetKey(window, keys.moveBackward) == GLFW_PRESS) moveDir -= forwardDir;
-        if (glfwGetKey(window, keys.moveRight) == GLFW_PRESS) moveDir += rightDir;
-        if (glfwGetKey(window, keys.moveLeft) == GLFW_PRESS) moveDir -= rightDir;
-        if (glfwGetKey(window, keys.moveUp) == GLFW_PRESS) moveDir += upDir;
-        if (glfwGetKey(window, keys.moveDown) == GLFW_PRESS) moveDir -= upDir;
+        if (input & MoveForward) moveDir += forwardDir;
+        if (input & MoveBackward) moveDir -= forwardDir;
+        if (input & MoveRight) moveDir += rightDir;
+        if (input & MoveLeft) moveDir -= rightDir;
+        if (input & MoveUp) moveDir += upDir;
+        if (input & MoveDown) moveDir -= upDir;
 
         if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon())
           object.transform.translation += moveSpeed * dt * glm::normalize(moveDir);
     }
+
+    void KeyboardMovementController::moveInPlaneXZ(
+        GLFWwindow* window, float dt, Object& object) {
+        move(readInput(window), dt, object);
+    }
 }
\ No newline at end of file
@@ -19,6 +19,24 @@ namespace Renderer{
             int lookDown = GLFW_KEY_DOWN;
         };
 
+        // One bit per held action, kept separate from the keys so input can be recorded and replayed
+        enum Action : uint16_t {
+            MoveLeft = 1 << 0,
+            MoveRight = 1 << 1,
+            MoveForward = 1 << 2,
+            MoveBackward = 1 << 3,
+            MoveUp = 1 << 4,
+            MoveDown = 1 << 5,
+            LookLeft = 1 << 6,
+            LookRight = 1 << 7,
+            LookUp = 1 << 8,
+            LookDown = 1 << 9
+        };
+        using Input = uint16_t;
+
+        Input readInput(GLFWwindow* window) const;
+        // Only depends on its arguments, so the same inputs and deltas always produce the same path
+        void move(Input input, float dt, Object& object) const;
         void moveInPlaneXZ(GLFWwindow* window, float dt, Object& object);
 
         KeyMappings keys{};
@@ -0,0 +1,144 @@
+#include "cpu_culler.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    // GCC/Clang (including MinGW) can compile the AVX2 path for this function only and pick it at runtime
+    #define CULLING_HAS_AVX2_PATH
+    #define CULLING_AVX2_TARGET __attribute__((target("avx2,fma")))
+    #include <immintrin.h>
+#elif defined(__AVX2__)
+    #define CULLING_HAS_AVX2_PATH
+    #define CULLING_AVX2_TARGET
+    #include <immintrin.h>
+#endif
+
+#include <cmath>
+#include <algorithm>
+
+namespace Renderer{
+    CpuCuller::CpuCuller(ThreadPool& threadPool) : threadPool{threadPool}, useAvx2{supportsAvx2()} {}
+
+    bool CpuCuller::supportsAvx2(){
+    #if defined(CULLING_HAS_AVX2_PATH) && defined(__GNUC__)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    #elif defined(CULLING_HAS_AVX2_PATH)
+        return true;
+    #else
+        return false;
+    #endif
+    }
+
+    void CpuCuller::resize(uint32_t count){
+        for(auto* array : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radius})
+            array->resize(count, 0.f);
+    }
+
+    void CpuCuller::setBounds(uint32_t index, const AABB& bounds){
+        glm::vec3 center = bounds.getCenter();
+        glm::vec3 extent = bounds.getExtent();
+        centerX[index] = center.x;
+        centerY[index] = center.y;
+        centerZ[index] = center.z;
+        extentX[index] = extent.x;
+        extentY[index] = extent.y;
+        extentZ[index] = extent.z;
+        radius[index] = glm::length(extent);
+    }
+
+    void CpuCuller::cull(const Frustum& frustum, std::vector<uint32_t>& visibleIndices){
+        visibleIndices.clear();
+        uint32_t count = getCount();
+        if(count < parallelThreshold){
+            cullRange(frustum, 0, count, visibleIndices);
+            return;
+        }
+
+        // Fixed batch boundaries (multiples of 8) so every batch has its own output list and the result stays ordered
+        constexpr uint32_t batchSize = 8192;
+        uint32_t batchCount = (count + batchSize - 1) / batchSize;
+        batchResults.resize(batchCount);
+        threadPool.parallelFor(batchCount, 1, [&](uint32_t beginBatch, uint32_t endBatch){
+            for(uint32_t batch = beginBatch; batch < endBatch; batch++){
+                batchResults[batch].clear();
+                cullRange(frustum, batch * batchSize, std::min((batch + 1) * batchSize, count), batchResults[batch]);
+            }
+        });
+
+        for(const auto& batch : batchResults)
+            visibleIndices.insert(visibleIndices.end(), batch.begin(), batch.end());
+    }
+
+    void CpuCuller::cullRange(const Frustum& frustum, uint32_t begin, uint32_t end, std::vector<uint32_t>& visibleIndices) const {
+        if(useAvx2)
+            cullRangeAvx2(frustum, begin, end, visibleIndices);
+        else
+            cullRangeScalar(frustum, begin, end, visibleIndices);
+    }
+
+    void CpuCuller::cullRangeScalar(const Frustum& frustum, uint32_t begin, uint32_t end, std::vector<uint32_t>& visibleIndices) const {
+        for(uint32_t i = begin; i < end; i++){
+            bool visible = true;
+            for(const auto& plane : frustum.planes){
+                float distance = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+                float projectedExtent = std::fabs(plane.x) * extentX[i] + std::fabs(plane.y) * extentY[i] + std::fabs(plane.z) * extentZ[i];
+                if(distance < -radius[i] || distance < -projectedExtent){
+                    visible = false;
+                    break;
+                }
+            }
+            if(visible)
+                visibleIndices.push_back(i);
+        }
+    }
+
+#ifdef CULLING_HAS_AVX2_PATH
+    CULLING_AVX2_TARGET void CpuCuller::cullRangeAvx2(const Frustum& frustum, uint32_t begin, uint32_t end, std::vector<uint32_t>& visibleIndices) const {
+        const __m256 signMask = _mm256_set1_ps(-0.f);
+
+        // Broadcast every plane component once, they're reused for the whole range
+        __m256 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+        for(int p = 0; p < 6; p++){
+            planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+            planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+            planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+            planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+            absX[p] = _mm256_andnot_ps(signMask, planeX[p]);
+            absY[p] = _mm256_andnot_ps(signMask, planeY[p]);
+            absZ[p] = _mm256_andnot_ps(signMask, planeZ[p]);
+        }
+
+        uint32_t i = begin;
+        for(; i + 8 <= end; i += 8){
+            __m256 cx = _mm256_loadu_ps(&centerX[i]);
+            __m256 cy = _mm256_loadu_ps(&centerY[i]);
+            __m256 cz = _mm256_loadu_ps(&centerZ[i]);
+            __m256 ex = _mm256_loadu_ps(&extentX[i]);
+            __m256 ey = _mm256_loadu_ps(&extentY[i]);
+            __m256 ez = _mm256_loadu_ps(&extentZ[i]);
+            // Take whichever bound is tighter against each plane: -min(radius, projected extent) < distance
+            __m256 negativeRadius = _mm256_xor_ps(_mm256_loadu_ps(&radius[i]), signMask);
+
+            __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for(int p = 0; p < 6; p++){
+                __m256 distance = _mm256_fmadd_ps(planeX[p], cx, _mm256_fmadd_ps(planeY[p], cy, _mm256_fmadd_ps(planeZ[p], cz, planeW[p])));
+                __m256 projectedExtent = _mm256_fmadd_ps(absX[p], ex, _mm256_fmadd_ps(absY[p], ey, _mm256_mul_ps(absZ[p], ez)));
+                __m256 threshold = _mm256_max_ps(negativeRadius, _mm256_xor_ps(projectedExtent, signMask));
+                visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, threshold, _CMP_GE_OQ));
+            }
+
+            int mask = _mm256_movemask_ps(visible);
+            while(mask != 0){
+                int lane = __builtin_ctz(static_cast<unsigned int>(mask));
+                visibleIndices.push_back(i + lane);
+                mask &= mask - 1;
+            }
+        }
+
+        // Remainder that doesn't fill a full register
+        cullRangeScalar(frustum, i, end, visibleIndices);
+    }
+#else
+    void CpuCuller::cullRangeAvx2(const Frustum& frustum, uint32_t begin, uint32_t end, std::vector<uint32_t>& visibleIndices) const {
+        cullRangeScalar(frustum, begin, end, visibleIndices);
+    }
+#endif
+}
\ No newline at end of file
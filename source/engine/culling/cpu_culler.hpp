@@ -0,0 +1,44 @@
+#pragma once
+
+#include "engine/bounds/bounds.hpp"
+#include "engine/threading/thread_pool.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace Renderer{
+    // Frustum culls object bounds on the CPU, for devices where compute time is scarce (integrated GPUs, software rasterisers).
+    // Bounds are kept as structure-of-arrays so the AVX2 path can test 8 objects per iteration, very large object counts
+    // are additionally split across the thread pool.
+    class CpuCuller{
+        public:
+            CpuCuller(ThreadPool& threadPool);
+
+            void resize(uint32_t count);
+            void setBounds(uint32_t index, const AABB& bounds);
+            uint32_t getCount() const { return static_cast<uint32_t>(centerX.size()); }
+            glm::vec3 getCenter(uint32_t index) const { return {centerX[index], centerY[index], centerZ[index]}; }
+
+            // Writes the indices of every object whose bounding sphere and box both overlap the frustum, in ascending order
+            void cull(const Frustum& frustum, std::vector<uint32_t>& visibleIndices);
+
+            static bool supportsAvx2();
+
+            // Object counts above this are split across the thread pool
+            uint32_t parallelThreshold = 32768;
+
+        private:
+            void cullRange(const Frustum& frustum, uint32_t begin, uint32_t end, std::vector<uint32_t>& visibleIndices) const;
+            void cullRangeScalar(const Frustum& frustum, uint32_t begin, uint32_t end, std::vector<uint32_t>& visibleIndices) const;
+            void cullRangeAvx2(const Frustum& frustum, uint32_t begin, uint32_t end, std::vector<uint32_t>& visibleIndices) const;
+
+            ThreadPool& threadPool;
+            bool useAvx2;
+
+            std::vector<float> centerX, centerY, centerZ;
+            std::vector<float> extentX, extentY, extentZ;
+            std::vector<float> radius;
+
+            std::vector<std::vector<uint32_t>> batchResults;
+    };
+}
\ No newline at end of file
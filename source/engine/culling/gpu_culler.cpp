@@ -0,0 +1,173 @@
+#include "gpu_culler.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+namespace Renderer{
+    GpuCuller::GpuCuller(Device& device, const std::string& shaderFilepath, std::vector<std::unique_ptr<Buffer>>& instanceBuffers)
+    : device{device}, instanceBuffers{instanceBuffers}{
+        setLayout = std::make_unique<DescriptorSetLayout>(device);
+        for(int i = 0; i < 7; i++)
+            setLayout->addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);  // bindings 0-6, see cull.comp
+        setLayout->buildLayout();
+
+        // One set of resources per frame in flight, following the instance buffers it writes into
+        uint32_t framesInFlight = static_cast<uint32_t>(instanceBuffers.size());
+        descriptorPool = std::make_unique<DescriptorPool>(device);
+        descriptorPool->addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 7 * framesInFlight);
+        descriptorPool->buildPool(framesInFlight);
+        for(uint32_t i = 0; i < framesInFlight; i++)
+            descriptorPool->allocateSet(setLayout->getLayout());
+
+        createPipeline(shaderFilepath);
+        frames.resize(framesInFlight);
+    }
+
+    GpuCuller::~GpuCuller(){
+        pipelines.reset();
+        vkDestroyPipelineLayout(device.getDevice(), pipelineLayout, nullptr);
+    }
+
+    void GpuCuller::createPipeline(const std::string& shaderFilepath){
+        auto layout = setLayout->getLayout();
+
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(PushData);
+
+        VkPipelineLayoutCreateInfo layoutInfo = {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layoutInfo.setLayoutCount = 1;
+        layoutInfo.pSetLayouts = &layout;
+        layoutInfo.pushConstantRangeCount = 1;
+        layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if(vkCreatePipelineLayout(device.getDevice(), &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create culling pipeline layout.");
+
+        pipelines = std::make_unique<PipelineVariants<ComputePipeline>>([this, shaderFilepath](const SpecializationConstants& constants){
+            return std::make_shared<ComputePipeline>(this->device, shaderFilepath, pipelineLayout, constants);
+        });
+
+        // Both variants up front so toggling culling never compiles a pipeline mid-frame
+        for(bool enableCulling : {true, false})
+            pipelines->get(SpecializationConstants{}.set(WorkgroupSizeId, workgroupSize).set(EnableCullingId, enableCulling));
+    }
+
+    void GpuCuller::setDraws(const std::vector<CullItem>& newItems, const std::vector<DrawSlot>& newSlots, uint32_t newRunCount, const void* newObjectData, uint32_t objectCount, VkDeviceSize objectDataStride){
+        items = newItems;
+        slots = newSlots;
+        runCount = newRunCount;
+        objectData.resize(objectCount * objectDataStride);
+        if(!objectData.empty())
+            std::memcpy(objectData.data(), newObjectData, objectData.size());
+
+        // Buffers only ever grow, so a scene that shrinks and regrows doesn't thrash allocations
+        if(items.size() > itemCapacity || slots.size() > slotCapacity || runCount > runCapacity || objectData.size() > objectCapacity || frames[0].items == nullptr){
+            vkDeviceWaitIdle(device.getDevice());
+            itemCapacity = std::max(itemCapacity, static_cast<uint32_t>(items.size()));
+            slotCapacity = std::max(slotCapacity, static_cast<uint32_t>(slots.size()));
+            runCapacity = std::max(runCapacity, runCount);
+            objectCapacity = std::max(objectCapacity, static_cast<VkDeviceSize>(objectData.size()));
+            createFrameResources();
+            writeDescriptorSets();
+        }
+
+        for(auto& frame : frames)
+            frame.dirty = true;
+    }
+
+    void GpuCuller::createFrameResources(){
+        // Zero sized buffers aren't allowed, so every buffer holds at least one element
+        auto createBuffer = [this](VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties){
+            return std::make_unique<Buffer>(device, 1, std::max<VkDeviceSize>(size, 16), usage, VK_SHARING_MODE_EXCLUSIVE, properties);
+        };
+        const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        for(auto& frame : frames){
+            frame.items = createBuffer(itemCapacity * sizeof(CullItem), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+            frame.objects = createBuffer(objectCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+            frame.slots = createBuffer(slotCapacity * sizeof(DrawSlot), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+            frame.items->map();
+            frame.objects->map();
+            frame.slots->map();
+
+            // Written and read only by the GPU
+            frame.slotCounts = createBuffer(slotCapacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            frame.runCounts = createBuffer(runCapacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            frame.commands = createBuffer(slotCapacity * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+    }
+
+    void GpuCuller::writeDescriptorSets(){
+        for(size_t i = 0; i < frames.size(); i++){
+            auto& frame = frames[i];
+            VkDescriptorBufferInfo infos[7] = {
+                frame.items->descriptorInfo(),
+                frame.objects->descriptorInfo(),
+                frame.slots->descriptorInfo(),
+                frame.slotCounts->descriptorInfo(),
+                frame.runCounts->descriptorInfo(),
+                frame.commands->descriptorInfo(),
+                instanceBuffers[i]->descriptorInfo()
+            };
+
+            std::vector<VkWriteDescriptorSet> writes;
+            for(uint32_t binding = 0; binding < 7; binding++)
+                writes.push_back(setLayout->writeBuffer(binding, &infos[binding]));
+            descriptorPool->updateSet(static_cast<uint32_t>(i), writes);
+        }
+    }
+
+    void GpuCuller::record(VkCommandBuffer commandBuffer, uint32_t frameIndex, const Frustum& frustum, bool enableCulling){
+        auto& frame = frames[frameIndex];
+        if(frame.items == nullptr)
+            return;
+
+        // The frame's fence has already been waited on, so its previous contents are no longer in use
+        if(frame.dirty){
+            if(!items.empty())
+                frame.items->writeToBuffer(items.data(), items.size() * sizeof(CullItem));
+            if(!slots.empty())
+                frame.slots->writeToBuffer(slots.data(), slots.size() * sizeof(DrawSlot));
+            if(!objectData.empty())
+                frame.objects->writeToBuffer(objectData.data(), objectData.size());
+            frame.dirty = false;
+        }
+
+        vkCmdFillBuffer(commandBuffer, frame.slotCounts->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+        vkCmdFillBuffer(commandBuffer, frame.runCounts->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        pipelines->get(SpecializationConstants{}.set(WorkgroupSizeId, workgroupSize).set(EnableCullingId, enableCulling))->bind(commandBuffer);
+        VkDescriptorSet set = descriptorPool->getSets()[frameIndex];
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+
+        PushData push{};
+        std::copy(std::begin(frustum.planes), std::end(frustum.planes), push.frustumPlanes);
+        push.itemCount = static_cast<uint32_t>(items.size());
+        push.slotCount = static_cast<uint32_t>(slots.size());
+
+        // Pass 0: cull items and append visible instances to their slots
+        push.pass = 0;
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushData), &push);
+        vkCmdDispatch(commandBuffer, (push.itemCount + workgroupSize - 1) / workgroupSize, 1, 1);
+
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        // Pass 1: compact non-empty slots into their run's commands
+        push.pass = 1;
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushData), &push);
+        vkCmdDispatch(commandBuffer, (push.slotCount + workgroupSize - 1) / workgroupSize, 1, 1);
+        // The barrier before the draws reading the results comes from the render graph, which sees both passes' accesses
+    }
+}
\ No newline at end of file
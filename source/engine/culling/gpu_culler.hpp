@@ -0,0 +1,104 @@
+#pragma once
+
+#include "engine/device/device.hpp"
+#include "engine/buffer/buffer.hpp"
+#include "engine/bounds/bounds.hpp"
+#include "engine/pipeline/pipeline.hpp"
+#include "engine/pipeline/specialization/specialization.hpp"
+#include "engine/pipeline/descriptors/descriptors.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Renderer{
+    // Culls and generates indirect draws entirely on the GPU (cull.comp), so the number of surviving draws never reaches the CPU.
+    // Draws are laid out in slots (one per mesh) grouped into runs (one per model): visible instances are appended to their slot,
+    // then non-empty slots are compacted to the front of their run, and each run's draw count is written for vkCmdDrawIndexedIndirectCount.
+    class GpuCuller{
+        public:
+            // The structs below match their std430 counterparts in cull.comp
+            struct CullItem{
+                glm::vec4 sphere;   // xyz centre, w radius
+                glm::vec4 extent;   // xyz half extent
+                uint32_t objectIndex;
+                uint32_t slot;
+                uint32_t materialId;
+                uint32_t modelId;
+            };
+
+            struct DrawSlot{
+                uint32_t indexCount;
+                uint32_t instanceBase;      // First instance of the slot's range in the instance buffer
+                uint32_t run;
+                uint32_t runCommandBase;    // First command of the slot's run in the command buffer
+            };
+
+            struct PushData{
+                glm::vec4 frustumPlanes[6];
+                uint32_t itemCount;
+                uint32_t slotCount;
+                uint32_t pass;
+            };
+
+            // Constant IDs declared by cull.comp
+            enum SpecializationId : uint32_t{
+                WorkgroupSizeId = 0,
+                EnableCullingId = 1
+            };
+
+            static constexpr uint32_t workgroupSize = 64;
+
+            // instanceBuffers are the per-frame storage buffers the visible instance data is written into, one per frame in flight
+            GpuCuller(Device& device, const std::string& shaderFilepath, std::vector<std::unique_ptr<Buffer>>& instanceBuffers);
+            ~GpuCuller();
+
+            GpuCuller(const GpuCuller&) = delete;
+            GpuCuller& operator=(const GpuCuller&) = delete;
+
+            // Sets the draw layout and per-object data (one objectDataStride sized element per objectIndex), uploaded lazily per frame.
+            // Growing the GPU buffers waits for the device to go idle.
+            void setDraws(const std::vector<CullItem>& items, const std::vector<DrawSlot>& slots, uint32_t runCount, const void* objectData, uint32_t objectCount, VkDeviceSize objectDataStride);
+
+            // Records both culling passes, must be recorded outside of a render pass and before the draws that consume the results.
+            // The results are left unsynchronised, the draws have to be ordered after the compute writes by the caller.
+            // enableCulling selects a specialised pipeline variant rather than branching in the shader.
+            void record(VkCommandBuffer commandBuffer, uint32_t frameIndex, const Frustum& frustum, bool enableCulling);
+
+            VkBuffer getCommandBuffer(uint32_t frameIndex) { return frames[frameIndex].commands->getBuffer(); }
+            // One uint32_t draw count per run
+            VkBuffer getRunCountBuffer(uint32_t frameIndex) { return frames[frameIndex].runCounts->getBuffer(); }
+
+        private:
+            struct FrameResources{
+                std::unique_ptr<Buffer> items, objects, slots;
+                std::unique_ptr<Buffer> slotCounts, runCounts;
+                std::unique_ptr<Buffer> commands;
+                bool dirty = true;
+            };
+
+            void createPipeline(const std::string& shaderFilepath);
+            void createFrameResources();
+            void writeDescriptorSets();
+
+            Device& device;
+            std::vector<std::unique_ptr<Buffer>>& instanceBuffers;
+
+            std::unique_ptr<DescriptorSetLayout> setLayout;
+            std::unique_ptr<DescriptorPool> descriptorPool;
+            VkPipelineLayout pipelineLayout;
+            std::unique_ptr<PipelineVariants<ComputePipeline>> pipelines;
+
+            std::vector<FrameResources> frames;
+
+            // CPU copies, uploaded into each frame's buffers the next time that frame is recorded
+            std::vector<CullItem> items;
+            std::vector<DrawSlot> slots;
+            std::vector<char> objectData;
+            uint32_t runCount = 0;
+
+            // Element capacities of the current GPU buffers
+            uint32_t itemCapacity = 0, slotCapacity = 0, runCapacity = 0;
+            VkDeviceSize objectCapacity = 0;
+    };
+}
\ No newline at end of file
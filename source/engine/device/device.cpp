@@ -1,5 +1,9 @@
 #include "device.hpp"
 
+#include "engine/pipeline/pipeline_cache/pipeline_cache.hpp"
+#include "engine/pipeline/shader_registry/shader_registry.hpp"
+#include "engine/pipeline/descriptors/descriptors.hpp"
+
 #include <stdexcept>
 #include <iostream>
 #include <cstring>
@@ -7,14 +11,23 @@
 #include <unordered_set>
 
 namespace Renderer{
-    Device::Device(Window& window) : window{window}{
+    Device::Device(Window& window, const std::string& pipelineCacheFilepath) : window{&window}, pipelineCacheFilepath{pipelineCacheFilepath}{
+        initVulkan();
+    }
+
+    Device::Device(const std::string& pipelineCacheFilepath) : pipelineCacheFilepath{pipelineCacheFilepath}{
+        deviceExtensions.clear();
         initVulkan();
     }
 
     Device::~Device(){
+        shaderRegistry.reset();
+        pipelineCache.reset();
+        descriptorLayoutCache.reset();
         vkDestroyCommandPool(device, commandPool, nullptr);
         vkDestroyDevice(device, nullptr);
-        vkDestroySurfaceKHR(instance, surface, nullptr);
+        if(surface != VK_NULL_HANDLE)
+            vkDestroySurfaceKHR(instance, surface, nullptr);
         if(Debugger::VulkanDebugger::enableValidationLayers) 
             debugger.destroyDebugUtilsMessengerEXT(instance, nullptr);
         vkDestroyInstance(instance, nullptr);
@@ -26,6 +39,13 @@ namespace Renderer{
         pickPhysicalDevice();
         createLogicalDevice();
         createCommandPool();
+        createPipelineResources();
+    }
+
+    void Device::createPipelineResources(){
+        pipelineCache = std::make_unique<PipelineCache>(*this, pipelineCacheFilepath);
+        shaderRegistry = std::make_unique<ShaderRegistry>(*this);
+        descriptorLayoutCache = std::make_unique<DescriptorLayoutCache>(*this);
     }
 
     void Device::createInstance(){
@@ -66,16 +86,21 @@ namespace Renderer{
     }
 
     std::vector<const char*> Device::getRequiredExtensions(){
-        uint32_t count = 0;
-        const char** glfwRequiredExtensions = glfwGetRequiredInstanceExtensions(&count);
-        std::vector<const char*> extensions(glfwRequiredExtensions, glfwRequiredExtensions + count);
+        std::vector<const char*> extensions;
+        // GLFW isn't initialized without a window and no surface extensions are needed
+        if(!isHeadless()){
+            uint32_t count = 0;
+            const char** glfwRequiredExtensions = glfwGetRequiredInstanceExtensions(&count);
+            extensions.assign(glfwRequiredExtensions, glfwRequiredExtensions + count);
+        }
         if (Debugger::VulkanDebugger::enableValidationLayers)
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
         return extensions;
     }
 
     void Device::createSurface(){
-        window.createWindowSurface(instance, &surface);
+        if(!isHeadless())
+            window->createWindowSurface(instance, &surface);
     }
 
     void Device::pickPhysicalDevice(){
@@ -105,9 +130,9 @@ namespace Renderer{
         QueueFamilyIndices indices = findQueueFamilies(device);
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
-        bool swapChainAdequate = false;
+        bool swapChainAdequate = isHeadless();
 
-        if (extensionsSupported) {
+        if (extensionsSupported && !isHeadless()) {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         }
@@ -160,7 +185,10 @@ namespace Renderer{
                 indices.graphicsFamilyHasValue = true;
             }
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+            if(isHeadless())
+                presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == static_cast<uint32_t>(i);
+            else
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
             if (queueFamily.queueCount > 0 && presentSupport) {
                 indices.presentFamily = i;
                 indices.presentFamilyHasValue = true;
@@ -186,6 +214,19 @@ namespace Renderer{
         return requiredExtensions.empty();
     }
 
+    bool Device::isDeviceExtensionSupported(VkPhysicalDevice device, const char* extensionName){
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto& extension : availableExtensions)
+            if (std::strcmp(extension.extensionName, extensionName) == 0)
+                return true;
+        return false;
+    }
+
     void Device::createLogicalDevice(){
         QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
@@ -208,14 +249,45 @@ namespace Renderer{
         features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
         features.multiDrawIndirect = VK_TRUE;
 
+        // Optional Vulkan 1.2 and 1.3 features, enabled only when present so older devices still get a device
+        VkPhysicalDeviceVulkan13Features supportedFeatures13 = {};
+        supportedFeatures13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+        VkPhysicalDeviceVulkan12Features supportedFeatures12 = {};
+        supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        supportedFeatures12.pNext = properties.apiVersion >= VK_API_VERSION_1_3 ? &supportedFeatures13 : nullptr;
+        if(properties.apiVersion >= VK_API_VERSION_1_2){
+            VkPhysicalDeviceFeatures2 supportedFeatures2 = {};
+            supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            supportedFeatures2.pNext = &supportedFeatures12;
+            vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures2);
+        }
+
+        VkPhysicalDeviceVulkan12Features features12 = {};
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        features12.drawIndirectCount = supportedFeatures12.drawIndirectCount;
+        drawIndirectCountSupported = supportedFeatures12.drawIndirectCount == VK_TRUE;
+
+        // VK_KHR_dynamic_rendering as promoted to 1.3, so vkCmdBeginRendering is linked like the other core functions
+        VkPhysicalDeviceVulkan13Features features13 = {};
+        features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+        features13.dynamicRendering = supportedFeatures13.dynamicRendering;
+        dynamicRenderingSupported = supportedFeatures13.dynamicRendering == VK_TRUE;
+        features12.pNext = properties.apiVersion >= VK_API_VERSION_1_3 ? &features13 : nullptr;
+
+        // Optional extensions, enabled only when present
+        std::vector<const char*> enabledExtensions = deviceExtensions;
+        memoryBudgetSupported = isDeviceExtensionSupported(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if(memoryBudgetSupported)
+            enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
         VkDeviceCreateInfo deviceInfo = {};
         deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        deviceInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        deviceInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        deviceInfo.ppEnabledExtensionNames = enabledExtensions.data();
         deviceInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         deviceInfo.pQueueCreateInfos = queueCreateInfos.data();
         deviceInfo.pEnabledFeatures = &features;
-        deviceInfo.pNext = nullptr;
+        deviceInfo.pNext = properties.apiVersion >= VK_API_VERSION_1_2 ? &features12 : nullptr;
 
         if(vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device) != VK_SUCCESS)
             throw std::runtime_error("Failed to create logical device.");
@@ -274,7 +346,8 @@ namespace Renderer{
         throw std::runtime_error("Failed to find supported format.");
     }
 
-    void Device::createImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory) {
+    void Device::createImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, 
+        VkMemoryPropertyFlags preferredProperties) {
         if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS)
             throw std::runtime_error("Failed to create image.");
 
@@ -284,7 +357,9 @@ namespace Renderer{
         VkMemoryAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
         allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        allocInfo.memoryTypeIndex = preferredProperties != 0 ? tryFindMemoryType(memRequirements.memoryTypeBits, properties | preferredProperties) : UINT32_MAX;
+        if (allocInfo.memoryTypeIndex == UINT32_MAX)
+            allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
         if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
             throw std::runtime_error("Failed to allocate image memory.");
@@ -293,13 +368,19 @@ namespace Renderer{
     }
 
     uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+        uint32_t memoryType = tryFindMemoryType(typeFilter, properties);
+        if (memoryType == UINT32_MAX)
+            throw std::runtime_error("Failed to find suitable memory type.");
+        return memoryType;
+    }
+
+    uint32_t Device::tryFindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
         VkPhysicalDeviceMemoryProperties memProperties;
         vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
         for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
             if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
                 return i;
-
-        throw std::runtime_error("Failed to find suitable memory type.");
+        return UINT32_MAX;
     }
 
     VkCommandBuffer Device::beginSingleTimeCommands(){
@@ -334,6 +415,26 @@ namespace Renderer{
         vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
     }
 
+    Device::MemoryUsage Device::getDeviceLocalMemoryUsage(){
+        MemoryUsage memoryUsage{};
+        if(!memoryBudgetSupported)
+            return memoryUsage;
+
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        VkPhysicalDeviceMemoryProperties2 memoryProperties = {};
+        memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        memoryProperties.pNext = &budgetProperties;
+        vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memoryProperties);
+
+        for(uint32_t i = 0; i < memoryProperties.memoryProperties.memoryHeapCount; i++)
+            if(memoryProperties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT){
+                memoryUsage.usage += budgetProperties.heapUsage[i];
+                memoryUsage.budget += budgetProperties.heapBudget[i];
+            }
+        return memoryUsage;
+    }
+
     VkSampleCountFlagBits Device::getMaxUsableSampleCount(){
         VkPhysicalDeviceProperties physicalDeviceProperties;
         vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
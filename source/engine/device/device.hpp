@@ -6,8 +6,14 @@
 #include "engine/debugging/vulkan_debugger.hpp"
 
 #include <vector>
+#include <memory>
+#include <string>
 
 namespace Renderer{
+    class PipelineCache;
+    class ShaderRegistry;
+    class DescriptorLayoutCache;
+
     struct SwapChainSupportDetails {
         VkSurfaceCapabilitiesKHR capabilities;
 	    std::vector<VkSurfaceFormatKHR> formats;
@@ -22,25 +28,48 @@ namespace Renderer{
 
     class Device{
         public:
-            Device(Window& window);
+            // Summed over the device local heaps, from VK_EXT_memory_budget. Both are 0 when the extension isn't supported.
+            struct MemoryUsage{
+                VkDeviceSize usage = 0;
+                VkDeviceSize budget = 0;
+            };
+
+            Device(Window& window, const std::string& pipelineCacheFilepath = "pipeline_cache.bin");
+            // Headless device for offscreen rendering, no window, surface or VK_KHR_swapchain so it runs without a display
+            // (e.g. on lavapipe). The graphics queue doubles as the present queue.
+            explicit Device(const std::string& pipelineCacheFilepath);
             ~Device();
 
             // Getter Functions
             VkDevice getDevice() { return device; }
             VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
             VkSurfaceKHR getSurface() { return surface; }
+            bool isHeadless() const { return window == nullptr; }
             SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
             QueueFamilyIndices getPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
             VkCommandPool getCommandPool(){ return commandPool; }
             VkQueue getGraphicsQueue() { return graphicsQueue; }
             VkQueue getPresentQueue() { return presentQueue; }
+            const VkPhysicalDeviceProperties& getProperties() const { return properties; }
+            PipelineCache& getPipelineCache() { return *pipelineCache; }
+            ShaderRegistry& getShaderRegistry() { return *shaderRegistry; }
+            DescriptorLayoutCache& getDescriptorLayoutCache() { return *descriptorLayoutCache; }
             VkSampleCountFlagBits getMaxUsableSampleCount();
+            // Whether vkCmdDrawIndexedIndirectCount can be used (GPU-driven draw counts)
+            bool supportsDrawIndirectCount() { return drawIndirectCountSupported; }
+            // Whether passes can be begun with vkCmdBeginRendering instead of a render pass and framebuffer
+            bool supportsDynamicRendering() const { return dynamicRenderingSupported; }
+            MemoryUsage getDeviceLocalMemoryUsage();
             
 
             // Other Public Functions
             VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
-            void createImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+            // The image's memory also has preferredProperties when a memory type supports them, e.g. LAZILY_ALLOCATED for transient attachments
+            void createImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, 
+                VkMemoryPropertyFlags preferredProperties = 0);
             uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+            // UINT32_MAX instead of throwing when no memory type matches
+            uint32_t tryFindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
             VkCommandBuffer beginSingleTimeCommands();
             void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 
@@ -53,6 +82,7 @@ namespace Renderer{
             void pickPhysicalDevice();
             void createLogicalDevice();
             void createCommandPool();
+            void createPipelineResources();
 
             // Helper Functions
             std::vector<const char*> getRequiredExtensions();
@@ -60,20 +90,31 @@ namespace Renderer{
             SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
             QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
             bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+            bool isDeviceExtensionSupported(VkPhysicalDevice device, const char* extensionName);
             void hasRequiredExtensions();
 
             VkInstance instance;
             VkDevice device;
             VkPhysicalDevice physicalDevice;
             VkPhysicalDeviceProperties properties;
-            VkSurfaceKHR surface;
-            Window& window;
+            VkSurfaceKHR surface = VK_NULL_HANDLE;
+            // Null when headless
+            Window* window = nullptr;
             VkQueue graphicsQueue, presentQueue;
             VkCommandPool commandPool;
 
+            bool drawIndirectCountSupported = false;
+            bool dynamicRenderingSupported = false;
+            bool memoryBudgetSupported = false;
+
+            std::string pipelineCacheFilepath;
+            std::unique_ptr<PipelineCache> pipelineCache;
+            std::unique_ptr<ShaderRegistry> shaderRegistry;
+            std::unique_ptr<DescriptorLayoutCache> descriptorLayoutCache;
+
             Debugger::VulkanDebugger debugger;
 
-            // Expand this vector to include all needed device extensions
-            const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+            // Expand this vector to include all needed device extensions, cleared for headless devices
+            std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
     };
 }
\ No newline at end of file
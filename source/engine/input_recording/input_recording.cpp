@@ -0,0 +1,103 @@
+#include "input_recording.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <string>
+
+namespace Renderer{
+    namespace{
+        constexpr char magic[4] = {'R', 'I', 'N', 'P'};
+        constexpr uint32_t version = 1;
+
+        // Byte by byte so the file reads back the same on any host
+        template<typename T>
+        void writeUnsigned(std::ofstream& file, T value){
+            for(size_t i = 0; i < sizeof(T); i++)
+                file.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+
+        template<typename T>
+        T readUnsigned(std::ifstream& file){
+            T value = 0;
+            for(size_t i = 0; i < sizeof(T); i++){
+                int byte = file.get();
+                if(byte == std::char_traits<char>::eof())
+                    throw std::runtime_error("Input recording is truncated");
+                value |= static_cast<T>(static_cast<T>(byte) << (8 * i));
+            }
+            return value;
+        }
+
+        void writeFloat(std::ofstream& file, float value){
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            writeUnsigned(file, bits);
+        }
+
+        float readFloat(std::ifstream& file){
+            uint32_t bits = readUnsigned<uint32_t>(file);
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        void writeVec3(std::ofstream& file, const glm::vec3& value){
+            writeFloat(file, value.x);
+            writeFloat(file, value.y);
+            writeFloat(file, value.z);
+        }
+
+        glm::vec3 readVec3(std::ifstream& file){
+            float x = readFloat(file);
+            float y = readFloat(file);
+            float z = readFloat(file);
+            return {x, y, z};
+        }
+    }
+
+    void InputRecording::save(const std::string& filepath) const {
+        std::ofstream file{filepath, std::ios::binary};
+        if(!file.is_open())
+            throw std::runtime_error("Failed to open input recording for writing: " + filepath);
+
+        file.write(magic, sizeof(magic));
+        writeUnsigned(file, version);
+        writeVec3(file, startTranslation);
+        writeVec3(file, startRotation);
+        writeUnsigned(file, static_cast<uint32_t>(frames.size()));
+        for(const auto& frame : frames){
+            writeUnsigned(file, frame.input);
+            writeFloat(file, frame.deltaMilliseconds);
+        }
+        if(!file)
+            throw std::runtime_error("Failed to write input recording: " + filepath);
+    }
+
+    InputRecording InputRecording::load(const std::string& filepath){
+        std::ifstream file{filepath, std::ios::binary};
+        if(!file.is_open())
+            throw std::runtime_error("Failed to open input recording: " + filepath);
+
+        char fileMagic[sizeof(magic)];
+        if(!file.read(fileMagic, sizeof(fileMagic)) || std::memcmp(fileMagic, magic, sizeof(magic)) != 0)
+            throw std::runtime_error("Not an input recording: " + filepath);
+        uint32_t fileVersion = readUnsigned<uint32_t>(file);
+        if(fileVersion != version)
+            throw std::runtime_error("Unsupported input recording version " + std::to_string(fileVersion) + ": " + filepath);
+
+        InputRecording recording{};
+        recording.startTranslation = readVec3(file);
+        recording.startRotation = readVec3(file);
+        uint32_t frameCount = readUnsigned<uint32_t>(file);
+        recording.frames.reserve(frameCount);
+        for(uint32_t i = 0; i < frameCount; i++){
+            Frame frame{};
+            frame.input = readUnsigned<KeyboardMovementController::Input>(file);
+            frame.deltaMilliseconds = readFloat(file);
+            recording.frames.push_back(frame);
+        }
+        return recording;
+    }
+}
\ No newline at end of file
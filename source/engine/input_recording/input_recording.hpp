@@ -0,0 +1,28 @@
+#pragma once
+
+#include "engine/camera/camera_controller/camera_controller.hpp"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+namespace Renderer{
+    // Camera input and delta of every frame of a run, with the camera's starting transform. Replaying it moves the camera
+    // through exactly the same views whatever the replaying machine's frame times are.
+    struct InputRecording{
+        struct Frame{
+            KeyboardMovementController::Input input = 0;
+            // The delta the camera moved with, the frame time or a fixed timestep
+            float deltaMilliseconds = 0.f;
+        };
+
+        glm::vec3 startTranslation{0.f};
+        glm::vec3 startRotation{0.f};
+        std::vector<Frame> frames;
+
+        // Little-endian binary: header then 6 bytes per frame
+        void save(const std::string& filepath) const;
+        static InputRecording load(const std::string& filepath);
+    };
+}
\ No newline at end of file
@@ -7,9 +7,9 @@
 
 #include "engine/device/device.hpp"
 #include "engine/material/texture/texture.hpp"
+#include "engine/slot_map/slot_map.hpp"
 
 #include <vector>
-#include <unordered_map>
 
 namespace Renderer{
     class Material{
@@ -23,21 +23,10 @@ namespace Renderer{
                 glm::vec4 hue = { 1.0f, 1.0f, 1.0f, 1.0f };             // Overall hue of the material
             } properties{};
 
-            using Map = std::unordered_map<unsigned int, Material>;
+            using Id = SlotHandle<Material>;
+            using Map = SlotMap<Material>;
 
-            static Material createMaterial(){
-                static unsigned int currentId = 0;
-                return Material{currentId++};
-            }
-    
-            unsigned int getId() { return id; }
-
-            std::vector<unsigned int> diffuseTextureIds;
-            std::vector<unsigned int> normalTextureIds;
-
-        private:
-            Material(unsigned int materialId) : id{materialId} {}
-
-            unsigned int id;
+            std::vector<Texture::Id> diffuseTextureIds;
+            std::vector<Texture::Id> normalTextureIds;
     };
 }
\ No newline at end of file
@@ -3,7 +3,7 @@
 #include <stdexcept>
 
 namespace Renderer{
-    Sampler::Sampler(Device& device, SamplerConfig samplerConfig, unsigned int samplerId) : device{device}, id{samplerId} {
+    Sampler::Sampler(Device& device, SamplerConfig samplerConfig) : device{device} {
         VkSamplerCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
         createInfo.magFilter = samplerConfig.magFilter;
@@ -31,7 +31,6 @@ namespace Renderer{
     }
 
     std::unique_ptr<Sampler> Sampler::createSampler(Device& device, SamplerConfig samplerConfig){
-        static unsigned int currentId = 0;
-        return std::make_unique<Sampler>(device, samplerConfig, currentId++);
+        return std::make_unique<Sampler>(device, samplerConfig);
     }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "engine/device/device.hpp"
+#include "engine/slot_map/slot_map.hpp"
 
 #include <memory>
 
@@ -25,17 +26,17 @@ namespace Renderer{
                 float maxLod = 0.f;
             };
 
-            Sampler(Device& device, SamplerConfig samplerConfig, unsigned int samplerId);
+            using Id = SlotHandle<Sampler>;
+            using Map = SlotMap<std::shared_ptr<Sampler>, Sampler>;
+
+            Sampler(Device& device, SamplerConfig samplerConfig);
             ~Sampler();
 
-            unsigned int getId() { return id; }
             VkSampler getSampler(){ return sampler; }
             static std::unique_ptr<Sampler> createSampler(Device& device, SamplerConfig samplerConfig);
 
         private:
             Device& device;
             VkSampler sampler;
-
-            unsigned int id;
     };
 }
\ No newline at end of file
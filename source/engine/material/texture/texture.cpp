@@ -9,10 +9,14 @@
 #include <cassert>
 
 namespace Renderer{
-    Texture::Texture(Device& device, std::string filepath, unsigned int textureId) : device{device}, textureId{textureId}{
+    Texture::Texture(Device& device, std::string filepath) : device{device}{
         createTexture(filepath);
     }
 
+    Texture::Texture(Device& device, uint32_t width, uint32_t height, const void* pixels) : device{device}{
+        createTexture(pixels, width, height);
+    }
+
     Texture::~Texture(){
         vkDestroyImage(device.getDevice(), textureImage, nullptr);
         vkDestroyImageView(device.getDevice(), textureImageView, nullptr);
@@ -20,8 +24,11 @@ namespace Renderer{
     }
 
     std::unique_ptr<Texture> Texture::createTextureFromFile(Device& device, std::string filepath){
-        static unsigned int currentId = 0;
-        return std::make_unique<Texture>(device, filepath, currentId++);
+        return std::make_unique<Texture>(device, filepath);
+    }
+
+    std::unique_ptr<Texture> Texture::createTextureFromPixels(Device& device, uint32_t width, uint32_t height, const void* pixels){
+        return std::make_unique<Texture>(device, width, height, pixels);
     }
 
     void Texture::createTexture(std::string filepath){
@@ -30,9 +37,13 @@ namespace Renderer{
         if(!pixels)
             std::cout << "Failed to load the following image file: " << filepath << '\n';
 
-        void* pPixels = pixels;
-        imageExtent = {static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight)};
-        VkDeviceSize imageSize = texWidth * texHeight * 4;
+        createTexture(pixels, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+        stbi_image_free(pixels);
+    }
+
+    void Texture::createTexture(const void* pPixels, uint32_t texWidth, uint32_t texHeight){
+        imageExtent = {texWidth, texHeight};
+        VkDeviceSize imageSize = static_cast<VkDeviceSize>(texWidth) * texHeight * 4;
         mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
         Buffer stagingBuffer{
@@ -58,7 +69,6 @@ namespace Renderer{
 
         stagingBuffer.copyBuffer(imageBuffer->getBuffer(), imageBuffer->getSize());
 
-        stbi_image_free(pixels);
         createTextureImage();
             transitionImageLayout(VK_FORMAT_R8G8B8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
             imageBuffer->copyBufferToImage(textureImage, imageExtent.width, imageExtent.height);
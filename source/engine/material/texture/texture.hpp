@@ -3,30 +3,36 @@
 #include "engine/device/device.hpp"
 #include "engine/buffer/buffer.hpp"
 #include "engine/material/sampler/sampler.hpp"
+#include "engine/slot_map/slot_map.hpp"
 
-#include <unordered_map>
 #include <memory>
 
 namespace Renderer{
     class Texture{
         public: 
-            Texture(Device& device, std::string filepath, unsigned int textureId);
+            using Id = SlotHandle<Texture>;
+            using Map = SlotMap<std::shared_ptr<Texture>, Texture>;
+
+            Texture(Device& device, std::string filepath);
+            // pixels are tightly packed RGBA8, width * height * 4 bytes
+            Texture(Device& device, uint32_t width, uint32_t height, const void* pixels);
             ~Texture();
 
             Texture(const Texture&) = delete;
             Texture &operator=(const Texture&) = delete;
 
             static std::unique_ptr<Texture> createTextureFromFile(Device& device, std::string filepath);
+            static std::unique_ptr<Texture> createTextureFromPixels(Device& device, uint32_t width, uint32_t height, const void* pixels);
 
             VkImageView getTextureImageView() { return textureImageView; }
             uint32_t getMipLevels() { return mipLevels; }
             VkDescriptorImageInfo descriptorImageInfo();
-            unsigned int getId() { return textureId; }
 
-            unsigned int samplerId;
+            Sampler::Id samplerId;
 
         private:
             void createTexture(std::string filepath);
+            void createTexture(const void* pixels, uint32_t width, uint32_t height);
             void createTextureImage();
             void createTextureImageView();
             void transitionImageLayout(VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
@@ -41,7 +47,5 @@ namespace Renderer{
 
             VkExtent2D imageExtent;
             std::unique_ptr<Buffer> imageBuffer;
-
-            unsigned int textureId;
     };
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "engine/device/device.hpp"
+#include "engine/mesh/model.hpp"
 #include "engine/material/material.hpp"
+#include "engine/slot_map/slot_map.hpp"
 
 namespace Renderer{
     class Mesh{
@@ -16,21 +18,10 @@ namespace Renderer{
                 glm::vec4 hue = { 1.0f, 1.0f, 1.0f, 1.0f };         // Hue of the light.
             } pointLightComponent{};
 
-            using Map = std::unordered_map<unsigned int, Mesh>;
+            using Id = SlotHandle<Mesh>;
+            using Map = SlotMap<Mesh>;
 
-            static Mesh createMesh(){
-                static unsigned int currentId = 0;
-                return Mesh{currentId++};
-            };
-
-            unsigned int getId() { return id; }
-
-            unsigned int modelId;
-            unsigned int materialId;
-
-        private:
-            Mesh(unsigned int meshId) : id{meshId} {};
-            
-            unsigned int id;
+            Model::Id modelId;
+            Material::Id materialId;
     };
 }
\ No newline at end of file
@@ -23,16 +23,15 @@ namespace std{
 }
 
 namespace Renderer{
-    Model::Model(Device& device, ModelData& data, unsigned int modelId) : device{device}, modelId{modelId}{
+    Model::Model(Device& device, ModelData& data) : device{device}, bounds{data.bounds}{
         createVertexBuffers(data.vertices);
         createIndexBuffers(data.indices);
     }
 
     std::unique_ptr<Model> Model::createModelFromFile(Device& device, const std::string& filepath){
-        static unsigned int currentId = 0;
         ModelData data{};
         data.loadModel(filepath);
-        return std::make_unique<Model>(device, data, currentId++);
+        return std::make_unique<Model>(device, data);
     }
 
     void Model::ModelData::loadModel(const std::string &filepath){
@@ -47,6 +46,7 @@ namespace Renderer{
 
         vertices.clear();
         indices.clear();
+        bounds = AABB{};
 
         std::unordered_map<Vertex, uint32_t> uniqueVertices{};
         for (const auto &shape : shapes) {
@@ -80,6 +80,7 @@ namespace Renderer{
                 if (uniqueVertices.count(vertex) == 0) {
                   uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
                   vertices.push_back(vertex);
+                  bounds.expand(vertex.position);
                 }
                 indices.push_back(uniqueVertices[vertex]);
             }     
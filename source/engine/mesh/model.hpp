@@ -1,10 +1,11 @@
 #pragma once
 
 #include "engine/buffer/buffer.hpp"
+#include "engine/slot_map/slot_map.hpp"
+#include "engine/bounds/bounds.hpp"
 #include "glm/glm.hpp"
 
 #include <memory>
-#include <unordered_map>
 
 namespace Renderer{
     // Class representing a 3D model
@@ -27,18 +28,22 @@ namespace Renderer{
             struct ModelData{
                 std::vector<Vertex> vertices{};
                 std::vector<uint32_t> indices{};
+                AABB bounds{};  // Object-space bounds of all vertices
                 void loadModel(const std::string &filepath);
             };
 
-            Model(Device& device, ModelData& data, unsigned int modelId);
+            using Id = SlotHandle<Model>;
+            using Map = SlotMap<std::shared_ptr<Model>, Model>;
+
+            Model(Device& device, ModelData& data);
 
             Model(const Model&) = delete;
             Model &operator=(const Model&) = delete;
         
-            unsigned int getId() { return modelId; }
             static std::unique_ptr<Model> createModelFromFile(Device& device, const std::string& filepath);
 
             uint32_t getVertexCount() { return vertexCount; }
+            const AABB& getBounds() const { return bounds; }
             uint32_t getIndexCount() { 
                 if(hasIndexBuffer) 
                     return indexCount; 
@@ -63,6 +68,6 @@ namespace Renderer{
 
             bool hasIndexBuffer = false;
 
-            unsigned int modelId;
+            AABB bounds;
     };
 }
\ No newline at end of file
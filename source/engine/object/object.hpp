@@ -1,13 +1,12 @@
 #pragma once
 
-#include "engine/mesh/model.hpp"
-#include "engine/material/texture/texture.hpp"
-#include "engine/material/sampler/sampler.hpp"
+#include "engine/mesh/mesh.hpp"
+#include "engine/slot_map/slot_map.hpp"
+#include "engine/bvh/bvh.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <memory>
-#include <unordered_map>
+#include <vector>
 
 namespace Renderer{
     struct TransformComponent {
@@ -21,22 +20,13 @@ namespace Renderer{
 
     class Object{
         public:
-            using Map = std::unordered_map<unsigned int, Object>;
-
-            static Object createObject() {
-                static unsigned int currentId = 0;
-                return Object{currentId++};
-            }
-
-            unsigned int getId() { return id; }
+            using Id = SlotHandle<Object>;
+            using Map = SlotMap<Object>;
             
             TransformComponent transform{};
 
-            std::vector<unsigned int> meshIds;
-
-        private:
-            Object(unsigned int objectId) : id{objectId} {}
+            std::vector<Mesh::Id> meshIds;
 
-            unsigned int id;
+            int32_t bvhProxy = BVH::nullNode;  // Leaf in the owning scene's spatial index, if it has been given bounds
     };
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "parallel_recorder.hpp"
+
+#include "engine/profiling/cpu_profiler.hpp"
+
+#include <stdexcept>
+
+namespace Renderer{
+    ParallelRecorder::ParallelRecorder(Device& device, ThreadPool& threadPool, uint32_t framesInFlight) : device{device}, threadPool{threadPool}{
+        createFramePools(framesInFlight);
+    }
+
+    ParallelRecorder::~ParallelRecorder(){
+        destroyFramePools();
+    }
+
+    void ParallelRecorder::setFramesInFlight(uint32_t framesInFlight){
+        destroyFramePools();
+        createFramePools(framesInFlight);
+        currentFrameIndex = 0;
+    }
+
+    void ParallelRecorder::createFramePools(uint32_t framesInFlight){
+        QueueFamilyIndices queueFamilyIndices = device.getPhysicalQueueFamilies();
+
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;  // Buffers are rerecorded every frame
+
+        framePools.resize(framesInFlight);
+        for(auto& threadPools : framePools){
+            threadPools.resize(getMaxJobCount());
+            for(auto& threadCommandPool : threadPools)
+                if(vkCreateCommandPool(device.getDevice(), &poolInfo, nullptr, &threadCommandPool.pool) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to create per-thread command pool.");
+        }
+    }
+
+    void ParallelRecorder::destroyFramePools(){
+        // Destroying a pool frees its command buffers
+        for(auto& threadPools : framePools)
+            for(auto& threadCommandPool : threadPools)
+                vkDestroyCommandPool(device.getDevice(), threadCommandPool.pool, nullptr);
+        framePools.clear();
+    }
+
+    void ParallelRecorder::beginFrame(uint32_t frameIndex){
+        currentFrameIndex = frameIndex;
+        for(auto& threadCommandPool : framePools[frameIndex]){
+            vkResetCommandPool(device.getDevice(), threadCommandPool.pool, 0);
+            threadCommandPool.usedBuffers = 0;
+        }
+    }
+
+    VkCommandBuffer ParallelRecorder::acquireCommandBuffer(ThreadCommandPool& threadCommandPool){
+        if(threadCommandPool.usedBuffers == threadCommandPool.buffers.size()){
+            VkCommandBufferAllocateInfo allocInfo = {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = threadCommandPool.pool;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if(vkAllocateCommandBuffers(device.getDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+                throw std::runtime_error("Failed to allocate secondary command buffer.");
+            threadCommandPool.buffers.push_back(commandBuffer);
+        }
+        return threadCommandPool.buffers[threadCommandPool.usedBuffers++];
+    }
+
+    void ParallelRecorder::recordRenderPass(VkCommandBuffer primaryCommandBuffer, const VkCommandBufferInheritanceInfo& inheritanceInfo, uint32_t jobCount, const RecordFunction& record){
+        if(jobCount == 0)
+            return;
+        jobCommandBuffers.resize(jobCount);
+
+        threadPool.parallelFor(jobCount, 1, [&](uint32_t beginJob, uint32_t endJob){
+            auto& threadCommandPool = framePools[currentFrameIndex][ThreadPool::getCurrentThreadIndex()];
+            for(uint32_t job = beginJob; job < endJob; job++){
+                RENDERER_PROFILE_SCOPE("Record Secondary");
+                VkCommandBuffer commandBuffer = acquireCommandBuffer(threadCommandPool);
+
+                VkCommandBufferBeginInfo beginInfo = {};
+                beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+                beginInfo.pInheritanceInfo = &inheritanceInfo;
+                if(vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to begin recording secondary command buffer.");
+
+                record(commandBuffer, job);
+
+                if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to end secondary command buffer.");
+                jobCommandBuffers[job] = commandBuffer;
+            }
+        });
+
+        vkCmdExecuteCommands(primaryCommandBuffer, jobCount, jobCommandBuffers.data());
+    }
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "engine/device/device.hpp"
+#include "engine/threading/thread_pool.hpp"
+
+#include <vector>
+#include <functional>
+
+namespace Renderer{
+    // Records secondary command buffers on the thread pool. Command pools can only be used by one thread at a time,
+    // so there is one pool per thread per frame in flight, reset as a whole at the start of the frame.
+    class ParallelRecorder{
+        public:
+            using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, uint32_t jobIndex)>;
+
+            ParallelRecorder(Device& device, ThreadPool& threadPool, uint32_t framesInFlight);
+            ~ParallelRecorder();
+
+            ParallelRecorder(const ParallelRecorder&) = delete;
+            ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+            // Recreates the per-frame pools, the device must be idle
+            void setFramesInFlight(uint32_t framesInFlight);
+
+            // Recycles the frame's command buffers, the frame's fence must have been waited on
+            void beginFrame(uint32_t frameIndex);
+
+            // Records jobCount secondary command buffers continuing the render pass described by inheritanceInfo,
+            // then executes them into primaryCommandBuffer in job order. The render pass must have been begun with
+            // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, and dynamic state (viewport, scissor) is not inherited.
+            void recordRenderPass(VkCommandBuffer primaryCommandBuffer, const VkCommandBufferInheritanceInfo& inheritanceInfo, uint32_t jobCount, const RecordFunction& record);
+
+            uint32_t getMaxJobCount() const { return threadPool.getThreadCount() + 1; }
+
+        private:
+            struct ThreadCommandPool{
+                VkCommandPool pool = VK_NULL_HANDLE;
+                std::vector<VkCommandBuffer> buffers;
+                uint32_t usedBuffers = 0;
+            };
+
+            VkCommandBuffer acquireCommandBuffer(ThreadCommandPool& threadPool);
+            void createFramePools(uint32_t framesInFlight);
+            void destroyFramePools();
+
+            Device& device;
+            ThreadPool& threadPool;
+
+            // [frame][thread]
+            std::vector<std::vector<ThreadCommandPool>> framePools;
+            uint32_t currentFrameIndex = 0;
+
+            std::vector<VkCommandBuffer> jobCommandBuffers;
+    };
+}
\ No newline at end of file
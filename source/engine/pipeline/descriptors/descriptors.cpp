@@ -2,6 +2,9 @@
 
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <functional>
 
 namespace Renderer{
     DescriptorPool::DescriptorPool(Device& device) : device{device}{}
@@ -67,14 +70,7 @@ namespace Renderer{
         std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
         for (auto binding : bindings) 
             setLayoutBindings.push_back(binding.second);
-        VkDescriptorSetLayoutCreateInfo layoutInfo = {};
-        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        layoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
-        layoutInfo.pBindings = setLayoutBindings.data();
-        layoutInfo.flags = flags;
-
-        if(vkCreateDescriptorSetLayout(device.getDevice(), &layoutInfo, nullptr, &layout) != VK_SUCCESS)
-            throw std::runtime_error("Failed to create descriptor set layout.");
+        layout = device.getDescriptorLayoutCache().getLayout(setLayoutBindings, flags);
     }
 
     VkWriteDescriptorSet DescriptorSetLayout::writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo){
@@ -100,4 +96,183 @@ namespace Renderer{
         newWrite.pImageInfo = imageInfo;
         return newWrite;
     }
+
+    DescriptorLayoutCache::DescriptorLayoutCache(Device& device) : device{device}{}
+
+    DescriptorLayoutCache::~DescriptorLayoutCache(){
+        for(auto& [hash, info] : layouts)
+            vkDestroyDescriptorSetLayout(device.getDevice(), info.layout, nullptr);
+    }
+
+    uint64_t DescriptorLayoutCache::hashBindings(const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayoutCreateFlags flags){
+        // FNV-1a, 64 bit, over the fields that make two layouts compatible
+        uint64_t hash = 14695981039346656037ull;
+        auto combine = [&hash](uint64_t value){
+            for(int i = 0; i < 8; i++){
+                hash ^= (value >> (i * 8)) & 0xFF;
+                hash *= 1099511628211ull;
+            }
+        };
+        combine(flags);
+        for(const auto& binding : bindings){
+            combine(binding.binding);
+            combine(binding.descriptorType);
+            combine(binding.descriptorCount);
+            combine(binding.stageFlags);
+            combine(binding.pImmutableSamplers != nullptr);
+            if(binding.pImmutableSamplers != nullptr)
+                for(uint32_t i = 0; i < binding.descriptorCount; i++)
+                    combine(std::hash<VkSampler>{}(binding.pImmutableSamplers[i]));
+        }
+        return hash;
+    }
+
+    bool DescriptorLayoutCache::sameBinding(const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b){
+        if(a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags)
+            return false;
+        if((a.pImmutableSamplers == nullptr) != (b.pImmutableSamplers == nullptr))
+            return false;
+        return a.pImmutableSamplers == nullptr || std::equal(a.pImmutableSamplers, a.pImmutableSamplers + a.descriptorCount, b.pImmutableSamplers);
+    }
+
+    VkDescriptorSetLayout DescriptorLayoutCache::getLayout(std::vector<VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags){
+        std::sort(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b){
+            return a.binding < b.binding;
+        });
+        uint64_t hash = hashBindings(bindings, flags);
+
+        std::lock_guard<std::mutex> lock{mutex};
+        auto [begin, end] = layouts.equal_range(hash);
+        for(auto it = begin; it != end; ++it){
+            const LayoutInfo& info = it->second;
+            if(info.flags == flags && std::equal(info.bindings.begin(), info.bindings.end(), bindings.begin(), bindings.end(), sameBinding))
+                return info.layout;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+        layoutInfo.flags = flags;
+
+        VkDescriptorSetLayout layout;
+        if(vkCreateDescriptorSetLayout(device.getDevice(), &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create descriptor set layout.");
+
+        LayoutInfo& info = layouts.emplace(hash, LayoutInfo{std::move(bindings), {}, flags, layout})->second;
+        for(const auto& binding : info.bindings)
+            if(binding.pImmutableSamplers != nullptr)
+                info.immutableSamplers.insert(info.immutableSamplers.end(), binding.pImmutableSamplers, binding.pImmutableSamplers + binding.descriptorCount);
+        const VkSampler* samplers = info.immutableSamplers.data();
+        for(auto& binding : info.bindings)
+            if(binding.pImmutableSamplers != nullptr){
+                binding.pImmutableSamplers = samplers;
+                samplers += binding.descriptorCount;
+            }
+        return layout;
+    }
+
+    size_t DescriptorLayoutCache::getLayoutCount(){
+        std::lock_guard<std::mutex> lock{mutex};
+        return layouts.size();
+    }
+
+    DescriptorAllocator::DescriptorAllocator(Device& device, std::vector<PoolSizeRatio> ratios, uint32_t initialSetsPerPool) 
+    : device{device}, ratios{std::move(ratios)}, setsPerPool{initialSetsPerPool}{}
+
+    DescriptorAllocator::~DescriptorAllocator(){
+        if(currentPool != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(device.getDevice(), currentPool, nullptr);
+        for(auto pool : fullPools)
+            vkDestroyDescriptorPool(device.getDevice(), pool, nullptr);
+        for(auto pool : freePools)
+            vkDestroyDescriptorPool(device.getDevice(), pool, nullptr);
+    }
+
+    std::vector<DescriptorAllocator::PoolSizeRatio> DescriptorAllocator::defaultRatios(){
+        return {
+            {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.f},
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f},
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f},
+            {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.f},
+            {VK_DESCRIPTOR_TYPE_SAMPLER, 1.f},
+            {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f}
+        };
+    }
+
+    VkDescriptorPool DescriptorAllocator::createPool(uint32_t setCount){
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        for(const auto& ratio : ratios){
+            VkDescriptorPoolSize poolSize = {};
+            poolSize.type = ratio.type;
+            poolSize.descriptorCount = std::max(1u, static_cast<uint32_t>(std::ceil(ratio.ratio * setCount)));
+            poolSizes.push_back(poolSize);
+        }
+
+        VkDescriptorPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = setCount;
+
+        VkDescriptorPool pool;
+        if(vkCreateDescriptorPool(device.getDevice(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create descriptor pool.");
+        return pool;
+    }
+
+    VkDescriptorPool DescriptorAllocator::grabPool(){
+        if(!freePools.empty()){
+            VkDescriptorPool pool = freePools.back();
+            freePools.pop_back();
+            return pool;
+        }
+
+        // Each new pool is larger than the last, so a growing scene needs few pools
+        VkDescriptorPool pool = createPool(setsPerPool);
+        setsPerPool = std::min(setsPerPool + setsPerPool / 2, maxSetsPerPool);
+        return pool;
+    }
+
+    VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout){
+        if(currentPool == VK_NULL_HANDLE)
+            currentPool = grabPool();
+
+        VkDescriptorSetAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = currentPool;
+        allocInfo.pSetLayouts = &layout;
+        allocInfo.descriptorSetCount = 1;
+
+        VkDescriptorSet set;
+        VkResult result = vkAllocateDescriptorSets(device.getDevice(), &allocInfo, &set);
+        if(result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL){
+            // Retire the pool until the next reset and retry once on a fresh one
+            fullPools.push_back(currentPool);
+            currentPool = grabPool();
+            allocInfo.descriptorPool = currentPool;
+            result = vkAllocateDescriptorSets(device.getDevice(), &allocInfo, &set);
+        }
+
+        if(result != VK_SUCCESS)
+            throw std::runtime_error("Failed to allocate descriptor set.");
+        return set;
+    }
+
+    void DescriptorAllocator::updateSet(VkDescriptorSet set, std::vector<VkWriteDescriptorSet> writes){
+        for(auto& write : writes)
+            write.dstSet = set;
+        vkUpdateDescriptorSets(device.getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    void DescriptorAllocator::reset(){
+        if(currentPool != VK_NULL_HANDLE)
+            fullPools.push_back(currentPool);
+        currentPool = VK_NULL_HANDLE;
+        for(auto pool : fullPools){
+            vkResetDescriptorPool(device.getDevice(), pool, 0);
+            freePools.push_back(pool);
+        }
+        fullPools.clear();
+    }
 }
\ No newline at end of file
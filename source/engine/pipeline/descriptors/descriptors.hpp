@@ -5,6 +5,7 @@
 
 #include <vector>
 #include <unordered_map>
+#include <mutex>
 #include <cassert>
 
 namespace Renderer{
@@ -15,6 +16,7 @@ namespace Renderer{
 
             VkDescriptorSetLayout getLayout() { return layout; }
             void addBinding(uint32_t descriptorCount, VkDescriptorType type, VkShaderStageFlags stageFlags, VkSampler* pImmutableSamplers = nullptr);
+            // The layout comes from the device's DescriptorLayoutCache, which owns it, so identical layouts are shared
             void buildLayout(VkDescriptorSetLayoutCreateFlags flags = 0);
 
             VkWriteDescriptorSet writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo);
@@ -33,7 +35,7 @@ namespace Renderer{
             DescriptorPool(Device& device);
             ~DescriptorPool();
 
-            std::vector<VkDescriptorSet> getSets() { return allocatedSets; }
+            const std::vector<VkDescriptorSet>& getSets() const { return allocatedSets; }
 
             void addPoolSize(VkDescriptorType type, uint32_t count);
             void buildPool(uint32_t maxSets, VkDescriptorPoolCreateFlags flags = 0);
@@ -46,4 +48,75 @@ namespace Renderer{
             std::vector<VkDescriptorPoolSize> poolSizes;
             std::vector<VkDescriptorSet> allocatedSets;
     };
+
+    // Owns every descriptor set layout, keyed by a hash of the bindings so systems asking for the same layout share one.
+    // Layouts live until the device is destroyed.
+    class DescriptorLayoutCache{
+        public:
+            DescriptorLayoutCache(Device& device);
+            ~DescriptorLayoutCache();
+
+            DescriptorLayoutCache(const DescriptorLayoutCache&) = delete;
+            DescriptorLayoutCache& operator=(const DescriptorLayoutCache&) = delete;
+
+            VkDescriptorSetLayout getLayout(std::vector<VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags = 0);
+            size_t getLayoutCount();
+
+        private:
+            struct LayoutInfo{
+                std::vector<VkDescriptorSetLayoutBinding> bindings;     // Sorted by binding, pImmutableSamplers point into immutableSamplers
+                std::vector<VkSampler> immutableSamplers;               // Copied, the caller's arrays may not outlive the call
+                VkDescriptorSetLayoutCreateFlags flags;
+                VkDescriptorSetLayout layout;
+            };
+
+            static uint64_t hashBindings(const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayoutCreateFlags flags);
+            // Immutable samplers are compared by the handles they hold, not by where the caller's array lives
+            static bool sameBinding(const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b);
+
+            Device& device;
+            std::mutex mutex;
+            std::unordered_multimap<uint64_t, LayoutInfo> layouts;
+    };
+
+    // Allocates sets from a list of pools, creating a larger pool whenever the current one runs out instead of failing.
+    // For transient sets keep one allocator per frame in flight and reset() it once the frame's fence has signalled,
+    // which recycles every pool at once rather than freeing sets individually.
+    class DescriptorAllocator{
+        public:
+            // Descriptors of each type per set, scaled by the pool's set count to size new pools
+            struct PoolSizeRatio{
+                VkDescriptorType type;
+                float ratio;
+            };
+
+            DescriptorAllocator(Device& device, std::vector<PoolSizeRatio> ratios = defaultRatios(), uint32_t initialSetsPerPool = 64);
+            ~DescriptorAllocator();
+
+            DescriptorAllocator(const DescriptorAllocator&) = delete;
+            DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+            VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+            void updateSet(VkDescriptorSet set, std::vector<VkWriteDescriptorSet> writes);
+            // Invalidates every set allocated so far, pools are kept for reuse
+            void reset();
+
+            size_t getPoolCount() const { return fullPools.size() + freePools.size() + (currentPool != VK_NULL_HANDLE ? 1 : 0); }
+
+            static std::vector<PoolSizeRatio> defaultRatios();
+
+        private:
+            VkDescriptorPool grabPool();
+            VkDescriptorPool createPool(uint32_t setCount);
+
+            static constexpr uint32_t maxSetsPerPool = 4096;
+
+            Device& device;
+            std::vector<PoolSizeRatio> ratios;
+            uint32_t setsPerPool;
+
+            VkDescriptorPool currentPool = VK_NULL_HANDLE;
+            std::vector<VkDescriptorPool> fullPools;
+            std::vector<VkDescriptorPool> freePools;
+    };
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include "embedded_shaders.hpp"
+
+#include <filesystem>
+#include <cstdlib>
+#include <cstring>
+
+namespace Renderer{
+#ifdef RENDERER_EMBED_SHADERS
+    // Defined in the embedded_shaders.cpp generated into the build directory
+    extern const EmbeddedShader embeddedShaders[];
+    extern const size_t embeddedShaderCount;
+#else
+    static const EmbeddedShader* embeddedShaders = nullptr;
+    static const size_t embeddedShaderCount = 0;
+#endif
+
+    const EmbeddedShader* findEmbeddedShader(const std::string& filepath){
+        std::string name = std::filesystem::path(filepath).filename().string();
+        for(size_t i = 0; i < embeddedShaderCount; i++){
+            if(std::strcmp(embeddedShaders[i].name, name.c_str()) == 0)
+                return &embeddedShaders[i];
+        }
+        return nullptr;
+    }
+
+    const std::string& getShaderOverrideDirectory(){
+        static const std::string directory = []{
+            const char* value = std::getenv("RENDERER_SHADER_DIR");
+            return std::string(value != nullptr ? value : "");
+        }();
+        return directory;
+    }
+}
\ No newline at end of file
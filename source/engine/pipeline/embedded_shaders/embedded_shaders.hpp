@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace Renderer{
+    // SPIR-V compiled by the Shaders target and linked into the executable as constexpr arrays (see cmake/embed_shaders.cmake),
+    // so the shipped shaders load without any file IO. Disabled with RENDERER_EMBED_SHADERS=OFF.
+    struct EmbeddedShader{
+        const char* name;       // File name of the compiled shader, e.g. "main.vert.spv"
+        const uint32_t* code;
+        size_t size;            // In bytes
+    };
+
+    // Looks the shader up by the file name part of filepath, nullptr if it isn't embedded
+    const EmbeddedShader* findEmbeddedShader(const std::string& filepath);
+
+    // Directory from the RENDERER_SHADER_DIR environment variable, shaders found there are loaded in place of the
+    // embedded ones so they can be rebuilt without relinking. Empty if not set.
+    const std::string& getShaderOverrideDirectory();
+}
\ No newline at end of file
@@ -1,10 +1,13 @@
 #include "pipeline.hpp"
 
 #include "engine/mesh/model.hpp"
+#include "engine/pipeline/pipeline_cache/pipeline_cache.hpp"
+#include "engine/pipeline/shader_registry/shader_registry.hpp"
 
 #include <fstream>
 #include <iostream>
 #include <cassert>
+#include <algorithm>
 
 namespace Renderer{
     GraphicsPipeline::GraphicsPipeline(Device& device, const std::string& vertFilepath, const std::string& fragFilepath, const GraphicsPipelineConfigInfo& configInfo) : device{device}{
@@ -17,10 +20,12 @@ namespace Renderer{
 
     void GraphicsPipeline::createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const GraphicsPipelineConfigInfo& configInfo){
         assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline: no pipelineLayout provided in configInfo.");
-        assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline: no renderPass provided in configInfo.");
+        assert((configInfo.renderTarget.renderPass != VK_NULL_HANDLE || device.supportsDynamicRendering()) && "Cannot create graphics pipeline: no renderPass provided in configInfo.");
 
-        vertShaderModule = std::make_unique<ShaderModule>(device, vertFilepath);
-        fragShaderModule = std::make_unique<ShaderModule>(device, fragFilepath);
+        vertShaderModule = device.getShaderRegistry().getModule(vertFilepath, configInfo.shaderDefines);
+        fragShaderModule = device.getShaderRegistry().getModule(fragFilepath, configInfo.shaderDefines);
+        pipelineLayout = configInfo.pipelineLayout;
+        pushConstantRange = combinePushConstantBlocks(*vertShaderModule, *fragShaderModule);
 
         VkPipelineShaderStageCreateInfo shaderStages[2];
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -29,14 +34,14 @@ namespace Renderer{
         shaderStages[0].pName = "main";
         shaderStages[0].flags = 0;
         shaderStages[0].pNext = nullptr;
-        shaderStages[0].pSpecializationInfo = nullptr;
+        shaderStages[0].pSpecializationInfo = configInfo.specialization.getInfo();
         shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
         shaderStages[1].module = fragShaderModule->getShaderModule();
         shaderStages[1].pName = "main";
         shaderStages[1].flags = 0;
         shaderStages[1].pNext = nullptr;
-        shaderStages[1].pSpecializationInfo = nullptr;
+        shaderStages[1].pSpecializationInfo = configInfo.specialization.getInfo();
 
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -51,7 +56,7 @@ namespace Renderer{
         VkPipelineMultisampleStateCreateInfo multisampleInfo{};
         multisampleInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
         multisampleInfo.sampleShadingEnable = VK_FALSE;
-        multisampleInfo.rasterizationSamples = device.getMaxUsableSampleCount();
+        multisampleInfo.rasterizationSamples = configInfo.renderTarget.samples;
         multisampleInfo.minSampleShading = 1.0f;           
         multisampleInfo.pSampleMask = nullptr;           
         multisampleInfo.alphaToCoverageEnable = VK_FALSE;
@@ -71,14 +76,49 @@ namespace Renderer{
         pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
 
         pipelineInfo.layout = configInfo.pipelineLayout;
-        pipelineInfo.renderPass = configInfo.renderPass;
+        pipelineInfo.renderPass = configInfo.renderTarget.renderPass;
         pipelineInfo.subpass = configInfo.subpass;
 
+        // Without a render pass the attachment formats are all the pipeline is compiled against
+        VkPipelineRenderingCreateInfo renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+        renderingInfo.colorAttachmentCount = static_cast<uint32_t>(configInfo.renderTarget.colourFormats.size());
+        renderingInfo.pColorAttachmentFormats = configInfo.renderTarget.colourFormats.data();
+        renderingInfo.depthAttachmentFormat = configInfo.renderTarget.depthFormat;
+        renderingInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+
         pipelineInfo.basePipelineIndex = -1;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        if(vkCreateGraphicsPipelines(device.getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
+        PipelineCache& pipelineCache = device.getPipelineCache();
+        VkPipelineCreationFeedbackCreateInfo feedbackInfo;
+        VkPipelineCreationFeedback feedback{};
+        pipelineInfo.pNext = pipelineCache.prepareFeedback(feedbackInfo, feedback, configInfo.renderTarget.renderPass == VK_NULL_HANDLE ? &renderingInfo : nullptr);
+
+        if(vkCreateGraphicsPipelines(device.getDevice(), pipelineCache.getCache(), 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
             throw std::runtime_error("Failed to create graphics pipeline.");
+        pipelineCache.recordFeedback(feedback);
+    }
+
+    VkPushConstantRange GraphicsPipeline::reflectPushConstantRange(Device& device, const std::string& vertFilepath, const std::string& fragFilepath, const std::vector<ShaderCompiler::Define>& defines){
+        auto vertModule = device.getShaderRegistry().getModule(vertFilepath, defines);
+        auto fragModule = device.getShaderRegistry().getModule(fragFilepath, defines);
+        return combinePushConstantBlocks(*vertModule, *fragModule);
+    }
+
+    VkPushConstantRange GraphicsPipeline::combinePushConstantBlocks(ShaderModule& vertShaderModule, ShaderModule& fragShaderModule){
+        VkPushConstantRange range{};
+        uint32_t end = 0;
+        for(auto [module, stage] : {std::make_pair(&vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT), std::make_pair(&fragShaderModule, VK_SHADER_STAGE_FRAGMENT_BIT)}){
+            PushConstantBlock block = module->getPushConstantBlock();
+            if(block.size == 0)
+                continue;
+            range.offset = range.stageFlags == 0 ? block.offset : std::min(range.offset, block.offset);
+            end = std::max(end, block.offset + block.size);
+            range.stageFlags |= stage;
+        }
+        range.size = range.stageFlags == 0 ? 0 : end - range.offset;
+        return range;
     }
 
     void GraphicsPipeline::bind(VkCommandBuffer commandBuffer){
@@ -148,35 +188,41 @@ namespace Renderer{
         configInfo.attributeDescriptions = Model::Vertex::getAttributeDescriptions();
     }
 
-    ComputePipeline::ComputePipeline(Device& device, const std::string& compFilepath, VkPipelineLayout layout) : device{device}{    
-        createComputePipeline(compFilepath, layout);
+    ComputePipeline::ComputePipeline(Device& device, const std::string& compFilepath, VkPipelineLayout layout, const SpecializationConstants& specialization, const std::vector<ShaderCompiler::Define>& defines) : device{device}{    
+        createComputePipeline(compFilepath, layout, specialization, defines);
     }
 
     ComputePipeline::~ComputePipeline(){
         vkDestroyPipeline(device.getDevice(), computePipeline, nullptr);
     }
 
-    void ComputePipeline::createComputePipeline(const std::string& compFilepath, VkPipelineLayout layout){
-        compShaderModule = std::make_unique<ShaderModule>(device, compFilepath);
+    void ComputePipeline::createComputePipeline(const std::string& compFilepath, VkPipelineLayout layout, const SpecializationConstants& specialization, const std::vector<ShaderCompiler::Define>& defines){
+        compShaderModule = device.getShaderRegistry().getModule(compFilepath, defines);
 
         VkPipelineShaderStageCreateInfo shaderStage;
-        shaderStage.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
         shaderStage.module = compShaderModule->getShaderModule();
         shaderStage.pName = "main";
         shaderStage.flags = 0;
         shaderStage.pNext = nullptr;
-        shaderStage.pSpecializationInfo = nullptr;
+        shaderStage.pSpecializationInfo = specialization.getInfo();
 
-        VkComputePipelineCreateInfo pipelineInfo;
+        VkComputePipelineCreateInfo pipelineInfo = {};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
         pipelineInfo.stage = shaderStage;
         pipelineInfo.layout = layout;
-        pipelineInfo.basePipelineIndex = 0;
+        pipelineInfo.basePipelineIndex = -1;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        if(vkCreateComputePipelines(device.getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS)
+        PipelineCache& pipelineCache = device.getPipelineCache();
+        VkPipelineCreationFeedbackCreateInfo feedbackInfo;
+        VkPipelineCreationFeedback feedback{};
+        pipelineInfo.pNext = pipelineCache.prepareFeedback(feedbackInfo, feedback);
+
+        if(vkCreateComputePipelines(device.getDevice(), pipelineCache.getCache(), 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS)
             throw std::runtime_error("Failed to create compute pipeline.");
+        pipelineCache.recordFeedback(feedback);
     }
 
     void ComputePipeline::bind(VkCommandBuffer commandBuffer){
@@ -184,7 +230,16 @@ namespace Renderer{
     }
 
     ShaderModule::ShaderModule(Device& device, const std::string& filepath) : device{device}{
-        createShaderModule(readFile(filepath));
+        std::vector<char> code = readFile(filepath);
+        createShaderModule(reinterpret_cast<const uint32_t*>(code.data()), code.size());
+    }
+
+    ShaderModule::ShaderModule(Device& device, const std::vector<char>& code) : device{device}{
+        createShaderModule(reinterpret_cast<const uint32_t*>(code.data()), code.size());
+    }
+
+    ShaderModule::ShaderModule(Device& device, const uint32_t* code, size_t size) : device{device}{
+        createShaderModule(code, size);
     }
 
     ShaderModule::~ShaderModule(){
@@ -207,11 +262,13 @@ namespace Renderer{
         return buffer;
     }
 
-    void ShaderModule::createShaderModule(const std::vector<char>& code){
+    void ShaderModule::createShaderModule(const uint32_t* code, size_t size){
+        pushConstantBlock = reflectPushConstants(code, size);
+
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+        createInfo.codeSize = size;
+        createInfo.pCode = code;
 
         if (vkCreateShaderModule(device.getDevice(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
             throw std::runtime_error("Failed to create shader module.");
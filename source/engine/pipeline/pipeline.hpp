@@ -1,11 +1,28 @@
 #pragma once
 
 #include "engine/device/device.hpp"
+#include "engine/pipeline/shader_compiler/shader_compiler.hpp"
+#include "engine/pipeline/specialization/specialization.hpp"
+#include "engine/pipeline/shader_reflection/shader_reflection.hpp"
 
 #include <vector>
 #include <memory>
+#include <string>
+#include <cassert>
 
 namespace Renderer{
+    // The attachments a graphics pipeline draws into. With dynamic rendering renderPass is VK_NULL_HANDLE and the pipeline
+    // is created against the formats alone, otherwise it is created against renderPass, which must have the same formats.
+    struct RenderTargetInfo{
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        std::vector<VkFormat> colourFormats{};
+        VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+        // Pipelines built for one target can be used with the other
+        bool isCompatible(const RenderTargetInfo& other) const { return colourFormats == other.colourFormats && depthFormat == other.depthFormat && samples == other.samples; }
+    };
+
     struct GraphicsPipelineConfigInfo {
         GraphicsPipelineConfigInfo(const GraphicsPipelineConfigInfo&) = delete;
         GraphicsPipelineConfigInfo& operator=(const GraphicsPipelineConfigInfo&) = delete;
@@ -21,23 +38,37 @@ namespace Renderer{
         std::vector<VkDynamicState> dynamicStateEnables;
         VkPipelineDynamicStateCreateInfo dynamicStateInfo;
         VkPipelineLayout pipelineLayout = nullptr;
-        VkRenderPass renderPass = nullptr;
+        RenderTargetInfo renderTarget{};
         uint32_t subpass = 0;
+        // Preprocessor defines for shaders given as GLSL source, ignored for precompiled SPIR-V
+        std::vector<ShaderCompiler::Define> shaderDefines{};
+        // Applied to both stages, each stage only picks up the constant IDs it declares
+        SpecializationConstants specialization{};
     };
 
     class ShaderModule{
         public:
             ShaderModule(Device& device, const std::string& filepath);
+            ShaderModule(Device& device, const std::vector<char>& code);
+            // size is in bytes, e.g. an EmbeddedShader
+            ShaderModule(Device& device, const uint32_t* code, size_t size);
             ~ShaderModule();
 
+            ShaderModule(const ShaderModule&) = delete;
+            ShaderModule& operator=(const ShaderModule&) = delete;
+
             VkShaderModule getShaderModule() { return shaderModule; }
+            // Reflected from the SPIR-V when the module is created
+            PushConstantBlock getPushConstantBlock() const { return pushConstantBlock; }
 
-        private:
             static std::vector<char> readFile(const std::string& filepath);
-            void createShaderModule(const std::vector<char>& code);
+
+        private:
+            void createShaderModule(const uint32_t* code, size_t size);
 
             Device& device;
             VkShaderModule shaderModule;
+            PushConstantBlock pushConstantBlock;
     };
 
     class GraphicsPipeline{
@@ -46,28 +77,43 @@ namespace Renderer{
             ~GraphicsPipeline();
 
             static void defaultPipelineConfigInfo(GraphicsPipelineConfigInfo& configInfo);
+            // Union of the push constant blocks of both shaders for the pipeline layout, size 0 if neither declares one.
+            // The modules are loaded through the ShaderRegistry, so the pipeline built afterwards reuses them.
+            static VkPushConstantRange reflectPushConstantRange(Device& device, const std::string& vertFilepath, const std::string& fragFilepath, const std::vector<ShaderCompiler::Define>& defines = {});
+
             void bind(VkCommandBuffer commandBuffer);
 
+            // Per-draw data through the reflected push constant block, T must match its layout from offset
+            template<typename T>
+            void push(VkCommandBuffer commandBuffer, const T& data, uint32_t offset = 0){
+                assert(offset + sizeof(T) <= pushConstantRange.offset + pushConstantRange.size && "Push constant data is larger than the shaders' push constant block.");
+                vkCmdPushConstants(commandBuffer, pipelineLayout, pushConstantRange.stageFlags, offset, sizeof(T), &data);
+            }
+
         private:
             void createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const GraphicsPipelineConfigInfo& configInfo);
+            static VkPushConstantRange combinePushConstantBlocks(ShaderModule& vertShaderModule, ShaderModule& fragShaderModule);
 
             Device& device;
             VkPipeline graphicsPipeline;
-            std::unique_ptr<ShaderModule> vertShaderModule, fragShaderModule;
+            VkPipelineLayout pipelineLayout;
+            VkPushConstantRange pushConstantRange;
+            // Shared through the device's ShaderRegistry
+            std::shared_ptr<ShaderModule> vertShaderModule, fragShaderModule;
     };
 
     class ComputePipeline{
         public:
-            ComputePipeline(Device& device, const std::string& compFilepath, VkPipelineLayout layout);
+            ComputePipeline(Device& device, const std::string& compFilepath, VkPipelineLayout layout, const SpecializationConstants& specialization = {}, const std::vector<ShaderCompiler::Define>& defines = {});
             ~ComputePipeline();
 
             void bind(VkCommandBuffer commandBuffer);
         
         private:
-            void createComputePipeline(const std::string& compFilepath, VkPipelineLayout layout);
+            void createComputePipeline(const std::string& compFilepath, VkPipelineLayout layout, const SpecializationConstants& specialization, const std::vector<ShaderCompiler::Define>& defines);
 
             Device& device;
             VkPipeline computePipeline;
-            std::unique_ptr<ShaderModule> compShaderModule;
+            std::shared_ptr<ShaderModule> compShaderModule;
     };
 }
\ No newline at end of file
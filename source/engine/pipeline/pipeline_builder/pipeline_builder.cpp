@@ -0,0 +1,82 @@
+#include "pipeline_builder.hpp"
+
+#include <algorithm>
+
+namespace Renderer{
+    PipelineBuilder::PipelineBuilder(Device& device, uint32_t threadCount) 
+    : device{device}, compilePool{threadCount == 0 ? defaultThreadCount() : threadCount, "Pipeline Compiler"}{}
+
+    PipelineBuilder::~PipelineBuilder(){
+        waitIdle();
+    }
+
+    template<typename T>
+    PendingPipeline<T> PipelineBuilder::enqueue(std::function<std::shared_ptr<T>()> build){
+        auto promise = std::make_shared<std::promise<std::shared_ptr<T>>>();
+        PendingPipeline<T> pending{promise->get_future().share()};
+
+        std::shared_future<void> done = compilePool.submit([promise, build]{
+            try{
+                promise->set_value(build());
+            }
+            catch(...){
+                promise->set_exception(std::current_exception());
+            }
+        }).share();
+
+        std::lock_guard<std::mutex> lock{mutex};
+        // Drop finished builds so the list doesn't grow for the lifetime of the app
+        pendingBuilds.erase(std::remove_if(pendingBuilds.begin(), pendingBuilds.end(), [](const std::shared_future<void>& build){
+            return build.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }), pendingBuilds.end());
+        pendingBuilds.push_back(done);
+        return pending;
+    }
+
+    PendingPipeline<GraphicsPipeline> PipelineBuilder::buildGraphics(const GraphicsRequest& request){
+        Device& device = this->device;
+        return enqueue<GraphicsPipeline>([&device, request]{
+            GraphicsPipelineConfigInfo configInfo{};
+            GraphicsPipeline::defaultPipelineConfigInfo(configInfo);
+            if(request.configure)
+                request.configure(configInfo);
+            return std::make_shared<GraphicsPipeline>(device, request.vertFilepath, request.fragFilepath, configInfo);
+        });
+    }
+
+    std::vector<PendingPipeline<GraphicsPipeline>> PipelineBuilder::buildGraphics(const std::vector<GraphicsRequest>& requests){
+        std::vector<PendingPipeline<GraphicsPipeline>> pipelines;
+        pipelines.reserve(requests.size());
+        for(const auto& request : requests)
+            pipelines.push_back(buildGraphics(request));
+        return pipelines;
+    }
+
+    PendingPipeline<ComputePipeline> PipelineBuilder::buildCompute(const std::string& compFilepath, VkPipelineLayout layout, const SpecializationConstants& specialization, const std::vector<ShaderCompiler::Define>& defines){
+        Device& device = this->device;
+        return enqueue<ComputePipeline>([&device, compFilepath, layout, specialization, defines]{
+            return std::make_shared<ComputePipeline>(device, compFilepath, layout, specialization, defines);
+        });
+    }
+
+    uint32_t PipelineBuilder::defaultThreadCount(){
+        return std::max(std::thread::hardware_concurrency() / 4, 1u);
+    }
+
+    bool PipelineBuilder::isIdle(){
+        std::lock_guard<std::mutex> lock{mutex};
+        return std::all_of(pendingBuilds.begin(), pendingBuilds.end(), [](const std::shared_future<void>& build){
+            return build.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        });
+    }
+
+    void PipelineBuilder::waitIdle(){
+        std::vector<std::shared_future<void>> builds;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            builds.swap(pendingBuilds);
+        }
+        for(auto& build : builds)
+            build.wait();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "engine/pipeline/pipeline.hpp"
+#include "engine/threading/thread_pool.hpp"
+
+#include <future>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <chrono>
+
+namespace Renderer{
+    // A pipeline that may still be compiling on a worker thread
+    template<typename T>
+    class PendingPipeline{
+        public:
+            PendingPipeline() = default;
+            PendingPipeline(std::shared_future<std::shared_ptr<T>> future) : future{std::move(future)} {}
+
+            bool isValid() const { return future.valid(); }
+            bool isReady() const { return pipeline != nullptr || (future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready); }
+
+            // Returns nullptr while the pipeline is still compiling, rethrows if compilation failed
+            T* tryGet(){
+                if(pipeline == nullptr && isReady())
+                    pipeline = future.get();
+                return pipeline.get();
+            }
+
+            T& wait(){
+                if(pipeline == nullptr)
+                    pipeline = future.get();
+                return *pipeline;
+            }
+
+        private:
+            std::shared_future<std::shared_ptr<T>> future;
+            std::shared_ptr<T> pipeline;
+    };
+
+    // Compiles pipelines on its own worker threads into the device's shared VkPipelineCache, so the application can start
+    // rendering while the remaining variants are built. Compiles take milliseconds each, so they are kept off the shared
+    // ThreadPool where per-frame culling, sorting and recording would queue behind them.
+    class PipelineBuilder{
+        public:
+            // Called on the worker thread after defaultPipelineConfigInfo, to fill in the layout, render pass and any overrides
+            using ConfigureFunction = std::function<void(GraphicsPipelineConfigInfo& configInfo)>;
+
+            struct GraphicsRequest{
+                std::string vertFilepath;
+                std::string fragFilepath;
+                ConfigureFunction configure;
+            };
+
+            // A thread count of 0 uses a quarter of the hardware threads, at least one
+            PipelineBuilder(Device& device, uint32_t threadCount = 0);
+            // Waits for every queued pipeline, the pipelines themselves stay alive as long as they are referenced
+            ~PipelineBuilder();
+
+            PipelineBuilder(const PipelineBuilder&) = delete;
+            PipelineBuilder& operator=(const PipelineBuilder&) = delete;
+
+            PendingPipeline<GraphicsPipeline> buildGraphics(const GraphicsRequest& request);
+            std::vector<PendingPipeline<GraphicsPipeline>> buildGraphics(const std::vector<GraphicsRequest>& requests);
+            PendingPipeline<ComputePipeline> buildCompute(const std::string& compFilepath, VkPipelineLayout layout, const SpecializationConstants& specialization = {}, const std::vector<ShaderCompiler::Define>& defines = {});
+
+            void waitIdle();
+            // True once every queued pipeline has finished building
+            bool isIdle();
+
+        private:
+            template<typename T>
+            PendingPipeline<T> enqueue(std::function<std::shared_ptr<T>()> build);
+
+            static uint32_t defaultThreadCount();
+
+            Device& device;
+
+            std::mutex mutex;
+            std::vector<std::shared_future<void>> pendingBuilds;
+
+            // Declared last so its workers are joined before the state they use is destroyed
+            ThreadPool compilePool;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "pipeline_cache.hpp"
+
+#include "engine/device/device.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <stdexcept>
+#include <cstring>
+
+namespace Renderer{
+    PipelineCache::PipelineCache(Device& device, const std::string& filepath) : device{device}, filepath{filepath}{
+        std::vector<char> data;
+        std::ifstream file{filepath, std::ios::ate | std::ios::binary};
+        if(file.is_open()){
+            data.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(data.data(), data.size());
+        }
+
+        loadedFromDisk = !data.empty() && isCompatible(data);
+        if(!data.empty() && !loadedFromDisk)
+            std::cout << "Pipeline cache " << filepath << " is from another device or driver, starting with an empty cache." << std::endl;
+
+        VkPipelineCacheCreateInfo cacheInfo = {};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = loadedFromDisk ? data.size() : 0;
+        cacheInfo.pInitialData = loadedFromDisk ? data.data() : nullptr;
+
+        if(vkCreatePipelineCache(device.getDevice(), &cacheInfo, nullptr, &cache) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create pipeline cache.");
+    }
+
+    PipelineCache::~PipelineCache(){
+        try{
+            save();
+        }
+        catch(const std::exception& e){
+            std::cerr << e.what() << std::endl;
+        }
+        printStats();
+        vkDestroyPipelineCache(device.getDevice(), cache, nullptr);
+    }
+
+    bool PipelineCache::isCompatible(const std::vector<char>& data) const {
+        VkPipelineCacheHeaderVersionOne header;
+        if(data.size() < sizeof(header))
+            return false;
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        const VkPhysicalDeviceProperties& properties = device.getProperties();
+        return header.headerSize >= sizeof(header)
+            && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            && header.vendorID == properties.vendorID
+            && header.deviceID == properties.deviceID
+            && std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    void PipelineCache::save(){
+        size_t size = 0;
+        if(vkGetPipelineCacheData(device.getDevice(), cache, &size, nullptr) != VK_SUCCESS)
+            throw std::runtime_error("Failed to get pipeline cache size.");
+        std::vector<char> data(size);
+        if(vkGetPipelineCacheData(device.getDevice(), cache, &size, data.data()) != VK_SUCCESS)
+            throw std::runtime_error("Failed to get pipeline cache data.");
+
+        std::string temporaryFilepath = filepath + ".tmp";
+        {
+            std::ofstream file{temporaryFilepath, std::ios::binary | std::ios::trunc};
+            if(!file.is_open())
+                throw std::runtime_error("Failed to open file: " + temporaryFilepath);
+            file.write(data.data(), size);
+            if(!file)
+                throw std::runtime_error("Failed to write pipeline cache: " + temporaryFilepath);
+        }
+        std::filesystem::rename(temporaryFilepath, filepath);
+    }
+
+    const void* PipelineCache::prepareFeedback(VkPipelineCreationFeedbackCreateInfo& feedbackInfo, VkPipelineCreationFeedback& feedback, const void* pNext){
+        if(device.getProperties().apiVersion < VK_API_VERSION_1_3)
+            return pNext;
+
+        feedback = {};
+        feedbackInfo = {};
+        feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+        feedbackInfo.pNext = pNext;
+        feedbackInfo.pPipelineCreationFeedback = &feedback;
+        feedbackInfo.pipelineStageCreationFeedbackCount = 0;
+        return &feedbackInfo;
+    }
+
+    void PipelineCache::recordFeedback(const VkPipelineCreationFeedback& feedback){
+        if(!(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT))
+            return;
+        if(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT)
+            hits++;
+        else
+            misses++;
+        creationNanoseconds += feedback.duration;
+    }
+
+    float PipelineCache::getHitRatio() const {
+        uint32_t total = hits + misses;
+        return total == 0 ? 0.f : static_cast<float>(hits) / total;
+    }
+
+    void PipelineCache::printStats() const {
+        uint32_t total = hits + misses;
+        if(total == 0)
+            return;
+        std::cout << "Pipeline cache: " << hits << "/" << total << " hits (" << getHitRatio() * 100.f << "%), "
+            << creationNanoseconds / 1000000.0 << " ms spent creating pipelines"
+            << (loadedFromDisk ? "" : ", cache was cold") << std::endl;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+namespace Renderer{
+    class Device;
+
+    // VkPipelineCache persisted to disk between runs. The file is only reused if its header matches this device's
+    // vendor, device ID and cache UUID (a driver update changes the UUID), otherwise the cache starts empty.
+    class PipelineCache{
+        public:
+            PipelineCache(Device& device, const std::string& filepath);
+            // Saves the cache before destroying it
+            ~PipelineCache();
+
+            PipelineCache(const PipelineCache&) = delete;
+            PipelineCache& operator=(const PipelineCache&) = delete;
+
+            VkPipelineCache getCache() { return cache; }
+
+            // Writes to a temporary file and renames it over the old one, so a crash mid-write never leaves a truncated cache
+            void save();
+
+            // Fills in the creation feedback to chain into a pipeline create info, or returns nullptr when the device can't
+            // report it (pre Vulkan 1.3). Pass the feedback to recordFeedback once the pipeline is created.
+            const void* prepareFeedback(VkPipelineCreationFeedbackCreateInfo& feedbackInfo, VkPipelineCreationFeedback& feedback, const void* pNext = nullptr);
+            void recordFeedback(const VkPipelineCreationFeedback& feedback);
+
+            uint32_t getHitCount() const { return hits; }
+            uint32_t getMissCount() const { return misses; }
+            float getHitRatio() const;
+            void printStats() const;
+
+        private:
+            bool isCompatible(const std::vector<char>& data) const;
+
+            Device& device;
+            std::string filepath;
+            VkPipelineCache cache = VK_NULL_HANDLE;
+            bool loadedFromDisk = false;
+
+            // Pipelines may be created from several threads
+            std::atomic<uint32_t> hits{0};
+            std::atomic<uint32_t> misses{0};
+            std::atomic<uint64_t> creationNanoseconds{0};
+    };
+}
\ No newline at end of file
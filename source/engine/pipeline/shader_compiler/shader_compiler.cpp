@@ -0,0 +1,232 @@
+#include "shader_compiler.hpp"
+
+#ifdef RENDERER_RUNTIME_SHADER_COMPILATION
+    #include <shaderc/shaderc.h>
+#endif
+
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <stdexcept>
+#include <unordered_set>
+#include <memory>
+#include <iomanip>
+#include <thread>
+#include <functional>
+
+namespace Renderer{
+    namespace{
+        // FNV-1a, 64 bit, chainable through the seed
+        uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull){
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for(size_t i = 0; i < size; i++){
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        uint64_t hashString(const std::string& string, uint64_t hash){
+            // Hash the length too so ("ab", "c") and ("a", "bc") differ
+            uint64_t length = string.size();
+            hash = hashBytes(&length, sizeof(length), hash);
+            return hashBytes(string.data(), string.size(), hash);
+        }
+
+        std::string readTextFile(const std::string& filepath){
+            std::ifstream file{filepath, std::ios::binary};
+            if(!file.is_open())
+                throw std::runtime_error("Failed to open file: " + filepath);
+            std::stringstream contents;
+            contents << file.rdbuf();
+            return contents.str();
+        }
+
+        // Hashes every file reachable through #include directives, resolved relative to the including file. Directives in inactive
+        // #if branches are followed too, so a file that doesn't exist is only hashed by path and left for the compiler to report if used.
+        uint64_t hashIncludes(const std::filesystem::path& filepath, const std::string& source, uint64_t hash, std::unordered_set<std::string>& visited){
+            std::istringstream lines{source};
+            std::string line;
+            while(std::getline(lines, line)){
+                size_t start = line.find_first_not_of(" \t");
+                if(start == std::string::npos || line.compare(start, 8, "#include") != 0)
+                    continue;
+                size_t open = line.find_first_of("\"<", start + 8);
+                size_t close = open == std::string::npos ? std::string::npos : line.find_first_of("\">", open + 1);
+                if(close == std::string::npos)
+                    continue;
+
+                std::filesystem::path includePath = filepath.parent_path() / line.substr(open + 1, close - open - 1);
+                std::string key = includePath.lexically_normal().string();
+                if(!visited.insert(key).second)
+                    continue;
+
+                hash = hashString(key, hash);
+                std::error_code error;
+                if(!std::filesystem::is_regular_file(includePath, error))
+                    continue;
+                std::string includeSource = readTextFile(key);
+                hash = hashString(includeSource, hash);
+                hash = hashIncludes(includePath, includeSource, hash, visited);
+            }
+            return hash;
+        }
+
+    #ifdef RENDERER_RUNTIME_SHADER_COMPILATION
+        struct IncludeData{
+            std::string name;
+            std::string content;
+        };
+
+        shaderc_include_result* resolveInclude(void*, const char* requestedSource, int, const char* requestingSource, size_t){
+            auto data = new IncludeData{};
+            auto result = new shaderc_include_result{};
+            data->name = (std::filesystem::path(requestingSource).parent_path() / requestedSource).lexically_normal().string();
+            try{
+                data->content = readTextFile(data->name);
+            }
+            catch(const std::exception& e){
+                // shaderc reports an empty source name with the content as the error message
+                data->content = e.what();
+                data->name.clear();
+            }
+            result->source_name = data->name.c_str();
+            result->source_name_length = data->name.size();
+            result->content = data->content.c_str();
+            result->content_length = data->content.size();
+            result->user_data = data;
+            return result;
+        }
+
+        void releaseInclude(void*, shaderc_include_result* result){
+            delete static_cast<IncludeData*>(result->user_data);
+            delete result;
+        }
+    #endif
+    }
+
+    ShaderCompiler::ShaderCompiler(const std::string& cacheDirectory) : cacheDirectory{cacheDirectory}{
+    #ifdef RENDERER_RUNTIME_SHADER_COMPILATION
+        compiler = shaderc_compiler_initialize();
+        if(compiler == nullptr)
+            throw std::runtime_error("Failed to initialize shader compiler.");
+    #endif
+    }
+
+    ShaderCompiler::~ShaderCompiler(){
+    #ifdef RENDERER_RUNTIME_SHADER_COMPILATION
+        shaderc_compiler_release(static_cast<shaderc_compiler_t>(compiler));
+    #endif
+    }
+
+    bool ShaderCompiler::isAvailable(){
+    #ifdef RENDERER_RUNTIME_SHADER_COMPILATION
+        return true;
+    #else
+        return false;
+    #endif
+    }
+
+    bool ShaderCompiler::isGlslSource(const std::string& filepath){
+        std::string extension = std::filesystem::path(filepath).extension().string();
+        return extension == ".vert" || extension == ".frag" || extension == ".comp";
+    }
+
+    uint64_t ShaderCompiler::computeKey(const std::string& sourceFilepath, const std::string& source, const std::vector<Define>& defines) const {
+        uint64_t hash = hashString(std::filesystem::path(sourceFilepath).extension().string(), 14695981039346656037ull);
+        hash = hashString(source, hash);
+        std::unordered_set<std::string> visited;
+        hash = hashIncludes(sourceFilepath, source, hash, visited);
+        for(const auto& define : defines){
+            hash = hashString(define.name, hash);
+            hash = hashString(define.value, hash);
+        }
+        return hash;
+    }
+
+    std::vector<char> ShaderCompiler::compile(const std::string& sourceFilepath, const std::vector<Define>& defines){
+        std::string source = readTextFile(sourceFilepath);
+        uint64_t key = computeKey(sourceFilepath, source, defines);
+
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            auto cached = memoryCache.find(key);
+            if(cached != memoryCache.end())
+                return cached->second;
+        }
+
+        std::ostringstream cacheName;
+        cacheName << std::filesystem::path(sourceFilepath).filename().string() << '.' << std::hex << std::setw(16) << std::setfill('0') << key << ".spv";
+        std::filesystem::path cachePath = std::filesystem::path(cacheDirectory) / cacheName.str();
+
+        std::vector<char> code;
+        std::ifstream cacheFile{cachePath, std::ios::ate | std::ios::binary};
+        if(cacheFile.is_open()){
+            code.resize(static_cast<size_t>(cacheFile.tellg()));
+            cacheFile.seekg(0);
+            cacheFile.read(code.data(), code.size());
+        }
+
+        if(code.empty()){
+            code = compileSource(sourceFilepath, source, defines);
+
+            // Written to a per-thread temporary file first so a concurrent or interrupted write never leaves a truncated module behind.
+            // Caching is best effort, a directory that can't be written only costs a recompile next run.
+            std::error_code error;
+            std::filesystem::create_directories(cacheDirectory, error);
+            if(!error){
+                std::ostringstream temporaryName;
+                temporaryName << cacheName.str() << '.' << std::hex << std::hash<std::thread::id>{}(std::this_thread::get_id()) << ".tmp";
+                std::filesystem::path temporaryPath = std::filesystem::path(cacheDirectory) / temporaryName.str();
+                bool written = false;
+                {
+                    std::ofstream file{temporaryPath, std::ios::binary | std::ios::trunc};
+                    file.write(code.data(), code.size());
+                    file.close();
+                    written = !file.fail();
+                }
+                if(written)
+                    std::filesystem::rename(temporaryPath, cachePath, error);
+                if(!written || error)
+                    std::filesystem::remove(temporaryPath, error);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        memoryCache[key] = code;
+        return code;
+    }
+
+    std::vector<char> ShaderCompiler::compileSource(const std::string& sourceFilepath, const std::string& source, const std::vector<Define>& defines) const {
+    #ifdef RENDERER_RUNTIME_SHADER_COMPILATION
+        std::string extension = std::filesystem::path(sourceFilepath).extension().string();
+        shaderc_shader_kind kind = shaderc_glsl_infer_from_source;
+        if(extension == ".vert")
+            kind = shaderc_vertex_shader;
+        else if(extension == ".frag")
+            kind = shaderc_fragment_shader;
+        else if(extension == ".comp")
+            kind = shaderc_compute_shader;
+
+        std::unique_ptr<shaderc_compile_options, decltype(&shaderc_compile_options_release)> options{shaderc_compile_options_initialize(), shaderc_compile_options_release};
+        shaderc_compile_options_set_target_env(options.get(), shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+        shaderc_compile_options_set_optimization_level(options.get(), shaderc_optimization_level_performance);
+        shaderc_compile_options_set_include_callbacks(options.get(), resolveInclude, releaseInclude, nullptr);
+        for(const auto& define : defines)
+            shaderc_compile_options_add_macro_definition(options.get(), define.name.c_str(), define.name.size(), define.value.c_str(), define.value.size());
+
+        std::unique_ptr<shaderc_compilation_result, decltype(&shaderc_result_release)> result{
+            shaderc_compile_into_spv(static_cast<shaderc_compiler_t>(compiler), source.c_str(), source.size(), kind, sourceFilepath.c_str(), "main", options.get()),
+            shaderc_result_release
+        };
+
+        if(shaderc_result_get_compilation_status(result.get()) != shaderc_compilation_status_success)
+            throw std::runtime_error("Failed to compile shader " + sourceFilepath + ":\n" + shaderc_result_get_error_message(result.get()));
+
+        const char* bytes = shaderc_result_get_bytes(result.get());
+        return std::vector<char>(bytes, bytes + shaderc_result_get_length(result.get()));
+    #else
+        throw std::runtime_error("Cannot compile " + sourceFilepath + ", runtime shader compilation is disabled (RENDERER_RUNTIME_SHADER_COMPILATION).");
+    #endif
+    }
+}
\ No newline at end of file
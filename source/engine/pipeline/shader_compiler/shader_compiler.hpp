@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+namespace Renderer{
+    // Compiles GLSL to SPIR-V at runtime through shaderc, with variants selected by preprocessor defines.
+    // Results are cached on disk keyed by a hash of the source, every file it includes, the defines and the stage,
+    // so unchanged shaders load straight from the cache and variants are only compiled the first time they're asked for.
+    // Only available when built with RENDERER_RUNTIME_SHADER_COMPILATION, otherwise compile() throws.
+    class ShaderCompiler{
+        public:
+            struct Define{
+                std::string name;
+                std::string value;
+            };
+
+            ShaderCompiler(const std::string& cacheDirectory = "shader_cache");
+            ~ShaderCompiler();
+
+            ShaderCompiler(const ShaderCompiler&) = delete;
+            ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+
+            // The stage is taken from the extension (.vert, .frag, .comp). Safe to call from several threads.
+            std::vector<char> compile(const std::string& sourceFilepath, const std::vector<Define>& defines = {});
+
+            static bool isAvailable();
+            // True for GLSL sources this compiler can handle, as opposed to precompiled .spv files
+            static bool isGlslSource(const std::string& filepath);
+
+        private:
+            uint64_t computeKey(const std::string& sourceFilepath, const std::string& source, const std::vector<Define>& defines) const;
+            std::vector<char> compileSource(const std::string& sourceFilepath, const std::string& source, const std::vector<Define>& defines) const;
+
+            std::string cacheDirectory;
+            void* compiler = nullptr;   // shaderc_compiler_t, kept opaque so shaderc headers stay out of this header
+
+            std::mutex mutex;
+            std::unordered_map<uint64_t, std::vector<char>> memoryCache;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "shader_reflection.hpp"
+
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+namespace Renderer{
+    namespace{
+        // Opcodes, decorations and storage classes from the SPIR-V specification
+        constexpr uint32_t spirvMagic = 0x07230203;
+        constexpr uint32_t opTypeBool = 20, opTypeInt = 21, opTypeFloat = 22, opTypeVector = 23, opTypeMatrix = 24;
+        constexpr uint32_t opTypeArray = 28, opTypeStruct = 30, opTypePointer = 32, opConstant = 43, opVariable = 59;
+        constexpr uint32_t opDecorate = 71, opMemberDecorate = 72;
+        constexpr uint32_t decorationRowMajor = 4, decorationArrayStride = 6, decorationMatrixStride = 7, decorationOffset = 35;
+        constexpr uint32_t storageClassPushConstant = 9;
+
+        struct Member{
+            uint32_t offset = 0;
+            uint32_t matrixStride = 0;
+            bool rowMajor = false;
+        };
+
+        struct Module{
+            // Every instruction operand list by result ID, only for the instructions needed to size a block
+            std::unordered_map<uint32_t, std::pair<uint32_t, std::vector<uint32_t>>> types;
+            std::unordered_map<uint32_t, uint32_t> constants;
+            std::unordered_map<uint32_t, uint32_t> arrayStrides;
+            std::unordered_map<uint32_t, std::vector<Member>> members;
+
+            const std::pair<uint32_t, std::vector<uint32_t>>& getType(uint32_t id) const {
+                auto type = types.find(id);
+                if(type == types.end())
+                    throw std::runtime_error("SPIR-V reflection: unknown type id.");
+                return type->second;
+            }
+
+            // Byte size of a type as laid out in the block, member matrix layout comes from the enclosing struct
+            uint32_t sizeOf(uint32_t id, const Member& member = {}) const {
+                const auto& [opcode, operands] = getType(id);
+                switch(opcode){
+                    case opTypeBool:
+                        return 4;
+                    case opTypeInt:
+                    case opTypeFloat:
+                        return operands[0] / 8;
+                    case opTypeVector:
+                        return sizeOf(operands[0]) * operands[1];
+                    case opTypeMatrix:{
+                        // operands are the column type and column count, the stride is between columns (or rows when row major)
+                        uint32_t rowCount = getType(operands[0]).second[1];
+                        uint32_t stride = member.matrixStride != 0 ? member.matrixStride : sizeOf(operands[0]);
+                        return (member.rowMajor ? rowCount : operands[1]) * stride;
+                    }
+                    case opTypeArray:{
+                        auto length = constants.find(operands[1]);
+                        auto stride = arrayStrides.find(id);
+                        if(length == constants.end() || stride == arrayStrides.end())
+                            throw std::runtime_error("SPIR-V reflection: array without a constant length or stride.");
+                        return length->second * stride->second;
+                    }
+                    case opTypeStruct:{
+                        uint32_t end = 0;
+                        auto structMembers = members.find(id);
+                        for(size_t i = 0; i < operands.size(); i++){
+                            Member decorations = structMembers != members.end() && i < structMembers->second.size() ? structMembers->second[i] : Member{};
+                            end = std::max(end, decorations.offset + sizeOf(operands[i], decorations));
+                        }
+                        return end;
+                    }
+                    default:
+                        throw std::runtime_error("SPIR-V reflection: unsupported type in push constant block.");
+                }
+            }
+        };
+    }
+
+    PushConstantBlock reflectPushConstants(const uint32_t* code, size_t size){
+        size_t wordCount = size / sizeof(uint32_t);
+        if(wordCount < 5 || code[0] != spirvMagic)
+            throw std::runtime_error("SPIR-V reflection: not a SPIR-V module.");
+
+        Module module;
+        std::vector<uint32_t> pushConstantPointers;
+
+        for(size_t i = 5; i < wordCount;){
+            uint32_t opcode = code[i] & 0xFFFF;
+            uint32_t length = code[i] >> 16;
+            if(length == 0 || i + length > wordCount)
+                throw std::runtime_error("SPIR-V reflection: malformed instruction.");
+            const uint32_t* operands = code + i + 1;
+            uint32_t operandCount = length - 1;
+
+            switch(opcode){
+                case opTypeBool:
+                case opTypeInt:
+                case opTypeFloat:
+                case opTypeVector:
+                case opTypeMatrix:
+                case opTypeArray:
+                case opTypeStruct:
+                    module.types[operands[0]] = {opcode, std::vector<uint32_t>(operands + 1, operands + operandCount)};
+                    break;
+                case opTypePointer:
+                    if(operands[1] == storageClassPushConstant)
+                        module.types[operands[0]] = {opcode, {operands[2]}};
+                    break;
+                case opConstant:
+                    // Only 32 bit constants are used as array lengths
+                    if(operandCount >= 3)
+                        module.constants[operands[1]] = operands[2];
+                    break;
+                case opVariable:
+                    if(operands[2] == storageClassPushConstant)
+                        pushConstantPointers.push_back(operands[0]);
+                    break;
+                case opDecorate:
+                    if(operands[1] == decorationArrayStride)
+                        module.arrayStrides[operands[0]] = operands[2];
+                    break;
+                case opMemberDecorate:{
+                    auto& members = module.members[operands[0]];
+                    if(members.size() <= operands[1])
+                        members.resize(operands[1] + 1);
+                    if(operands[2] == decorationOffset)
+                        members[operands[1]].offset = operands[3];
+                    else if(operands[2] == decorationMatrixStride)
+                        members[operands[1]].matrixStride = operands[3];
+                    else if(operands[2] == decorationRowMajor)
+                        members[operands[1]].rowMajor = true;
+                    break;
+                }
+            }
+            i += length;
+        }
+
+        // A shader entry point can use at most one push constant block
+        PushConstantBlock block;
+        if(pushConstantPointers.empty())
+            return block;
+
+        uint32_t structId = module.getType(pushConstantPointers.front()).second[0];
+        const auto& operands = module.getType(structId).second;
+        auto members = module.members.find(structId);
+        uint32_t begin = UINT32_MAX, end = 0;
+        for(size_t i = 0; i < operands.size(); i++){
+            Member decorations = members != module.members.end() && i < members->second.size() ? members->second[i] : Member{};
+            begin = std::min(begin, decorations.offset);
+            end = std::max(end, decorations.offset + module.sizeOf(operands[i], decorations));
+        }
+
+        if(begin < end){
+            block.offset = begin;
+            block.size = end - begin;
+        }
+        return block;
+    }
+}
\ No newline at end of file
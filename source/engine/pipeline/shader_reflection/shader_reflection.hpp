@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Renderer{
+    // Byte range of a shader's push constant block, size is 0 when the shader doesn't declare one
+    struct PushConstantBlock{
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    // Minimal SPIR-V reflection, just enough to size pipeline layouts from the shaders instead of by hand.
+    // size is in bytes. Throws on malformed modules.
+    PushConstantBlock reflectPushConstants(const uint32_t* code, size_t size);
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "shader_registry.hpp"
+
+#include "engine/pipeline/embedded_shaders/embedded_shaders.hpp"
+
+#include <filesystem>
+
+namespace Renderer{
+    ShaderRegistry::ShaderRegistry(Device& device) : device{device}{}
+
+    uint64_t ShaderRegistry::hashCode(const std::vector<char>& code){
+        return hashCode(code.data(), code.size());
+    }
+
+    uint64_t ShaderRegistry::hashCode(const void* code, size_t size){
+        // FNV-1a, 64 bit
+        const unsigned char* bytes = static_cast<const unsigned char*>(code);
+        uint64_t hash = 14695981039346656037ull;
+        for(size_t i = 0; i < size; i++){
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::shared_ptr<ShaderModule> ShaderRegistry::getModule(const std::string& filepath, const std::vector<ShaderCompiler::Define>& defines){
+        // Not remembered by path, the compiler hashes the source and its includes on every call so edits are picked up
+        if(ShaderCompiler::isGlslSource(filepath)){
+            std::vector<char> code = compiler.compile(filepath, defines);
+            std::lock_guard<std::mutex> lock{mutex};
+            return getModuleLocked(reinterpret_cast<const uint32_t*>(code.data()), code.size());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            auto path = pathHashes.find(filepath);
+            if(path != pathHashes.end()){
+                auto module = modulesByHash.find(path->second);
+                if(module != modulesByHash.end())
+                    return module->second;
+            }
+        }
+
+        std::filesystem::path overridePath;
+        if(!getShaderOverrideDirectory().empty())
+            overridePath = std::filesystem::path(getShaderOverrideDirectory()) / std::filesystem::path(filepath).filename();
+
+        const EmbeddedShader* embedded = findEmbeddedShader(filepath);
+        if(embedded != nullptr && (overridePath.empty() || !std::filesystem::exists(overridePath))){
+            std::lock_guard<std::mutex> lock{mutex};
+            pathHashes[filepath] = hashCode(embedded->code, embedded->size);
+            return getModuleLocked(embedded->code, embedded->size);
+        }
+
+        // Read outside the lock so other threads aren't held up by file IO
+        std::vector<char> code;
+        if(!overridePath.empty() && std::filesystem::exists(overridePath))
+            code = ShaderModule::readFile(overridePath.string());
+        else
+            code = ShaderModule::readFile(filepath);
+
+        std::lock_guard<std::mutex> lock{mutex};
+        pathHashes[filepath] = hashCode(code);
+        return getModuleLocked(reinterpret_cast<const uint32_t*>(code.data()), code.size());
+    }
+
+    std::shared_ptr<ShaderModule> ShaderRegistry::getModule(const std::vector<char>& code){
+        std::lock_guard<std::mutex> lock{mutex};
+        return getModuleLocked(reinterpret_cast<const uint32_t*>(code.data()), code.size());
+    }
+
+    std::shared_ptr<ShaderModule> ShaderRegistry::getModuleLocked(const uint32_t* code, size_t size){
+        auto& module = modulesByHash[hashCode(code, size)];
+        if(module == nullptr)
+            module = std::make_shared<ShaderModule>(device, code, size);
+        return module;
+    }
+
+    void ShaderRegistry::releaseUnused(){
+        std::lock_guard<std::mutex> lock{mutex};
+        for(auto it = modulesByHash.begin(); it != modulesByHash.end();){
+            if(it->second.use_count() == 1)
+                it = modulesByHash.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    size_t ShaderRegistry::getModuleCount(){
+        std::lock_guard<std::mutex> lock{mutex};
+        return modulesByHash.size();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "engine/pipeline/pipeline.hpp"
+#include "engine/pipeline/shader_compiler/shader_compiler.hpp"
+
+#include <unordered_map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Renderer{
+    // Owns every ShaderModule so each SPIR-V file is loaded once and identical code (e.g. the same shader under two paths)
+    // becomes a single VkShaderModule. GLSL sources (.vert/.frag/.comp) are compiled at runtime, with defines selecting the variant.
+    // SPIR-V paths resolve by file name to the override directory, then the embedded shaders, then the path itself.
+    // Safe to use from pipeline builder worker threads.
+    class ShaderRegistry{
+        public:
+            ShaderRegistry(Device& device);
+
+            ShaderRegistry(const ShaderRegistry&) = delete;
+            ShaderRegistry& operator=(const ShaderRegistry&) = delete;
+
+            std::shared_ptr<ShaderModule> getModule(const std::string& filepath, const std::vector<ShaderCompiler::Define>& defines = {});
+            std::shared_ptr<ShaderModule> getModule(const std::vector<char>& code);
+
+            // Destroys modules no pipeline holds anymore, pipelines don't need their modules once created
+            void releaseUnused();
+
+            size_t getModuleCount();
+
+            static uint64_t hashCode(const std::vector<char>& code);
+            static uint64_t hashCode(const void* code, size_t size);
+
+        private:
+            // code must stay valid only for the call, size is in bytes
+            std::shared_ptr<ShaderModule> getModuleLocked(const uint32_t* code, size_t size);
+
+            Device& device;
+            ShaderCompiler compiler;
+            std::mutex mutex;
+            std::unordered_map<uint64_t, std::shared_ptr<ShaderModule>> modulesByHash;
+            std::unordered_map<std::string, uint64_t> pathHashes;
+    };
+}
\ No newline at end of file
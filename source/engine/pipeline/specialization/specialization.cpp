@@ -0,0 +1,53 @@
+#include "specialization.hpp"
+
+#include <algorithm>
+
+namespace Renderer{
+    void SpecializationConstants::setBytes(uint32_t constantId, const void* value, size_t size){
+        auto entry = std::lower_bound(entries.begin(), entries.end(), constantId, [](const VkSpecializationMapEntry& entry, uint32_t id){
+            return entry.constantID < id;
+        });
+
+        if(entry != entries.end() && entry->constantID == constantId){
+            // Every supported type is 4 bytes, so the value can be overwritten in place
+            std::memcpy(data.data() + entry->offset, value, size);
+            return;
+        }
+
+        VkSpecializationMapEntry newEntry{};
+        newEntry.constantID = constantId;
+        newEntry.offset = static_cast<uint32_t>(data.size());
+        newEntry.size = size;
+        entries.insert(entry, newEntry);
+
+        data.resize(data.size() + size);
+        std::memcpy(data.data() + newEntry.offset, value, size);
+    }
+
+    uint64_t SpecializationConstants::hash() const {
+        // FNV-1a, 64 bit, over each (ID, value) pair in ID order
+        uint64_t hash = 14695981039346656037ull;
+        auto hashBytes = [&hash](const void* bytes, size_t size){
+            for(size_t i = 0; i < size; i++){
+                hash ^= static_cast<const uint8_t*>(bytes)[i];
+                hash *= 1099511628211ull;
+            }
+        };
+        for(const auto& entry : entries){
+            hashBytes(&entry.constantID, sizeof(entry.constantID));
+            hashBytes(data.data() + entry.offset, entry.size);
+        }
+        return hash;
+    }
+
+    const VkSpecializationInfo* SpecializationConstants::getInfo() const {
+        if(entries.empty())
+            return nullptr;
+
+        info.mapEntryCount = static_cast<uint32_t>(entries.size());
+        info.pMapEntries = entries.data();
+        info.dataSize = data.size();
+        info.pData = data.data();
+        return &info;
+    }
+}
\ No newline at end of file
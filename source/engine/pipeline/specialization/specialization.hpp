@@ -0,0 +1,90 @@
+#pragma once
+
+#include "engine/device/device.hpp"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+#include <type_traits>
+#include <cstring>
+#include <cstdint>
+
+namespace Renderer{
+    // Typed values for a shader's `layout(constant_id = N) const ...` declarations, baked in when the pipeline is compiled
+    // so the driver can drop the branches they disable. A constant ID the shader doesn't declare is ignored, so one set
+    // can be shared by every stage of a pipeline.
+    class SpecializationConstants{
+        public:
+            // Supports the GLSL scalar types: bool (stored as VkBool32), int32_t, uint32_t and float. Replaces an earlier value for the same ID.
+            template<typename T>
+            SpecializationConstants& set(uint32_t constantId, T value){
+                static_assert(std::is_same<T, bool>::value || std::is_same<T, int32_t>::value || std::is_same<T, uint32_t>::value || std::is_same<T, float>::value,
+                    "Specialization constants must be bool, int32_t, uint32_t or float.");
+                if constexpr(std::is_same<T, bool>::value){
+                    VkBool32 boolValue = value ? VK_TRUE : VK_FALSE;
+                    setBytes(constantId, &boolValue, sizeof(boolValue));
+                }
+                else
+                    setBytes(constantId, &value, sizeof(value));
+                return *this;
+            }
+
+            bool empty() const { return entries.empty(); }
+            // Identifies the variant, equal constants give equal hashes regardless of the order they were set in
+            uint64_t hash() const;
+
+            // Points into this object, so it must outlive the pipeline creation and not be modified meanwhile
+            const VkSpecializationInfo* getInfo() const;
+
+        private:
+            void setBytes(uint32_t constantId, const void* value, size_t size);
+
+            std::vector<VkSpecializationMapEntry> entries;  // Kept sorted by constantID
+            std::vector<uint8_t> data;
+            mutable VkSpecializationInfo info{};
+    };
+
+    // Pipelines built from the same shaders with different specialization constants, created on first use and kept by constant hash
+    template<typename T>
+    class PipelineVariants{
+        public:
+            using CreateFunction = std::function<std::shared_ptr<T>(const SpecializationConstants& constants)>;
+
+            PipelineVariants(CreateFunction create) : create{std::move(create)}{}
+
+            PipelineVariants(const PipelineVariants&) = delete;
+            PipelineVariants& operator=(const PipelineVariants&) = delete;
+
+            std::shared_ptr<T> get(const SpecializationConstants& constants){
+                uint64_t key = constants.hash();
+                {
+                    std::lock_guard<std::mutex> lock{mutex};
+                    auto variant = variants.find(key);
+                    if(variant != variants.end())
+                        return variant->second;
+                }
+
+                // Built outside the lock, two threads asking for the same new variant both compile it and the first one is kept
+                std::shared_ptr<T> pipeline = create(constants);
+                std::lock_guard<std::mutex> lock{mutex};
+                return variants.emplace(key, std::move(pipeline)).first->second;
+            }
+
+            size_t getVariantCount(){
+                std::lock_guard<std::mutex> lock{mutex};
+                return variants.size();
+            }
+
+            void clear(){
+                std::lock_guard<std::mutex> lock{mutex};
+                variants.clear();
+            }
+
+        private:
+            CreateFunction create;
+            std::mutex mutex;
+            std::unordered_map<uint64_t, std::shared_ptr<T>> variants;
+    };
+}
\ No newline at end of file
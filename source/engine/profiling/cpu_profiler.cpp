@@ -0,0 +1,203 @@
+#include "cpu_profiler.hpp"
+
+#include "engine/threading/thread_pool.hpp"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <algorithm>
+#include <unordered_map>
+
+namespace Renderer{
+    namespace{
+        struct ThreadBuffer{
+            std::vector<CpuProfiler::Event> events = std::vector<CpuProfiler::Event>(CpuProfiler::eventsPerThread);
+            // Total events ever written, the ring position is written % eventsPerThread
+            std::atomic<uint64_t> written{0};
+            // Set while record is between its enabled check and publishing the event, readers wait for it to clear
+            std::atomic<bool> writing{false};
+            uint32_t threadId;
+            // Pool workers are named after their pool, the thread calling markFrame is "Main"
+            std::string name;
+        };
+
+        struct Registry{
+            std::mutex mutex;
+            // Kept until exit so rings of threads that have finished can still be dumped
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+            std::atomic<bool> enabled{true};
+            const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        };
+
+        Registry& getRegistry(){
+            static Registry registry;
+            return registry;
+        }
+
+        ThreadBuffer& getThreadBuffer(){
+            thread_local ThreadBuffer* buffer = nullptr;
+            if(buffer == nullptr){
+                Registry& registry = getRegistry();
+                std::lock_guard<std::mutex> lock{registry.mutex};
+                registry.buffers.push_back(std::make_unique<ThreadBuffer>());
+                buffer = registry.buffers.back().get();
+                buffer->threadId = static_cast<uint32_t>(registry.buffers.size() - 1);
+                const char* poolName = ThreadPool::getCurrentPoolName();
+                buffer->name = poolName ? std::string{poolName} + " " + std::to_string(ThreadPool::getCurrentThreadIndex()) 
+                    : "Thread " + std::to_string(buffer->threadId);
+            }
+            return *buffer;
+        }
+
+        // Disables recording and waits out writers that passed the enabled check before it, so the rings can be read
+        // without racing them. Returns whether recording was enabled.
+        bool pauseRecording(Registry& registry){
+            bool wasEnabled = registry.enabled.exchange(false);
+            std::lock_guard<std::mutex> lock{registry.mutex};
+            for(const auto& buffer : registry.buffers)
+                while(buffer->writing.load())
+                    std::this_thread::yield();
+            return wasEnabled;
+        }
+
+        template<typename Function>
+        void forEachEvent(ThreadBuffer& buffer, Function function){
+            // Oldest to newest, only the last eventsPerThread events are still in the ring
+            uint64_t written = buffer.written.load(std::memory_order_acquire);
+            uint64_t begin = written > CpuProfiler::eventsPerThread ? written - CpuProfiler::eventsPerThread : 0;
+            for(uint64_t i = begin; i < written; i++)
+                function(buffer.events[i % CpuProfiler::eventsPerThread]);
+        }
+
+        void writeEscaped(std::ofstream& file, const char* text){
+            for(; *text != '\0'; text++){
+                if(*text == '"' || *text == '\\')
+                    file << '\\';
+                file << *text;
+            }
+        }
+    }
+
+    uint64_t CpuProfiler::now(){
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - getRegistry().epoch).count());
+    }
+
+    void CpuProfiler::record(const char* name, uint64_t start, uint64_t end){
+        if(!isEnabled())
+            return;
+        ThreadBuffer& buffer = getThreadBuffer();
+        // Sequentially consistent with pauseRecording's exchange, so either the reader waits for this write or it is dropped here
+        buffer.writing.store(true);
+        if(!getRegistry().enabled.load()){
+            buffer.writing.store(false, std::memory_order_release);
+            return;
+        }
+        uint64_t index = buffer.written.load(std::memory_order_relaxed);
+        buffer.events[index % eventsPerThread] = {name, start, end};
+        // Release so a reader that sees the new count also sees the event
+        buffer.written.store(index + 1, std::memory_order_release);
+        buffer.writing.store(false, std::memory_order_release);
+    }
+
+    void CpuProfiler::markFrame(){
+        static bool named = false;
+        if(!named){
+            ThreadBuffer& buffer = getThreadBuffer();
+            std::lock_guard<std::mutex> lock{getRegistry().mutex};
+            buffer.name = "Main";
+            named = true;
+        }
+        static uint64_t frameStart = now();
+        uint64_t frameEnd = now();
+        record("Frame", frameStart, frameEnd);
+        frameStart = frameEnd;
+    }
+
+    void CpuProfiler::setEnabled(bool enabled){
+        getRegistry().enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool CpuProfiler::isEnabled(){
+        return getRegistry().enabled.load(std::memory_order_relaxed);
+    }
+
+    bool CpuProfiler::writeChromeTrace(const std::string& filepath, uint64_t begin, uint64_t end, const std::string& otherData){
+        std::ofstream file{filepath, std::ios::trunc};
+        if(!file.is_open()){
+            std::cerr << "Failed to open trace file: " << filepath << '\n';
+            return false;
+        }
+
+        Registry& registry = getRegistry();
+        bool wasEnabled = pauseRecording(registry);
+
+        file << "{\"displayTimeUnit\":\"ms\",";
+        // Timestamps are in microseconds, the default 6 significant digits would round them to whole milliseconds within seconds
+        file << std::fixed << std::setprecision(3);
+        if(!otherData.empty())
+            file << "\"otherData\":" << otherData << ",";
+        file << "\"traceEvents\":[";
+        bool first = true;
+        {
+            std::lock_guard<std::mutex> lock{registry.mutex};
+            for(const auto& buffer : registry.buffers){
+                file << (first ? "" : ",") << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << buffer->threadId 
+                    << ",\"args\":{\"name\":\"";
+                writeEscaped(file, buffer->name.c_str());
+                file << "\"}}";
+                first = false;
+
+                forEachEvent(*buffer, [&](const Event& event){
+                    if(event.end < begin || event.start > end)
+                        return;
+                    // Complete events, timestamps in microseconds
+                    file << ",\n{\"ph\":\"X\",\"name\":\"";
+                    writeEscaped(file, event.name);
+                    file << "\",\"pid\":0,\"tid\":" << buffer->threadId << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+                });
+            }
+        }
+        file << "\n]}\n";
+
+        setEnabled(wasEnabled);
+        std::cout << "Wrote CPU trace to " << filepath << '\n';
+        return true;
+    }
+
+    std::vector<CpuProfiler::ZoneSummary> CpuProfiler::summarizeZones(){
+        Registry& registry = getRegistry();
+        bool wasEnabled = pauseRecording(registry);
+        std::vector<ZoneSummary> summaries;
+        std::unordered_map<std::string, size_t> summaryIndices;
+        std::unique_lock<std::mutex> lock{registry.mutex};
+        for(const auto& buffer : registry.buffers)
+            forEachEvent(*buffer, [&](const Event& event){
+                auto [it, inserted] = summaryIndices.emplace(event.name, summaries.size());
+                if(inserted)
+                    summaries.push_back({event.name, 0, 0.0, 0.0});
+                ZoneSummary& summary = summaries[it->second];
+                double milliseconds = (event.end - event.start) / 1e6;
+                summary.count++;
+                summary.totalMilliseconds += milliseconds;
+                summary.maxMilliseconds = std::max(summary.maxMilliseconds, milliseconds);
+            });
+        lock.unlock();
+        setEnabled(wasEnabled);
+
+        std::sort(summaries.begin(), summaries.end(), [](const ZoneSummary& a, const ZoneSummary& b){ return a.totalMilliseconds > b.totalMilliseconds; });
+        return summaries;
+    }
+
+    void CpuProfiler::clear(){
+        Registry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock{registry.mutex};
+        for(const auto& buffer : registry.buffers)
+            buffer->written.store(0, std::memory_order_release);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Scoped CPU zone, compiled out entirely unless RENDERER_CPU_PROFILER is defined (CMake option of the same name).
+// name must be a string literal or otherwise outlive the profiler.
+#ifdef RENDERER_CPU_PROFILER
+    #define RENDERER_PROFILE_CONCAT_INNER(a, b) a##b
+    #define RENDERER_PROFILE_CONCAT(a, b) RENDERER_PROFILE_CONCAT_INNER(a, b)
+    #define RENDERER_PROFILE_SCOPE(name) ::Renderer::CpuProfiler::Scope RENDERER_PROFILE_CONCAT(profileScope, __LINE__){name}
+    #define RENDERER_PROFILE_FUNCTION() RENDERER_PROFILE_SCOPE(__func__)
+    #define RENDERER_PROFILE_FRAME() ::Renderer::CpuProfiler::markFrame()
+#else
+    #define RENDERER_PROFILE_SCOPE(name) ((void)0)
+    #define RENDERER_PROFILE_FUNCTION() ((void)0)
+    #define RENDERER_PROFILE_FRAME() ((void)0)
+#endif
+
+namespace Renderer{
+    // Records CPU zones into per-thread ring buffers. Recording never takes a lock: each thread only writes its own ring,
+    // and a thread's ring is registered once, the first time it records. The rings keep the most recent eventsPerThread
+    // zones and can be written out as Chrome/Perfetto trace JSON (chrome://tracing, ui.perfetto.dev).
+    class CpuProfiler{
+        public:
+            struct Event{
+                const char* name;
+                uint64_t start;     // Nanoseconds since the profiler's epoch
+                uint64_t end;
+            };
+
+            // Totals of every zone with the same name still held in the rings
+            struct ZoneSummary{
+                std::string name;
+                uint64_t count;
+                double totalMilliseconds;
+                double maxMilliseconds;
+            };
+
+            class Scope{
+                public:
+                    Scope(const char* name) : name{name}, start{now()}{}
+                    ~Scope(){ record(name, start, now()); }
+
+                    Scope(const Scope&) = delete;
+                    Scope& operator=(const Scope&) = delete;
+
+                private:
+                    const char* name;
+                    uint64_t start;
+            };
+
+            static void record(const char* name, uint64_t start, uint64_t end);
+            // Ends the current frame zone and starts the next, call once per frame on the main thread
+            static void markFrame();
+            static uint64_t now();
+
+            // Zones are dropped while disabled, writeChromeTrace and summarizeZones disable recording while they read the rings
+            static void setEnabled(bool enabled);
+            static bool isEnabled();
+
+            // Only zones overlapping [begin, end] (profiler nanoseconds) are written. otherData, when given, must be a JSON object
+            // and is stored under the trace's "otherData" key, which trace viewers show as metadata.
+            static bool writeChromeTrace(const std::string& filepath, uint64_t begin = 0, uint64_t end = UINT64_MAX, const std::string& otherData = {});
+            // Sorted by total time, longest first
+            static std::vector<ZoneSummary> summarizeZones();
+            // Drops every recorded zone, no thread may be recording while this runs
+            static void clear();
+
+            static constexpr uint32_t eventsPerThread = 1 << 16;
+    };
+}
\ No newline at end of file
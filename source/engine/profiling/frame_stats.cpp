@@ -0,0 +1,139 @@
+#include "frame_stats.hpp"
+
+#include "engine/profiling/cpu_profiler.hpp"
+#include "engine/profiling/gpu_profiler.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+
+namespace Renderer{
+    namespace{
+        // Mean of the slowest fraction of the samples
+        double averageOfSlowest(std::vector<float> samples, double fraction){
+            if(samples.empty())
+                return 0.0;
+            size_t count = std::max<size_t>(static_cast<size_t>(std::ceil(samples.size() * fraction)), 1);
+            std::nth_element(samples.begin(), samples.begin() + (count - 1), samples.end(), std::greater<float>());
+            double total = 0.0;
+            for(size_t i = 0; i < count; i++)
+                total += samples[i];
+            return total / count;
+        }
+    }
+
+    FrameStats::FrameStats(const GpuProfiler* gpuProfiler, const FrameStatsSettings& settings) 
+    : gpuProfiler{gpuProfiler}, settings{settings}, fenceWait{settings.lowsWindowSize}, acquire{settings.lowsWindowSize}, 
+    submit{settings.lowsWindowSize}, present{settings.lowsWindowSize}{
+        lowsWindow.reserve(settings.lowsWindowSize);
+    }
+
+    void FrameStats::addFrame(float frameMilliseconds, const SwapChain::FrameTimings& timings){
+        uint64_t frameEnd = CpuProfiler::now();
+        uint64_t frameDuration = static_cast<uint64_t>(frameMilliseconds * 1e6);
+        frameStarts.push_back(frameEnd > frameDuration ? frameEnd - frameDuration : 0);
+        if(frameStarts.size() > settings.framesBeforeHitch + 1)
+            frameStarts.pop_front();
+
+        histogram.record(frameMilliseconds);
+        if(lowsWindow.size() < settings.lowsWindowSize)
+            lowsWindow.push_back(frameMilliseconds);
+        else{
+            lowsWindow[nextLowsSample] = frameMilliseconds;
+            nextLowsSample = (nextLowsSample + 1) % settings.lowsWindowSize;
+        }
+
+        fenceWait.addSample(timings.fenceWaitMilliseconds);
+        acquire.addSample(timings.acquireMilliseconds);
+        submit.addSample(timings.submitMilliseconds);
+        present.addSample(timings.presentMilliseconds);
+
+        if(settings.hitchThresholdMilliseconds > 0.f && frameMilliseconds > settings.hitchThresholdMilliseconds){
+            hitchCount++;
+            if(hitchCaptureCount < settings.maxHitchCaptures){
+                hitchCaptureCount++;
+                pendingHitches.push_back({frameNumber, frameMilliseconds, timings, frameStarts.front()});
+            }
+        }
+
+        // Written once the frames after the hitch are in, the GPU zones of the hitch frame have been read back by then
+        auto ready = [this](const PendingHitch& hitch){ return frameNumber >= hitch.frame + settings.framesAfterHitch; };
+        for(const auto& hitch : pendingHitches)
+            if(ready(hitch))
+                writeHitch(hitch);
+        pendingHitches.erase(std::remove_if(pendingHitches.begin(), pendingHitches.end(), ready), pendingHitches.end());
+
+        frameNumber++;
+    }
+
+    void FrameStats::writeHitch(const PendingHitch& hitch){
+        std::error_code error;
+        std::filesystem::create_directories(settings.hitchDirectory, error);
+
+        std::ostringstream otherData;
+        otherData << "{\"frame\":" << hitch.frame << ",\"frameMilliseconds\":" << hitch.frameMilliseconds 
+            << ",\"thresholdMilliseconds\":" << settings.hitchThresholdMilliseconds
+            << ",\"fenceWaitMilliseconds\":" << hitch.timings.fenceWaitMilliseconds << ",\"acquireMilliseconds\":" << hitch.timings.acquireMilliseconds
+            << ",\"submitMilliseconds\":" << hitch.timings.submitMilliseconds << ",\"presentMilliseconds\":" << hitch.timings.presentMilliseconds
+            << ",\"gpuRecentFrames\":[";
+        if(gpuProfiler != nullptr){
+            bool firstFrame = true;
+            for(const auto& zones : gpuProfiler->getRecentFrames()){
+                otherData << (firstFrame ? "[" : ",[");
+                for(size_t i = 0; i < zones.size(); i++)
+                    otherData << (i == 0 ? "" : ",") << "{\"name\":\"" << zones[i].name << "\",\"milliseconds\":" << zones[i].milliseconds << "}";
+                otherData << "]";
+                firstFrame = false;
+            }
+        }
+        otherData << "]}";
+
+        std::string filepath = (std::filesystem::path{settings.hitchDirectory} / ("hitch_frame_" + std::to_string(hitch.frame) + ".json")).string();
+        CpuProfiler::writeChromeTrace(filepath, hitch.begin, CpuProfiler::now(), otherData.str());
+    }
+
+    void FrameStats::clear(){
+        histogram.clear();
+        lowsWindow.clear();
+        nextLowsSample = 0;
+        fenceWait.clear();
+        acquire.clear();
+        submit.clear();
+        present.clear();
+        hitchCount = 0;
+    }
+
+    FrameStats::Summary FrameStats::summarize() const {
+        Summary summary{};
+        summary.frameCount = histogram.getCount();
+        summary.averageMilliseconds = histogram.getAverage();
+        summary.p50Milliseconds = histogram.getValueAtPercentile(0.5);
+        summary.p90Milliseconds = histogram.getValueAtPercentile(0.9);
+        summary.p99Milliseconds = histogram.getValueAtPercentile(0.99);
+        summary.p999Milliseconds = histogram.getValueAtPercentile(0.999);
+        summary.maxMilliseconds = histogram.getMax();
+        summary.onePercentLowMilliseconds = averageOfSlowest(lowsWindow, 0.01);
+        summary.pointOnePercentLowMilliseconds = averageOfSlowest(lowsWindow, 0.001);
+        summary.fenceWait = fenceWait.summarize();
+        summary.acquire = acquire.summarize();
+        summary.submit = submit.summarize();
+        summary.present = present.summarize();
+        summary.hitchCount = hitchCount;
+        return summary;
+    }
+
+    void FrameStats::print() const {
+        Summary summary = summarize();
+        std::cout << std::fixed << std::setprecision(2)
+            << "Frames " << summary.frameCount << ": avg " << summary.averageMilliseconds << " ms, p50 " << summary.p50Milliseconds 
+            << " ms, p99 " << summary.p99Milliseconds << " ms, p99.9 " << summary.p999Milliseconds << " ms, max " << summary.maxMilliseconds << " ms" << '\n'
+            << "Lows: 1% " << summary.onePercentLowMilliseconds << " ms, 0.1% " << summary.pointOnePercentLowMilliseconds << " ms, hitches over " 
+            << settings.hitchThresholdMilliseconds << " ms: " << summary.hitchCount << '\n'
+            << "Swap chain avg: fence wait " << summary.fenceWait.average << " ms, acquire " << summary.acquire.average << " ms, submit " 
+            << summary.submit.average << " ms, present " << summary.present.average << " ms" << '\n'
+            << std::defaultfloat;
+    }
+}
\ No newline at end of file
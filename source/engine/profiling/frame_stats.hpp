@@ -0,0 +1,94 @@
+#pragma once
+
+#include "engine/swap_chain/swap_chain.hpp"
+#include "engine/profiling/histogram.hpp"
+#include "engine/profiling/rolling_stats.hpp"
+
+#include <string>
+#include <vector>
+#include <deque>
+
+namespace Renderer{
+    class GpuProfiler;
+
+    struct FrameStatsSettings{
+        // Frames longer than this are hitches, 0 disables hitch capture
+        float hitchThresholdMilliseconds = 50.f;
+        // Frames around a hitch included in its capture. Capturing waits for the frames after it, which also gives the
+        // GPU profiler time to read the hitch frame back.
+        uint32_t framesBeforeHitch = 3;
+        uint32_t framesAfterHitch = 3;
+        // Later hitches aren't written, so a bad run can't fill the disk
+        uint32_t maxHitchCaptures = 32;
+        std::string hitchDirectory = "hitches";
+        // Frames the 1% and 0.1% lows are taken over
+        uint32_t lowsWindowSize = 5000;
+    };
+
+    // Frame time histogram for whole-run percentiles, rolling 1% and 0.1% lows, and rolling averages of the time the CPU
+    // spent blocked in the swap chain. Every hitch writes a Chrome trace of the CPU zones of the frames around it to
+    // hitchDirectory, with the frame's swap chain timings and the recent GPU zone times under "otherData".
+    class FrameStats{
+        public:
+            struct Summary{
+                uint64_t frameCount = 0;
+                double averageMilliseconds = 0.0;
+                double p50Milliseconds = 0.0;
+                double p90Milliseconds = 0.0;
+                double p99Milliseconds = 0.0;
+                double p999Milliseconds = 0.0;
+                double maxMilliseconds = 0.0;
+                // Mean of the slowest 1% and 0.1% of the frames in the rolling window
+                double onePercentLowMilliseconds = 0.0;
+                double pointOnePercentLowMilliseconds = 0.0;
+
+                RollingStats::Summary fenceWait;
+                RollingStats::Summary acquire;
+                RollingStats::Summary submit;
+                RollingStats::Summary present;
+
+                uint32_t hitchCount = 0;
+            };
+
+            FrameStats(const GpuProfiler* gpuProfiler = nullptr, const FrameStatsSettings& settings = {});
+
+            // Call once per frame with how long the frame took and the swap chain timings it ended with
+            void addFrame(float frameMilliseconds, const SwapChain::FrameTimings& timings);
+            // Drops every sample, hitches waiting for their following frames are still written and the capture budget isn't refilled
+            void clear();
+
+            Summary summarize() const;
+            void print() const;
+
+        private:
+            struct PendingHitch{
+                uint64_t frame;
+                float frameMilliseconds;
+                SwapChain::FrameTimings timings;
+                // CpuProfiler timestamp the capture starts from
+                uint64_t begin;
+            };
+
+            void writeHitch(const PendingHitch& hitch);
+
+            const GpuProfiler* gpuProfiler;
+            FrameStatsSettings settings;
+
+            Histogram histogram;
+            std::vector<float> lowsWindow;
+            uint32_t nextLowsSample = 0;
+
+            RollingStats fenceWait;
+            RollingStats acquire;
+            RollingStats submit;
+            RollingStats present;
+
+            uint64_t frameNumber = 0;
+            // CpuProfiler timestamps of the starts of the last framesBeforeHitch + 1 frames
+            std::deque<uint64_t> frameStarts;
+            std::vector<PendingHitch> pendingHitches;
+            uint32_t hitchCount = 0;
+            // Captures taken over the whole run, clear() doesn't reset it so the maxHitchCaptures budget holds across settings changes
+            uint32_t hitchCaptureCount = 0;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "gpu_profiler.hpp"
+
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+
+namespace Renderer{
+    GpuProfiler::Scope::Scope(GpuProfiler& profiler, VkCommandBuffer commandBuffer, const char* name) 
+    : profiler{profiler}, commandBuffer{commandBuffer}, zone{profiler.beginZone(commandBuffer, name)}{}
+
+    GpuProfiler::Scope::~Scope(){
+        profiler.endZone(commandBuffer, zone);
+    }
+
+    GpuProfiler::GpuProfiler(Device& device, uint32_t framesInFlight, uint32_t maxZonesPerFrame, uint32_t windowSize) 
+    : device{device}, framesInFlight{framesInFlight}, maxZonesPerFrame{maxZonesPerFrame}, windowSize{windowSize}{
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+        timestampValidBits = queueFamilies[device.getPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+        nanosecondsPerTick = device.getProperties().limits.timestampPeriod;
+
+        if(isSupported())
+            createQueryPool();
+        else
+            std::cout << "GPU profiler: timestamps not supported on the graphics queue." << '\n';
+    }
+
+    GpuProfiler::~GpuProfiler(){
+        if(queryPool != VK_NULL_HANDLE)
+            vkDestroyQueryPool(device.getDevice(), queryPool, nullptr);
+    }
+
+    void GpuProfiler::createQueryPool(){
+        // Two timestamps per zone, one slice of the pool per frame in flight
+        VkQueryPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = framesInFlight * maxZonesPerFrame * 2;
+
+        if(vkCreateQueryPool(device.getDevice(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create timestamp query pool.");
+
+        frameZones.assign(framesInFlight, {});
+        currentFrameIndex = 0;
+    }
+
+    void GpuProfiler::setFramesInFlight(uint32_t newFramesInFlight){
+        if(!isSupported())
+            return;
+        vkDestroyQueryPool(device.getDevice(), queryPool, nullptr);
+        framesInFlight = newFramesInFlight;
+        createQueryPool();
+    }
+
+    void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex){
+        if(!isSupported())
+            return;
+        currentFrameIndex = frameIndex;
+        collectResults(frameIndex);
+        frameZones[frameIndex].clear();
+        vkCmdResetQueryPool(commandBuffer, queryPool, frameIndex * maxZonesPerFrame * 2, maxZonesPerFrame * 2);
+    }
+
+    uint32_t GpuProfiler::beginZone(VkCommandBuffer commandBuffer, const char* name){
+        if(!isSupported())
+            return invalidZone;
+        auto& zones = frameZones[currentFrameIndex];
+        if(zones.size() >= maxZonesPerFrame)
+            return invalidZone;
+
+        uint32_t firstQuery = (currentFrameIndex * maxZonesPerFrame + static_cast<uint32_t>(zones.size())) * 2;
+        zones.push_back({name, firstQuery});
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, firstQuery);
+        return static_cast<uint32_t>(zones.size() - 1);
+    }
+
+    void GpuProfiler::endZone(VkCommandBuffer commandBuffer, uint32_t zone){
+        if(zone == invalidZone)
+            return;
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, frameZones[currentFrameIndex][zone].firstQuery + 1);
+    }
+
+    void GpuProfiler::collectResults(uint32_t frameIndex){
+        const auto& zones = frameZones[frameIndex];
+        if(zones.empty())
+            return;
+
+        // Per query: the timestamp followed by its availability, written without waiting
+        std::vector<uint64_t> results(zones.size() * 2 * 2);
+        VkResult result = vkGetQueryPoolResults(device.getDevice(), queryPool, frameIndex * maxZonesPerFrame * 2, static_cast<uint32_t>(zones.size() * 2),
+            results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if(result != VK_SUCCESS && result != VK_NOT_READY)
+            return;
+
+        uint64_t mask = timestampValidBits >= 64 ? UINT64_MAX : (1ull << timestampValidBits) - 1;
+        std::vector<ZoneTime> frameTimes;
+        for(size_t i = 0; i < zones.size(); i++){
+            const uint64_t* begin = &results[i * 4];
+            const uint64_t* end = &results[i * 4 + 2];
+            // Zones whose end was never written (or isn't available yet) are skipped rather than waited on
+            if(begin[1] == 0 || end[1] == 0)
+                continue;
+
+            uint64_t ticks = ((end[0] & mask) - (begin[0] & mask)) & mask;
+            double milliseconds = ticks * nanosecondsPerTick / 1e6;
+
+            auto stats = zoneStats.find(zones[i].name);
+            if(stats == zoneStats.end()){
+                stats = zoneStats.emplace(zones[i].name, RollingStats{windowSize}).first;
+                zoneOrder.push_back(zones[i].name);
+            }
+            stats->second.addSample(milliseconds);
+            frameTimes.push_back({zones[i].name, milliseconds});
+        }
+
+        recentFrames.push_back(std::move(frameTimes));
+        if(recentFrames.size() > recentFrameCount)
+            recentFrames.pop_front();
+    }
+
+    std::vector<GpuProfiler::ZoneStats> GpuProfiler::getStats() const {
+        std::vector<ZoneStats> stats;
+        for(const auto& name : zoneOrder)
+            stats.push_back({name, zoneStats.at(name).summarize()});
+        return stats;
+    }
+
+    void GpuProfiler::printStats() const {
+        for(const auto& zone : getStats()){
+            std::cout << "GPU " << std::left << std::setw(12) << zone.name << std::right << std::fixed << std::setprecision(3)
+                << " min " << zone.milliseconds.min << " ms, avg " << zone.milliseconds.average << " ms, p95 " << zone.milliseconds.p95 << " ms" << '\n';
+        }
+        std::cout << std::defaultfloat;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "engine/device/device.hpp"
+#include "engine/profiling/rolling_stats.hpp"
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <deque>
+
+namespace Renderer{
+    // Times GPU work with timestamp queries. Each frame in flight has its own slice of the query pool, which is read back
+    // when that frame comes around again (after its fence), so results are a few frames late but never stall the CPU.
+    // Zones must be recorded into the frame's primary command buffer on the thread that records it.
+    class GpuProfiler{
+        public:
+            struct ZoneTime{
+                const char* name;
+                double milliseconds;
+            };
+
+            struct ZoneStats{
+                std::string name;
+                RollingStats::Summary milliseconds;
+            };
+
+            // Writes begin/end timestamps around everything recorded during its lifetime
+            class Scope{
+                public:
+                    Scope(GpuProfiler& profiler, VkCommandBuffer commandBuffer, const char* name);
+                    ~Scope();
+
+                    Scope(const Scope&) = delete;
+                    Scope& operator=(const Scope&) = delete;
+
+                private:
+                    GpuProfiler& profiler;
+                    VkCommandBuffer commandBuffer;
+                    uint32_t zone;
+            };
+
+            GpuProfiler(Device& device, uint32_t framesInFlight, uint32_t maxZonesPerFrame = 32, uint32_t windowSize = 240);
+            ~GpuProfiler();
+
+            GpuProfiler(const GpuProfiler&) = delete;
+            GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+            // Recreates the query pool, the device must be idle
+            void setFramesInFlight(uint32_t framesInFlight);
+
+            // Collects the results this frame slot last produced and resets its queries, must be recorded at the start
+            // of the frame's command buffer (outside of a render pass) after the frame's fence has been waited on
+            void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+            // Returns a handle for endZone, zones past maxZonesPerFrame in a frame are dropped
+            uint32_t beginZone(VkCommandBuffer commandBuffer, const char* name);
+            void endZone(VkCommandBuffer commandBuffer, uint32_t zone);
+
+            // Per zone min/avg/p95 over the rolling window, in the order zones were first seen
+            std::vector<ZoneStats> getStats() const;
+            // Zone times of the last recentFrameCount frames read back, oldest first. Frames are read back framesInFlight
+            // frames after they were recorded.
+            const std::deque<std::vector<ZoneTime>>& getRecentFrames() const { return recentFrames; }
+            void printStats() const;
+
+            // False when the graphics queue can't write timestamps, every call is then a no-op
+            bool isSupported() const { return timestampValidBits != 0; }
+
+            static constexpr uint32_t invalidZone = UINT32_MAX;
+            static constexpr uint32_t recentFrameCount = 8;
+
+        private:
+            struct Zone{
+                const char* name;
+                uint32_t firstQuery;
+            };
+
+            void createQueryPool();
+            void collectResults(uint32_t frameIndex);
+
+            Device& device;
+            VkQueryPool queryPool = VK_NULL_HANDLE;
+            uint32_t framesInFlight;
+            uint32_t maxZonesPerFrame;
+            uint32_t windowSize;
+
+            uint32_t timestampValidBits = 0;
+            double nanosecondsPerTick = 1.0;
+
+            // Zones written into each frame slot, waiting to be read back
+            std::vector<std::vector<Zone>> frameZones;
+            uint32_t currentFrameIndex = 0;
+
+            std::unordered_map<std::string, RollingStats> zoneStats;
+            std::vector<std::string> zoneOrder;
+            std::deque<std::vector<ZoneTime>> recentFrames;
+    };
+}
\ No newline at end of file
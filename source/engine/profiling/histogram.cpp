@@ -0,0 +1,64 @@
+#include "histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Renderer{
+    namespace{
+        uint32_t highestBit(uint64_t value){
+            uint32_t bit = 0;
+            while(value >>= 1)
+                bit++;
+            return bit;
+        }
+    }
+
+    Histogram::Histogram() : counts(subBucketCount + (maxValueBits - subBucketBits + 1) * (subBucketCount / 2), 0){}
+
+    uint32_t Histogram::getBucketIndex(uint64_t microseconds){
+        if(microseconds < subBucketCount)
+            return static_cast<uint32_t>(microseconds);
+
+        // Shift the value down until it fits in [subBucketCount / 2, subBucketCount), the shift picks the range
+        uint32_t shift = std::min(highestBit(microseconds), maxValueBits) - subBucketBits + 1;
+        uint64_t subBucket = std::min<uint64_t>(microseconds >> shift, subBucketCount - 1);
+        return subBucketCount + (shift - 1) * (subBucketCount / 2) + static_cast<uint32_t>(subBucket - subBucketCount / 2);
+    }
+
+    uint64_t Histogram::getBucketUpperBound(uint32_t index){
+        if(index < subBucketCount)
+            return index;
+        uint32_t shift = (index - subBucketCount) / (subBucketCount / 2) + 1;
+        uint64_t subBucket = (index - subBucketCount) % (subBucketCount / 2) + subBucketCount / 2;
+        return ((subBucket + 1) << shift) - 1;
+    }
+
+    void Histogram::record(double milliseconds){
+        milliseconds = std::max(milliseconds, 0.0);
+        uint64_t microseconds = static_cast<uint64_t>(std::llround(milliseconds * 1000.0));
+        counts[getBucketIndex(microseconds)]++;
+        count++;
+        totalMilliseconds += milliseconds;
+        maxMilliseconds = std::max(maxMilliseconds, milliseconds);
+    }
+
+    void Histogram::clear(){
+        std::fill(counts.begin(), counts.end(), 0);
+        count = 0;
+        totalMilliseconds = 0.0;
+        maxMilliseconds = 0.0;
+    }
+
+    double Histogram::getValueAtPercentile(double fraction) const {
+        if(count == 0)
+            return 0.0;
+        uint64_t target = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * count)), 1);
+        uint64_t seen = 0;
+        for(uint32_t i = 0; i < counts.size(); i++){
+            seen += counts[i];
+            if(seen >= target)
+                return std::min(getBucketUpperBound(i) / 1000.0, maxMilliseconds);
+        }
+        return maxMilliseconds;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+namespace Renderer{
+    // HDR-style histogram of durations in microseconds: the first subBucketCount values are counted exactly, above that every
+    // power of two range is split into subBucketCount / 2 linear buckets, so any value is within 1/64 of its bucket's bound.
+    // Recording is O(1) and memory fixed, however many samples are recorded.
+    class Histogram{
+        public:
+            Histogram();
+
+            void record(double milliseconds);
+            void clear();
+
+            // Highest value that fraction (0 to 1) of the samples are at or below, to the bucket's precision
+            double getValueAtPercentile(double fraction) const;
+            double getAverage() const { return count > 0 ? totalMilliseconds / count : 0.0; }
+            double getMax() const { return maxMilliseconds; }
+            uint64_t getCount() const { return count; }
+
+            static constexpr uint32_t subBucketBits = 7;
+            static constexpr uint32_t subBucketCount = 1u << subBucketBits;
+            // Microseconds above 2^maxValueBits (about 19 hours) land in the last bucket
+            static constexpr uint32_t maxValueBits = 36;
+
+        private:
+            static uint32_t getBucketIndex(uint64_t microseconds);
+            static uint64_t getBucketUpperBound(uint32_t index);
+
+            std::vector<uint64_t> counts;
+            uint64_t count = 0;
+            double totalMilliseconds = 0.0;
+            double maxMilliseconds = 0.0;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include "rolling_stats.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+namespace Renderer{
+    RollingStats::RollingStats(uint32_t windowSize) : windowSize{std::max(windowSize, 1u)}{
+        samples.reserve(this->windowSize);
+    }
+
+    void RollingStats::addSample(double value){
+        lastSample = value;
+        if(samples.size() < windowSize)
+            samples.push_back(value);
+        else
+            samples[nextSample] = value;
+        nextSample = (nextSample + 1) % windowSize;
+    }
+
+    void RollingStats::clear(){
+        samples.clear();
+        nextSample = 0;
+        lastSample = 0.0;
+    }
+
+    RollingStats::Summary RollingStats::summarize() const {
+        Summary summary;
+        if(samples.empty())
+            return summary;
+
+        std::vector<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        summary.sampleCount = static_cast<uint32_t>(sorted.size());
+        summary.min = sorted.front();
+        summary.max = sorted.back();
+        summary.average = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+        // Nearest rank
+        size_t rank = static_cast<size_t>(std::ceil(0.95 * sorted.size()));
+        summary.p95 = sorted[std::max<size_t>(rank, 1) - 1];
+        summary.last = lastSample;
+        return summary;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+namespace Renderer{
+    // Keeps the last windowSize samples of a value and summarises them on request
+    class RollingStats{
+        public:
+            struct Summary{
+                double min = 0.0;
+                double average = 0.0;
+                double p95 = 0.0;
+                double max = 0.0;
+                double last = 0.0;
+                uint32_t sampleCount = 0;
+            };
+
+            RollingStats(uint32_t windowSize = 240);
+
+            void addSample(double value);
+            void clear();
+            // Sorts a copy of the window, so meant for periodic reporting rather than every frame
+            Summary summarize() const;
+
+        private:
+            std::vector<double> samples;
+            uint32_t windowSize;
+            uint32_t nextSample = 0;
+            double lastSample = 0.0;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,817 @@
+#include "render_graph.hpp"
+
+#include "engine/profiling/cpu_profiler.hpp"
+#include "engine/profiling/gpu_profiler.hpp"
+
+#include <stdexcept>
+#include <cassert>
+#include <algorithm>
+#include <numeric>
+
+namespace Renderer{
+    namespace{
+        // Dispatchable handles are pointers and non-dispatchable ones may be 64-bit integers, both fit a cache key
+        template<typename T>
+        uint64_t handleKey(T handle){
+            return (uint64_t)handle;
+        }
+
+        VkImageAspectFlags getAspectMask(VkFormat format){
+            switch(format){
+                case VK_FORMAT_D16_UNORM_S8_UINT:
+                case VK_FORMAT_D24_UNORM_S8_UINT:
+                case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+                case VK_FORMAT_D16_UNORM:
+                case VK_FORMAT_X8_D24_UNORM_PACK32:
+                case VK_FORMAT_D32_SFLOAT:
+                    return VK_IMAGE_ASPECT_DEPTH_BIT;
+                default:
+                    return VK_IMAGE_ASPECT_COLOR_BIT;
+            }
+        }
+
+        constexpr VkAccessFlags writeAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | 
+            VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+        VkImageUsageFlags getImageUsage(RenderGraph::Access access){
+            switch(access){
+                case RenderGraph::Access::VertexShaderRead:
+                case RenderGraph::Access::FragmentShaderRead:
+                case RenderGraph::Access::ComputeShaderRead:
+                    return VK_IMAGE_USAGE_SAMPLED_BIT;
+                case RenderGraph::Access::ComputeShaderWrite:
+                    return VK_IMAGE_USAGE_STORAGE_BIT;
+                case RenderGraph::Access::TransferRead:
+                    return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+                case RenderGraph::Access::TransferWrite:
+                    return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+                case RenderGraph::Access::ColourAttachment:
+                case RenderGraph::Access::ResolveAttachment:
+                    return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+                case RenderGraph::Access::DepthAttachment:
+                    return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+                default:
+                    return 0;
+            }
+        }
+    }
+
+    void RenderGraph::PassBuilder::read(Resource resource, Access access){
+        graph.addAccess(pass, resource, access, true, false, false);
+    }
+
+    void RenderGraph::PassBuilder::write(Resource resource, Access access){
+        // Not known to overwrite everything, so earlier writers stay alive
+        graph.addAccess(pass, resource, access, false, true, false);
+    }
+
+    void RenderGraph::PassBuilder::colourAttachment(Resource resource, std::optional<VkClearColorValue> clear){
+        PassData& data = graph.passes[pass];
+        std::optional<VkClearValue> clearValue;
+        if(clear){
+            clearValue = VkClearValue{};
+            clearValue->color = *clear;
+        }
+        data.colourAttachments.push_back({resource, clearValue});
+        data.resolveAttachments.push_back(nullResource);
+        graph.addAccess(pass, resource, Access::ColourAttachment, !clear, true, clear.has_value());
+    }
+
+    void RenderGraph::PassBuilder::depthAttachment(Resource resource, std::optional<VkClearDepthStencilValue> clear){
+        PassData& data = graph.passes[pass];
+        assert(!data.depthAttachment && "A pass can only have one depth attachment.");
+        std::optional<VkClearValue> clearValue;
+        if(clear){
+            clearValue = VkClearValue{};
+            clearValue->depthStencil = *clear;
+        }
+        data.depthAttachment = Attachment{resource, clearValue};
+        graph.addAccess(pass, resource, Access::DepthAttachment, !clear, true, clear.has_value());
+    }
+
+    void RenderGraph::PassBuilder::resolveAttachment(Resource resource){
+        PassData& data = graph.passes[pass];
+        assert(!data.colourAttachments.empty() && data.resolveAttachments.back() == nullResource && "Resolve attachments must follow the colour attachment they resolve.");
+        data.resolveAttachments.back() = resource;
+        graph.addAccess(pass, resource, Access::ResolveAttachment, false, true, true);
+    }
+
+    void RenderGraph::PassBuilder::useSecondaryCommandBuffers(){
+        graph.passes[pass].secondaryCommandBuffers = true;
+    }
+
+    void RenderGraph::PassBuilder::setSideEffects(){
+        graph.passes[pass].sideEffects = true;
+    }
+
+    RenderGraph::RenderGraph(Device& device, uint32_t framesInFlight) : device{device}, framesInFlight{framesInFlight}{
+        frameTransients.resize(framesInFlight);
+    }
+
+    RenderGraph::~RenderGraph(){
+        for(auto& transients : frameTransients)
+            destroyTransients(transients);
+        releaseFramebuffers();
+        for(auto& [key, renderPass] : renderPasses)
+            vkDestroyRenderPass(device.getDevice(), renderPass, nullptr);
+    }
+
+    void RenderGraph::setFramesInFlight(uint32_t count){
+        for(auto& transients : frameTransients)
+            destroyTransients(transients);
+        framesInFlight = count;
+        frameTransients.clear();
+        frameTransients.resize(count);
+        frameIndex = 0;
+    }
+
+    void RenderGraph::releaseFramebuffers(){
+        for(auto& [key, framebuffer] : framebuffers)
+            vkDestroyFramebuffer(device.getDevice(), framebuffer, nullptr);
+        framebuffers.clear();
+    }
+
+    void RenderGraph::reset(uint32_t frame){
+        assert(frame < framesInFlight && "Frame index out of range.");
+        frameIndex = frame;
+        resources.clear();
+        passes.clear();
+        passOrder.clear();
+    }
+
+    RenderGraph::Resource RenderGraph::createImage(const char* name, const ImageDescription& description){
+        ResourceData data{};
+        data.name = name;
+        data.isImage = true;
+        data.imported = false;
+        data.description = description;
+        resources.push_back(data);
+        return static_cast<Resource>(resources.size() - 1);
+    }
+
+    RenderGraph::Resource RenderGraph::importImage(const char* name, const ImportedImage& image){
+        ResourceData data{};
+        data.name = name;
+        data.isImage = true;
+        data.imported = true;
+        data.description = image.description;
+        data.image = image.image;
+        data.view = image.view;
+        data.initialLayout = image.initialLayout;
+        data.finalLayout = image.finalLayout;
+        data.output = image.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED;
+        data.state.layout = image.initialLayout;
+        resources.push_back(data);
+        return static_cast<Resource>(resources.size() - 1);
+    }
+
+    RenderGraph::Resource RenderGraph::importBuffer(const char* name, VkBuffer buffer, bool output){
+        ResourceData data{};
+        data.name = name;
+        data.isImage = false;
+        data.imported = true;
+        data.buffer = buffer;
+        data.output = output;
+        resources.push_back(data);
+        return static_cast<Resource>(resources.size() - 1);
+    }
+
+    void RenderGraph::addPass(const char* name, const SetupFunction& setup, ExecuteFunction execute){
+        passes.emplace_back();
+        passes.back().name = name;
+        passes.back().execute = std::move(execute);
+        PassBuilder builder{*this, static_cast<uint32_t>(passes.size() - 1)};
+        setup(builder);
+    }
+
+    void RenderGraph::addAccess(uint32_t pass, Resource resource, Access access, bool reads, bool writes, bool discards){
+        assert(resource < resources.size() && "Unknown render graph resource.");
+        ResourceData& data = resources[resource];
+        assert((data.isImage || (access != Access::ColourAttachment && access != Access::DepthAttachment && access != Access::ResolveAttachment)) && "Attachments must be images.");
+        assert((!data.isImage || (access != Access::HostWrite && access != Access::IndirectBuffer)) && "Images can't be host written or used as indirect buffers.");
+        if(data.isImage && !data.imported)
+            data.usage |= getImageUsage(access);
+        passes[pass].accesses.push_back({resource, access, reads, writes, discards});
+    }
+
+    RenderGraph::AccessInfo RenderGraph::getAccessInfo(Access access){
+        // Shader reads of images are sampled reads, shader writes of images storage writes
+        switch(access){
+            case Access::HostWrite:
+                return {0, 0, VK_IMAGE_LAYOUT_UNDEFINED};
+            case Access::IndirectBuffer:
+                return {VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED};
+            case Access::VertexShaderRead:
+                return {VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+            case Access::FragmentShaderRead:
+                return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+            case Access::ComputeShaderRead:
+                return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+            case Access::ComputeShaderWrite:
+                return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL};
+            case Access::TransferRead:
+                return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL};
+            case Access::TransferWrite:
+                return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
+            case Access::ColourAttachment:
+                return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+            case Access::DepthAttachment:
+                return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+            case Access::ResolveAttachment:
+                return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+        }
+        throw std::invalid_argument("Unknown render graph access.");
+    }
+
+    void RenderGraph::execute(VkCommandBuffer commandBuffer, GpuProfiler* profiler){
+        RENDERER_PROFILE_SCOPE("RenderGraph::execute");
+        compile();
+        for(uint32_t passIndex : passOrder){
+            PassData& pass = passes[passIndex];
+            // Barriers are inside the zone, so time spent waiting on earlier passes shows up in the pass that waits
+            std::optional<GpuProfiler::Scope> zone;
+            if(profiler != nullptr)
+                zone.emplace(*profiler, commandBuffer, pass.name);
+            recordBarriers(commandBuffer, pass);
+            recordPass(commandBuffer, pass);
+        }
+        recordFinalTransitions(commandBuffer);
+    }
+
+    void RenderGraph::compile(){
+        RENDERER_PROFILE_SCOPE("RenderGraph::compile");
+        stats = {};
+        stats.passCount = static_cast<uint32_t>(passes.size());
+        cullPasses();
+        computeLifetimes();
+        allocateTransients();
+        createRenderPasses();
+    }
+
+    void RenderGraph::cullPasses(){
+        // Walk back from the outputs: a pass is live if it writes something still needed, which makes what it reads needed
+        std::vector<bool> needed(resources.size());
+        for(size_t i = 0; i < resources.size(); i++)
+            needed[i] = resources[i].output;
+
+        for(size_t i = passes.size(); i-- > 0;){
+            PassData& pass = passes[i];
+            bool live = pass.sideEffects;
+            for(const auto& access : pass.accesses)
+                live = live || (access.writes && needed[access.resource]);
+            pass.culled = !live;
+            if(!live){
+                stats.culledPassCount++;
+                continue;
+            }
+            // Whatever was in a resource the pass overwrites is dead, unless the pass also reads it
+            for(const auto& access : pass.accesses)
+                if(access.discards)
+                    needed[access.resource] = false;
+            for(const auto& access : pass.accesses)
+                if(access.reads)
+                    needed[access.resource] = true;
+        }
+
+        passOrder.clear();
+        for(uint32_t i = 0; i < passes.size(); i++)
+            if(!passes[i].culled)
+                passOrder.push_back(i);
+    }
+
+    void RenderGraph::computeLifetimes(){
+        for(uint32_t position = 0; position < passOrder.size(); position++)
+            for(const auto& access : passes[passOrder[position]].accesses){
+                ResourceData& resource = resources[access.resource];
+                if(resource.firstPass == UINT32_MAX)
+                    resource.firstPass = position;
+                resource.lastPass = position;
+            }
+    }
+
+    void RenderGraph::allocateTransients(){
+        FrameTransients& transients = frameTransients[frameIndex];
+
+        // Transient images used by a live pass, with what decides their creation and placement
+        std::vector<Resource> used;
+        std::vector<uint64_t> signature;
+        for(Resource i = 0; i < resources.size(); i++){
+            const ResourceData& resource = resources[i];
+            if(resource.imported || !resource.isImage || resource.firstPass == UINT32_MAX)
+                continue;
+            used.push_back(i);
+            signature.insert(signature.end(), {static_cast<uint64_t>(resource.description.format), resource.description.extent.width, 
+                resource.description.extent.height, static_cast<uint64_t>(resource.description.samples), resource.usage, resource.firstPass, resource.lastPass});
+        }
+
+        // The frame's fence has been waited on, so the slot's previous images are no longer in use
+        if(signature != transients.signature){
+            destroyTransients(transients);
+            transients.signature = signature;
+            transients.images.resize(used.size());
+
+            std::vector<VkMemoryRequirements> requirements(used.size());
+            for(size_t i = 0; i < used.size(); i++){
+                const ResourceData& resource = resources[used[i]];
+                TransientImage& transient = transients.images[i];
+                transient.description = resource.description;
+                transient.usage = resource.usage;
+
+                VkImageCreateInfo imageInfo{};
+                imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+                imageInfo.imageType = VK_IMAGE_TYPE_2D;
+                imageInfo.extent = {resource.description.extent.width, resource.description.extent.height, 1};
+                imageInfo.mipLevels = 1;
+                imageInfo.arrayLayers = 1;
+                imageInfo.format = resource.description.format;
+                imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+                imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                imageInfo.usage = resource.usage;
+                imageInfo.samples = resource.description.samples;
+                imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                if(vkCreateImage(device.getDevice(), &imageInfo, nullptr, &transient.image) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to create render graph image.");
+                vkGetImageMemoryRequirements(device.getDevice(), transient.image, &requirements[i]);
+                transients.requiredBytes += requirements[i].size;
+            }
+
+            // Largest first, each into the first block whose memory types fit and whose other images are dead or not yet used
+            std::vector<uint32_t> placementOrder(used.size());
+            std::iota(placementOrder.begin(), placementOrder.end(), 0);
+            std::stable_sort(placementOrder.begin(), placementOrder.end(), [&](uint32_t a, uint32_t b){ return requirements[a].size > requirements[b].size; });
+            for(uint32_t i : placementOrder){
+                const ResourceData& resource = resources[used[i]];
+                auto overlaps = [&](const std::pair<uint32_t, uint32_t>& range){ return range.first <= resource.lastPass && resource.firstPass <= range.second; };
+                uint32_t block = 0;
+                for(; block < transients.blocks.size(); block++){
+                    const MemoryBlock& candidate = transients.blocks[block];
+                    if((candidate.memoryTypeBits & requirements[i].memoryTypeBits) != 0 && std::none_of(candidate.passRanges.begin(), candidate.passRanges.end(), overlaps))
+                        break;
+                }
+                if(block == transients.blocks.size())
+                    transients.blocks.emplace_back();
+                MemoryBlock& memoryBlock = transients.blocks[block];
+                memoryBlock.memoryTypeBits &= requirements[i].memoryTypeBits;
+                // Every image is bound at offset 0, which satisfies any alignment
+                memoryBlock.size = std::max(memoryBlock.size, requirements[i].size);
+                memoryBlock.passRanges.push_back({resource.firstPass, resource.lastPass});
+                transients.images[i].memoryBlock = block;
+            }
+
+            for(auto& memoryBlock : transients.blocks){
+                VkMemoryAllocateInfo allocInfo{};
+                allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+                allocInfo.allocationSize = memoryBlock.size;
+                allocInfo.memoryTypeIndex = device.findMemoryType(memoryBlock.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+                if(vkAllocateMemory(device.getDevice(), &allocInfo, nullptr, &memoryBlock.memory) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to allocate render graph memory.");
+            }
+
+            for(auto& transient : transients.images){
+                if(vkBindImageMemory(device.getDevice(), transient.image, transients.blocks[transient.memoryBlock].memory, 0) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to bind render graph image memory.");
+
+                VkImageViewCreateInfo viewInfo{};
+                viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                viewInfo.image = transient.image;
+                viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                viewInfo.format = transient.description.format;
+                viewInfo.subresourceRange.aspectMask = getAspectMask(transient.description.format);
+                viewInfo.subresourceRange.levelCount = 1;
+                viewInfo.subresourceRange.layerCount = 1;
+                if(vkCreateImageView(device.getDevice(), &viewInfo, nullptr, &transient.view) != VK_SUCCESS)
+                    throw std::runtime_error("Failed to create render graph image view.");
+            }
+        }
+
+        for(size_t i = 0; i < used.size(); i++){
+            ResourceData& resource = resources[used[i]];
+            resource.image = transients.images[i].image;
+            resource.view = transients.images[i].view;
+            resource.memoryBlock = transients.images[i].memoryBlock;
+        }
+        for(auto& memoryBlock : transients.blocks){
+            memoryBlock.lastStages = 0;
+            memoryBlock.lastWriteAccess = 0;
+            stats.transientAllocatedBytes += memoryBlock.size;
+        }
+        stats.transientImageCount = static_cast<uint32_t>(used.size());
+        stats.transientRequiredBytes = transients.requiredBytes;
+    }
+
+    void RenderGraph::destroyTransients(FrameTransients& transients){
+        // Framebuffers are keyed by their views, drop the ones using views about to be destroyed
+        for(auto it = framebuffers.begin(); it != framebuffers.end();){
+            bool usesTransient = std::any_of(transients.images.begin(), transients.images.end(), [&](const TransientImage& transient){
+                return std::find(it->first.begin(), it->first.end(), handleKey(transient.view)) != it->first.end();
+            });
+            if(usesTransient){
+                vkDestroyFramebuffer(device.getDevice(), it->second, nullptr);
+                it = framebuffers.erase(it);
+            }
+            else
+                ++it;
+        }
+
+        for(auto& transient : transients.images){
+            if(transient.view != VK_NULL_HANDLE)
+                vkDestroyImageView(device.getDevice(), transient.view, nullptr);
+            if(transient.image != VK_NULL_HANDLE)
+                vkDestroyImage(device.getDevice(), transient.image, nullptr);
+        }
+        for(auto& memoryBlock : transients.blocks)
+            if(memoryBlock.memory != VK_NULL_HANDLE)
+                vkFreeMemory(device.getDevice(), memoryBlock.memory, nullptr);
+        transients = {};
+    }
+
+    void RenderGraph::createRenderPasses(){
+        // Attachments load their contents only when an earlier pass wrote them and store them only when a later one reads them
+        std::vector<bool> hasContents(resources.size());
+        for(size_t i = 0; i < resources.size(); i++)
+            hasContents[i] = resources[i].imported && resources[i].initialLayout != VK_IMAGE_LAYOUT_UNDEFINED;
+
+        auto readAfter = [&](uint32_t position, Resource resource){
+            if(resources[resource].output)
+                return true;
+            for(uint32_t later = position + 1; later < passOrder.size(); later++)
+                for(const auto& access : passes[passOrder[later]].accesses)
+                    if(access.resource == resource && access.reads)
+                        return true;
+            return false;
+        };
+
+        auto getLoadOp = [&](Resource resource, const std::optional<VkClearValue>& clear){
+            return clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : (hasContents[resource] ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+        };
+        auto getStoreOp = [&](uint32_t position, Resource resource){
+            return readAfter(position, resource) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        };
+        auto checkExtent = [&](PassData& pass, Resource resource, bool first){
+            const ImageDescription& description = resources[resource].description;
+            if(first)
+                pass.extent = description.extent;
+            assert(description.extent.width == pass.extent.width && description.extent.height == pass.extent.height && "Attachments of a pass must have the same extent.");
+        };
+
+        for(uint32_t position = 0; position < passOrder.size(); position++){
+            PassData& pass = passes[passOrder[position]];
+            if(hasAttachments(pass) && device.supportsDynamicRendering()){
+                // Everything is given to vkCmdBeginRendering when the pass is recorded, there is no render pass or framebuffer to build
+                pass.colourRenderingAttachments.clear();
+                pass.colourFormats.clear();
+                pass.depthRenderingAttachment.reset();
+                auto makeAttachment = [&](const Attachment& attachment, VkImageLayout layout){
+                    checkExtent(pass, attachment.resource, pass.colourRenderingAttachments.empty() && !pass.depthRenderingAttachment);
+                    VkRenderingAttachmentInfo info{};
+                    info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+                    info.imageView = resources[attachment.resource].view;
+                    info.imageLayout = layout;
+                    info.resolveMode = VK_RESOLVE_MODE_NONE;
+                    info.loadOp = getLoadOp(attachment.resource, attachment.clear);
+                    info.storeOp = getStoreOp(position, attachment.resource);
+                    info.clearValue = attachment.clear.value_or(VkClearValue{});
+                    return info;
+                };
+
+                VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+                for(size_t i = 0; i < pass.colourAttachments.size(); i++){
+                    VkRenderingAttachmentInfo info = makeAttachment(pass.colourAttachments[i], VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+                    Resource resolve = pass.resolveAttachments[i];
+                    if(resolve != nullResource){
+                        checkExtent(pass, resolve, false);
+                        info.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+                        info.resolveImageView = resources[resolve].view;
+                        info.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                    }
+                    pass.colourRenderingAttachments.push_back(info);
+                    pass.colourFormats.push_back(resources[pass.colourAttachments[i].resource].description.format);
+                    samples = resources[pass.colourAttachments[i].resource].description.samples;
+                }
+                VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+                if(pass.depthAttachment){
+                    pass.depthRenderingAttachment = makeAttachment(*pass.depthAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+                    depthFormat = resources[pass.depthAttachment->resource].description.format;
+                    samples = resources[pass.depthAttachment->resource].description.samples;
+                }
+
+                pass.inheritanceRenderingInfo = {};
+                pass.inheritanceRenderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+                pass.inheritanceRenderingInfo.colorAttachmentCount = static_cast<uint32_t>(pass.colourFormats.size());
+                pass.inheritanceRenderingInfo.pColorAttachmentFormats = pass.colourFormats.data();
+                pass.inheritanceRenderingInfo.depthAttachmentFormat = depthFormat;
+                pass.inheritanceRenderingInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+                pass.inheritanceRenderingInfo.rasterizationSamples = samples;
+            }
+            else if(hasAttachments(pass)){
+                std::vector<VkAttachmentDescription> descriptions;
+                std::vector<VkImageView> views;
+                pass.clearValues.clear();
+                auto addAttachment = [&](Resource resource, const std::optional<VkClearValue>& clear, VkImageLayout layout){
+                    const ResourceData& data = resources[resource];
+                    checkExtent(pass, resource, views.empty());
+
+                    // Layouts are transitioned by the graph's barriers, not by the render pass
+                    VkAttachmentDescription description{};
+                    description.format = data.description.format;
+                    description.samples = data.description.samples;
+                    description.loadOp = getLoadOp(resource, clear);
+                    description.storeOp = getStoreOp(position, resource);
+                    description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                    description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                    description.initialLayout = layout;
+                    description.finalLayout = layout;
+                    descriptions.push_back(description);
+                    views.push_back(data.view);
+                    pass.clearValues.push_back(clear.value_or(VkClearValue{}));
+                };
+
+                for(const auto& attachment : pass.colourAttachments)
+                    addAttachment(attachment.resource, attachment.clear, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+                if(pass.depthAttachment)
+                    addAttachment(pass.depthAttachment->resource, pass.depthAttachment->clear, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+                std::vector<uint32_t> resolveReferences;
+                for(Resource resolve : pass.resolveAttachments){
+                    if(resolve == nullResource){
+                        resolveReferences.push_back(VK_ATTACHMENT_UNUSED);
+                        continue;
+                    }
+                    resolveReferences.push_back(static_cast<uint32_t>(descriptions.size()));
+                    // Fully overwritten by the resolve, so never worth loading
+                    addAttachment(resolve, std::nullopt, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+                    descriptions.back().loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                }
+
+                pass.renderPass = getRenderPass(descriptions, static_cast<uint32_t>(pass.colourAttachments.size()), pass.depthAttachment.has_value(), resolveReferences);
+                pass.framebuffer = getFramebuffer(pass.renderPass, views, pass.extent);
+            }
+
+            for(const auto& access : pass.accesses)
+                if(access.writes)
+                    hasContents[access.resource] = true;
+        }
+    }
+
+    VkRenderPass RenderGraph::getRenderPass(const std::vector<VkAttachmentDescription>& attachments, uint32_t colourCount, bool hasDepth, const std::vector<uint32_t>& resolveReferences){
+        std::vector<uint64_t> key{colourCount, hasDepth};
+        key.insert(key.end(), resolveReferences.begin(), resolveReferences.end());
+        for(const auto& attachment : attachments)
+            key.insert(key.end(), {static_cast<uint64_t>(attachment.format), static_cast<uint64_t>(attachment.samples), static_cast<uint64_t>(attachment.loadOp), 
+                static_cast<uint64_t>(attachment.storeOp), static_cast<uint64_t>(attachment.initialLayout)});
+        auto cached = renderPasses.find(key);
+        if(cached != renderPasses.end())
+            return cached->second;
+
+        std::vector<VkAttachmentReference> colourReferences;
+        for(uint32_t i = 0; i < colourCount; i++)
+            colourReferences.push_back({i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+        VkAttachmentReference depthReference{colourCount, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+        std::vector<VkAttachmentReference> resolveAttachmentReferences;
+        for(uint32_t reference : resolveReferences)
+            resolveAttachmentReferences.push_back({reference, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+        bool hasResolve = std::any_of(resolveReferences.begin(), resolveReferences.end(), [](uint32_t reference){ return reference != VK_ATTACHMENT_UNUSED; });
+
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = colourCount;
+        subpass.pColorAttachments = colourReferences.data();
+        subpass.pDepthStencilAttachment = hasDepth ? &depthReference : nullptr;
+        subpass.pResolveAttachments = hasResolve ? resolveAttachmentReferences.data() : nullptr;
+
+        // No dependencies, the graph's barriers around the pass take care of synchronisation
+        VkRenderPassCreateInfo renderPassInfo = {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        renderPassInfo.pAttachments = attachments.data();
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+
+        VkRenderPass renderPass;
+        if (vkCreateRenderPass(device.getDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create render graph render pass.");
+        renderPasses.emplace(std::move(key), renderPass);
+        return renderPass;
+    }
+
+    VkFramebuffer RenderGraph::getFramebuffer(VkRenderPass renderPass, const std::vector<VkImageView>& views, VkExtent2D extent){
+        std::vector<uint64_t> key{handleKey(renderPass), extent.width, extent.height};
+        for(VkImageView view : views)
+            key.push_back(handleKey(view));
+        auto cached = framebuffers.find(key);
+        if(cached != framebuffers.end())
+            return cached->second;
+
+        VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+        framebufferInfo.pAttachments = views.data();
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+
+        VkFramebuffer framebuffer;
+        if (vkCreateFramebuffer(device.getDevice(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create render graph framebuffer.");
+        framebuffers.emplace(std::move(key), framebuffer);
+        return framebuffer;
+    }
+
+    void RenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const PassData& pass){
+        // Accesses of the same resource within a pass are merged into one
+        std::vector<std::pair<Resource, AccessInfo>> accesses;
+        for(const auto& access : pass.accesses){
+            AccessInfo info = getAccessInfo(access.access);
+            if(info.stages == 0)
+                continue;
+            auto merged = std::find_if(accesses.begin(), accesses.end(), [&](const auto& entry){ return entry.first == access.resource; });
+            if(merged == accesses.end()){
+                accesses.push_back({access.resource, info});
+                continue;
+            }
+            assert((!resources[access.resource].isImage || merged->second.layout == info.layout) && "An image can't be used in two layouts by one pass.");
+            merged->second.stages |= info.stages;
+            merged->second.access |= info.access;
+        }
+
+        VkPipelineStageFlags srcStages = 0, dstStages = 0;
+        VkMemoryBarrier memoryBarrier = {};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+
+        for(const auto& [resource, info] : accesses){
+            ResourceData& data = resources[resource];
+            ResourceState& state = data.state;
+            bool writes = (info.access & writeAccessMask) != 0;
+            bool layoutChange = data.isImage && state.layout != info.layout;
+
+            VkPipelineStageFlags waitStages = 0;
+            VkAccessFlags waitAccess = 0;
+            if(writes || layoutChange){
+                // Reads before a write only have to finish, earlier writes have to be made available too
+                waitStages = state.writeStages | state.readStages;
+                waitAccess = state.writeAccess;
+            }
+            else if(state.writeStages != 0 && ((info.stages & ~state.visibleStages) != 0 || (info.access & ~state.visibleAccess) != 0)){
+                waitStages = state.writeStages;
+                waitAccess = state.writeAccess;
+            }
+            // The first image placed in shared memory this frame waits for the block's previous images
+            bool firstUse = state.writeStages == 0 && state.readStages == 0;
+            if(firstUse && data.memoryBlock != UINT32_MAX){
+                const MemoryBlock& block = frameTransients[frameIndex].blocks[data.memoryBlock];
+                waitStages |= block.lastStages;
+                waitAccess |= block.lastWriteAccess;
+            }
+
+            if(waitStages != 0 || layoutChange){
+                // Nothing to wait for, but a layout transition at the same stages still chains onto semaphore waits (swap chain images)
+                srcStages |= waitStages != 0 ? waitStages : info.stages;
+                dstStages |= info.stages;
+                if(data.isImage){
+                    VkImageMemoryBarrier barrier = {};
+                    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                    barrier.srcAccessMask = waitAccess;
+                    barrier.dstAccessMask = info.access;
+                    // From UNDEFINED the old contents are discarded, which is all first uses of transient images need
+                    barrier.oldLayout = state.layout;
+                    barrier.newLayout = info.layout;
+                    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    barrier.image = data.image;
+                    barrier.subresourceRange.aspectMask = getAspectMask(data.description.format);
+                    barrier.subresourceRange.levelCount = 1;
+                    barrier.subresourceRange.layerCount = 1;
+                    imageBarriers.push_back(barrier);
+                }
+                else{
+                    // Buffers share one global memory barrier, which drivers handle as well as per-buffer ones
+                    memoryBarrier.srcAccessMask |= waitAccess;
+                    memoryBarrier.dstAccessMask |= info.access;
+                }
+                stats.barrierCount++;
+            }
+
+            if(writes || layoutChange){
+                // A transition counts as a write, later readers in other stages still have to wait for it
+                state.writeStages = info.stages;
+                state.writeAccess = info.access & writeAccessMask;
+                state.readStages = writes ? 0 : info.stages;
+                state.visibleStages = writes ? 0 : info.stages;
+                state.visibleAccess = writes ? 0 : info.access;
+                state.layout = info.layout;
+            }
+            else{
+                state.readStages |= info.stages;
+                state.visibleStages |= info.stages;
+                state.visibleAccess |= info.access;
+            }
+
+            if(data.memoryBlock != UINT32_MAX){
+                MemoryBlock& block = frameTransients[frameIndex].blocks[data.memoryBlock];
+                block.lastStages |= info.stages;
+                block.lastWriteAccess |= state.writeAccess;
+            }
+        }
+
+        if(srcStages != 0)
+            vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0, (memoryBarrier.srcAccessMask | memoryBarrier.dstAccessMask) != 0 ? 1 : 0, &memoryBarrier, 
+                0, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    }
+
+    void RenderGraph::recordFinalTransitions(VkCommandBuffer commandBuffer){
+        VkPipelineStageFlags srcStages = 0;
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        for(auto& data : resources){
+            if(!data.isImage || data.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || data.state.layout == data.finalLayout)
+                continue;
+            // An output no pass touched still has to chain onto whatever semaphore wait made it available
+            VkPipelineStageFlags waitStages = data.state.writeStages | data.state.readStages;
+            srcStages |= waitStages != 0 ? waitStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+            // Presentation and later submissions are made to wait by semaphores and fences, so nothing is made visible here
+            VkImageMemoryBarrier barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = data.state.writeAccess;
+            barrier.dstAccessMask = 0;
+            barrier.oldLayout = data.state.layout;
+            barrier.newLayout = data.finalLayout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = data.image;
+            barrier.subresourceRange.aspectMask = getAspectMask(data.description.format);
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.layerCount = 1;
+            imageBarriers.push_back(barrier);
+            data.state.layout = data.finalLayout;
+        }
+        if(imageBarriers.empty())
+            return;
+        stats.barrierCount += static_cast<uint32_t>(imageBarriers.size());
+        vkCmdPipelineBarrier(commandBuffer, srcStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    }
+
+    void RenderGraph::recordPass(VkCommandBuffer commandBuffer, PassData& pass){
+        PassContext context{};
+        context.commandBuffer = commandBuffer;
+        context.extent = pass.extent;
+        if(!hasAttachments(pass)){
+            pass.execute(context);
+            return;
+        }
+
+        beginRendering(commandBuffer, pass, context);
+
+        // Only vkCmdExecuteCommands is allowed in the primary when the contents are secondary command buffers
+        if(!pass.secondaryCommandBuffers){
+            VkViewport viewport{0.f, 0.f, static_cast<float>(pass.extent.width), static_cast<float>(pass.extent.height), 0.f, 1.f};
+            VkRect2D scissor{{0, 0}, pass.extent};
+            vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        }
+
+        pass.execute(context);
+        if(pass.renderPass != VK_NULL_HANDLE)
+            vkCmdEndRenderPass(commandBuffer);
+        else
+            vkCmdEndRendering(commandBuffer);
+    }
+
+    void RenderGraph::beginRendering(VkCommandBuffer commandBuffer, PassData& pass, PassContext& context){
+        context.inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        context.inheritanceInfo.subpass = 0;
+
+        if(pass.renderPass != VK_NULL_HANDLE){
+            VkRenderPassBeginInfo renderPassInfo = {};
+            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass = pass.renderPass;
+            renderPassInfo.framebuffer = pass.framebuffer;
+            renderPassInfo.renderArea.offset = { 0, 0 };
+            renderPassInfo.renderArea.extent = pass.extent;
+            renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+            renderPassInfo.pClearValues = pass.clearValues.data();
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, pass.secondaryCommandBuffers ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+
+            context.inheritanceInfo.renderPass = pass.renderPass;
+            context.inheritanceInfo.framebuffer = pass.framebuffer;
+            return;
+        }
+
+        VkRenderingInfo renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        renderingInfo.flags = pass.secondaryCommandBuffers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+        renderingInfo.renderArea = {{0, 0}, pass.extent};
+        renderingInfo.layerCount = 1;
+        renderingInfo.colorAttachmentCount = static_cast<uint32_t>(pass.colourRenderingAttachments.size());
+        renderingInfo.pColorAttachments = pass.colourRenderingAttachments.data();
+        renderingInfo.pDepthAttachment = pass.depthRenderingAttachment ? &*pass.depthRenderingAttachment : nullptr;
+        vkCmdBeginRendering(commandBuffer, &renderingInfo);
+
+        // Secondaries inherit the attachment formats instead of a render pass
+        context.inheritanceInfo.pNext = &pass.inheritanceRenderingInfo;
+        context.inheritanceInfo.renderPass = VK_NULL_HANDLE;
+        context.inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+    }
+}
\ No newline at end of file
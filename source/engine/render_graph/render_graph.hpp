@@ -0,0 +1,275 @@
+#pragma once
+
+#include "engine/device/device.hpp"
+
+#include <vector>
+#include <map>
+#include <optional>
+#include <functional>
+
+namespace Renderer{
+    class GpuProfiler;
+
+    // Frame graph rebuilt every frame. Passes declare the resources they read and write, then execute culls the passes
+    // whose results are never used, places transient images whose lifetimes don't overlap in the same memory, and records
+    // the remaining passes in order with only the barriers and layout transitions their accesses need. Passes with
+    // attachments are begun with vkCmdBeginRendering when the device supports dynamic rendering, otherwise they get a render
+    // pass and framebuffer built from them. Render passes, framebuffers and transient images are cached between frames,
+    // transient images per frame in flight.
+    class RenderGraph{
+        public:
+            using Resource = uint32_t;
+            static constexpr Resource nullResource = UINT32_MAX;
+
+            // How a pass uses a resource, each one maps to the pipeline stages, access mask and image layout barriers are built from
+            enum class Access{
+                HostWrite,          // Written on the CPU before the frame is submitted, visible to the whole submission
+                IndirectBuffer,
+                VertexShaderRead,
+                FragmentShaderRead,
+                ComputeShaderRead,
+                ComputeShaderWrite,
+                TransferRead,
+                TransferWrite,
+                // Declared through PassBuilder's attachment functions
+                ColourAttachment,
+                DepthAttachment,
+                ResolveAttachment
+            };
+
+            struct ImageDescription{
+                VkFormat format;
+                VkExtent2D extent;
+                VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+            };
+
+            // An image owned outside of the graph
+            struct ImportedImage{
+                VkImage image;
+                VkImageView view;
+                ImageDescription description;
+                VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                // Layout the image is left in after the graph. UNDEFINED means its contents aren't needed afterwards,
+                // anything else makes it an output that keeps the passes writing it alive.
+                VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            };
+
+            struct PassContext{
+                VkCommandBuffer commandBuffer;
+                // Passes with attachments only, for secondary command buffers continuing the pass. Its pNext chain is valid until the pass ends.
+                VkCommandBufferInheritanceInfo inheritanceInfo;
+                VkExtent2D extent;
+            };
+
+            class PassBuilder{
+                public:
+                    void read(Resource resource, Access access);
+                    void write(Resource resource, Access access);
+
+                    // Attachments without a clear value keep the image's contents when an earlier pass wrote them
+                    void colourAttachment(Resource resource, std::optional<VkClearColorValue> clear = std::nullopt);
+                    void depthAttachment(Resource resource, std::optional<VkClearDepthStencilValue> clear = std::nullopt);
+                    // Resolves the colour attachment added before it
+                    void resolveAttachment(Resource resource);
+                    // The pass is begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS and records no commands of its own
+                    // inside it, viewport and scissor aren't set
+                    void useSecondaryCommandBuffers();
+                    // Never culled, for passes whose effects the graph can't see
+                    void setSideEffects();
+
+                private:
+                    friend class RenderGraph;
+                    PassBuilder(RenderGraph& graph, uint32_t pass) : graph{graph}, pass{pass} {}
+
+                    RenderGraph& graph;
+                    uint32_t pass;
+            };
+
+            using SetupFunction = std::function<void(PassBuilder& builder)>;
+            using ExecuteFunction = std::function<void(const PassContext& context)>;
+
+            struct Stats{
+                uint32_t passCount = 0;
+                uint32_t culledPassCount = 0;
+                uint32_t barrierCount = 0;
+                uint32_t transientImageCount = 0;
+                // Memory the transient images would need on their own, and what they need with aliasing
+                VkDeviceSize transientRequiredBytes = 0;
+                VkDeviceSize transientAllocatedBytes = 0;
+            };
+
+            RenderGraph(Device& device, uint32_t framesInFlight);
+            ~RenderGraph();
+
+            RenderGraph(const RenderGraph&) = delete;
+            RenderGraph& operator=(const RenderGraph&) = delete;
+
+            // Recreates nothing up front, the frame slots' transient images are rebuilt on their next use. The device must be idle.
+            void setFramesInFlight(uint32_t count);
+            // Destroys every cached framebuffer, must be called (with the device idle) before imported views are destroyed
+            void releaseFramebuffers();
+
+            // Starts a new graph for the frame slot, whose fence must have been waited on
+            void reset(uint32_t frameIndex);
+
+            // Names must outlive the graph's frames (string literals), passes are timed under them by the GPU profiler
+            Resource createImage(const char* name, const ImageDescription& description);
+            Resource importImage(const char* name, const ImportedImage& image);
+            // Outputs keep the passes writing them alive
+            Resource importBuffer(const char* name, VkBuffer buffer, bool output = false);
+
+            // setup is called immediately, execute when the graph is executed if the pass survives culling
+            void addPass(const char* name, const SetupFunction& setup, ExecuteFunction execute);
+
+            // Compiles the graph and records its passes, each in a GPU profiler zone when profiler isn't null
+            void execute(VkCommandBuffer commandBuffer, GpuProfiler* profiler = nullptr);
+
+            // Valid while the graph executes
+            VkImage getImage(Resource resource) const { return resources[resource].image; }
+            VkImageView getImageView(Resource resource) const { return resources[resource].view; }
+            VkBuffer getBuffer(Resource resource) const { return resources[resource].buffer; }
+
+            // Of the last executed graph
+            const Stats& getStats() const { return stats; }
+
+        private:
+            struct AccessInfo{
+                VkPipelineStageFlags stages;
+                VkAccessFlags access;
+                VkImageLayout layout;
+            };
+
+            // Stages and accesses since the last write, for working out which barriers a new access needs
+            struct ResourceState{
+                VkPipelineStageFlags writeStages = 0;
+                VkAccessFlags writeAccess = 0;
+                // Reads since the last write, and the reads the last write has already been made visible to
+                VkPipelineStageFlags readStages = 0;
+                VkPipelineStageFlags visibleStages = 0;
+                VkAccessFlags visibleAccess = 0;
+                VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            };
+
+            struct ResourceData{
+                const char* name;
+                bool isImage;
+                bool imported;
+                ImageDescription description{};
+                VkImage image = VK_NULL_HANDLE;
+                VkImageView view = VK_NULL_HANDLE;
+                VkBuffer buffer = VK_NULL_HANDLE;
+                VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                bool output = false;
+                // Transient images, accumulated from their accesses
+                VkImageUsageFlags usage = 0;
+
+                // Live pass range, UINT32_MAX when no live pass uses the resource
+                uint32_t firstPass = UINT32_MAX;
+                uint32_t lastPass = UINT32_MAX;
+                // Transient images, index into the frame's memory blocks
+                uint32_t memoryBlock = UINT32_MAX;
+                ResourceState state;
+            };
+
+            struct ResourceAccess{
+                Resource resource;
+                Access access;
+                bool reads;
+                bool writes;
+                // Every earlier value is overwritten, so passes that only wrote it before can be culled
+                bool discards;
+            };
+
+            struct Attachment{
+                Resource resource;
+                std::optional<VkClearValue> clear;
+            };
+
+            struct PassData{
+                const char* name;
+                ExecuteFunction execute;
+                std::vector<ResourceAccess> accesses;
+                std::vector<Attachment> colourAttachments;
+                std::optional<Attachment> depthAttachment;
+                // One per colour attachment, nullResource when it isn't resolved
+                std::vector<Resource> resolveAttachments;
+                bool secondaryCommandBuffers = false;
+                bool sideEffects = false;
+
+                bool culled = false;
+                VkRenderPass renderPass = VK_NULL_HANDLE;
+                VkFramebuffer framebuffer = VK_NULL_HANDLE;
+                std::vector<VkClearValue> clearValues;
+                VkExtent2D extent{};
+                // Dynamic rendering only, the attachments vkCmdBeginRendering is given and what secondaries inherit
+                std::vector<VkRenderingAttachmentInfo> colourRenderingAttachments;
+                std::optional<VkRenderingAttachmentInfo> depthRenderingAttachment;
+                std::vector<VkFormat> colourFormats;
+                VkCommandBufferInheritanceRenderingInfo inheritanceRenderingInfo{};
+            };
+
+            struct TransientImage{
+                ImageDescription description;
+                VkImageUsageFlags usage;
+                VkImage image = VK_NULL_HANDLE;
+                VkImageView view = VK_NULL_HANDLE;
+                uint32_t memoryBlock;
+            };
+
+            // Images in the same block share its memory, their live pass ranges never overlap
+            struct MemoryBlock{
+                VkDeviceMemory memory = VK_NULL_HANDLE;
+                VkDeviceSize size = 0;
+                uint32_t memoryTypeBits = ~0u;
+                std::vector<std::pair<uint32_t, uint32_t>> passRanges;
+                // Accesses of the block's last user this frame, the next one has to wait for them
+                VkPipelineStageFlags lastStages = 0;
+                VkAccessFlags lastWriteAccess = 0;
+            };
+
+            // Transient images of a frame slot, kept while the graph's transient images and their lifetimes stay the same
+            struct FrameTransients{
+                std::vector<uint64_t> signature;
+                std::vector<TransientImage> images;
+                std::vector<MemoryBlock> blocks;
+                VkDeviceSize requiredBytes = 0;
+            };
+
+            static AccessInfo getAccessInfo(Access access);
+
+            void addAccess(uint32_t pass, Resource resource, Access access, bool reads, bool writes, bool discards);
+
+            void compile();
+            void cullPasses();
+            void computeLifetimes();
+            void allocateTransients();
+            void destroyTransients(FrameTransients& transients);
+            void createRenderPasses();
+            static bool hasAttachments(const PassData& pass) { return !pass.colourAttachments.empty() || pass.depthAttachment.has_value(); }
+            // Attachments are ordered colours, depth, resolves. resolveReferences has one entry per colour attachment.
+            VkRenderPass getRenderPass(const std::vector<VkAttachmentDescription>& attachments, uint32_t colourCount, bool hasDepth, const std::vector<uint32_t>& resolveReferences);
+            VkFramebuffer getFramebuffer(VkRenderPass renderPass, const std::vector<VkImageView>& views, VkExtent2D extent);
+
+            void recordBarriers(VkCommandBuffer commandBuffer, const PassData& pass);
+            void recordFinalTransitions(VkCommandBuffer commandBuffer);
+            void recordPass(VkCommandBuffer commandBuffer, PassData& pass);
+            // Begins the pass's attachments with a render pass or with vkCmdBeginRendering, fills in context's inheritance info
+            void beginRendering(VkCommandBuffer commandBuffer, PassData& pass, PassContext& context);
+
+            Device& device;
+            uint32_t framesInFlight;
+            uint32_t frameIndex = 0;
+
+            std::vector<ResourceData> resources;
+            std::vector<PassData> passes;
+            // Live passes in recording order
+            std::vector<uint32_t> passOrder;
+
+            std::vector<FrameTransients> frameTransients;
+            std::map<std::vector<uint64_t>, VkRenderPass> renderPasses;
+            std::map<std::vector<uint64_t>, VkFramebuffer> framebuffers;
+
+            Stats stats;
+    };
+}
\ No newline at end of file
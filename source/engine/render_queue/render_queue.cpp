@@ -0,0 +1,123 @@
+#include "render_queue.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace Renderer{
+    RenderQueue::RenderQueue(ThreadPool& threadPool) : threadPool{threadPool} {}
+
+    uint64_t RenderQueue::makeKey(uint32_t pipelineIndex, uint32_t materialIndex, uint32_t meshIndex, float normalizedDepth){
+        constexpr uint32_t maxDepth = (1u << depthBits) - 1;
+        uint32_t depth = static_cast<uint32_t>(std::clamp(normalizedDepth, 0.f, 1.f) * maxDepth);
+
+        uint64_t key = pipelineIndex & ((1u << pipelineBits) - 1);
+        key = (key << materialBits) | (materialIndex & ((1u << materialBits) - 1));
+        key = (key << meshBits) | (meshIndex & ((1u << meshBits) - 1));
+        key = (key << depthBits) | depth;
+        return key;
+    }
+
+    void RenderQueue::clear(){
+        items.clear();
+        batches.clear();
+    }
+
+    void RenderQueue::reserve(size_t count){
+        items.reserve(count);
+        scratch.reserve(count);
+    }
+
+    void RenderQueue::sort(){
+        if(items.size() < 64)
+            std::sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b){ return a.key < b.key; });
+        else if(items.size() < parallelThreshold)
+            radixSort();
+        else
+            radixSortParallel();
+
+        buildBatches();
+    }
+
+    // LSD radix sort, 8 bits per pass. Passes where every key has the same byte (e.g. a single pipeline) are skipped.
+    void RenderQueue::radixSort(){
+        scratch.resize(items.size());
+        for(uint32_t shift = 0; shift < 64; shift += 8){
+            std::array<uint32_t, 256> histogram{};
+            for(const auto& item : items)
+                histogram[(item.key >> shift) & 0xFF]++;
+            if(histogram[(items[0].key >> shift) & 0xFF] == items.size())
+                continue;
+
+            uint32_t offset = 0;
+            for(auto& bucket : histogram){
+                uint32_t count = bucket;
+                bucket = offset;
+                offset += count;
+            }
+            for(const auto& item : items)
+                scratch[histogram[(item.key >> shift) & 0xFF]++] = item;
+            items.swap(scratch);
+        }
+    }
+
+    // Same passes as radixSort, with the histogram and scatter of each pass split into contiguous chunks.
+    // Each chunk scatters to its own precomputed offsets within every bucket, which keeps the sort stable.
+    void RenderQueue::radixSortParallel(){
+        const uint32_t count = static_cast<uint32_t>(items.size());
+        const uint32_t chunkCount = std::min(threadPool.getThreadCount() + 1, count / 4096 + 1);
+        const uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+        scratch.resize(count);
+        chunkHistograms.resize(chunkCount * 256);
+
+        for(uint32_t shift = 0; shift < 64; shift += 8){
+            threadPool.parallelFor(chunkCount, 1, [&](uint32_t beginChunk, uint32_t endChunk){
+                for(uint32_t chunk = beginChunk; chunk < endChunk; chunk++){
+                    uint32_t* histogram = &chunkHistograms[chunk * 256];
+                    std::fill(histogram, histogram + 256, 0);
+                    uint32_t end = std::min((chunk + 1) * chunkSize, count);
+                    for(uint32_t i = chunk * chunkSize; i < end; i++)
+                        histogram[(items[i].key >> shift) & 0xFF]++;
+                }
+            });
+
+            uint32_t firstBucket = (items[0].key >> shift) & 0xFF;
+            uint32_t firstBucketTotal = 0;
+            for(uint32_t chunk = 0; chunk < chunkCount; chunk++)
+                firstBucketTotal += chunkHistograms[chunk * 256 + firstBucket];
+            if(firstBucketTotal == count)
+                continue;
+
+            // Bucket-major prefix sum turns the counts into each chunk's scatter offsets
+            uint32_t offset = 0;
+            for(uint32_t bucket = 0; bucket < 256; bucket++){
+                for(uint32_t chunk = 0; chunk < chunkCount; chunk++){
+                    uint32_t& entry = chunkHistograms[chunk * 256 + bucket];
+                    uint32_t bucketCount = entry;
+                    entry = offset;
+                    offset += bucketCount;
+                }
+            }
+
+            threadPool.parallelFor(chunkCount, 1, [&](uint32_t beginChunk, uint32_t endChunk){
+                for(uint32_t chunk = beginChunk; chunk < endChunk; chunk++){
+                    uint32_t* offsets = &chunkHistograms[chunk * 256];
+                    uint32_t end = std::min((chunk + 1) * chunkSize, count);
+                    for(uint32_t i = chunk * chunkSize; i < end; i++)
+                        scratch[offsets[(items[i].key >> shift) & 0xFF]++] = items[i];
+                }
+            });
+            items.swap(scratch);
+        }
+    }
+
+    void RenderQueue::buildBatches(){
+        batches.clear();
+        for(uint32_t i = 0; i < items.size(); i++){
+            uint64_t stateKey = items[i].key >> depthBits;
+            if(batches.empty() || batches.back().stateKey != stateKey || batches.back().meshId != items[i].meshId)
+                batches.push_back({stateKey, items[i].meshId, i, 1});
+            else
+                batches.back().instanceCount++;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "engine/slot_map/slot_map.hpp"
+#include "engine/threading/thread_pool.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace Renderer{
+    class Mesh;
+
+    // Collects the frame's draws, sorts them by state so pipeline and material changes are minimised,
+    // and merges consecutive draws of the same mesh into instanced batches.
+    class RenderQueue{
+        public:
+            // Key layout from most to least significant: pipeline | material | mesh | depth.
+            // Depth is last so draws of one mesh are ordered front to back inside their batch.
+            static constexpr uint32_t depthBits = 24;
+            static constexpr uint32_t meshBits = 16;
+            static constexpr uint32_t materialBits = 16;
+            static constexpr uint32_t pipelineBits = 8;
+
+            struct DrawItem{
+                uint64_t key;
+                uint32_t objectIndex;
+                SlotHandle<Mesh> meshId;
+            };
+
+            // Consecutive sorted items that share pipeline, material and mesh, drawn as one instanced command.
+            // Instances are [firstInstance, firstInstance + instanceCount) in getItems().
+            struct Batch{
+                uint64_t stateKey;
+                SlotHandle<Mesh> meshId;
+                uint32_t firstInstance;
+                uint32_t instanceCount;
+            };
+
+            RenderQueue(ThreadPool& threadPool);
+
+            // Normalised depth is clamped to [0, 1], indices wider than their field are masked.
+            static uint64_t makeKey(uint32_t pipelineIndex, uint32_t materialIndex, uint32_t meshIndex, float normalizedDepth);
+
+            void clear();
+            void reserve(size_t count);
+            void push(uint64_t key, uint32_t objectIndex, SlotHandle<Mesh> meshId){ items.push_back({key, objectIndex, meshId}); }
+
+            // Sorts the pushed items and builds the batches
+            void sort();
+
+            const std::vector<DrawItem>& getItems() const { return items; }
+            const std::vector<Batch>& getBatches() const { return batches; }
+
+            // Item counts above this are sorted across the thread pool
+            uint32_t parallelThreshold = 16384;
+
+        private:
+            void radixSort();
+            void radixSortParallel();
+            void buildBatches();
+
+            ThreadPool& threadPool;
+
+            std::vector<DrawItem> items;
+            std::vector<DrawItem> scratch;
+            std::vector<Batch> batches;
+
+            // Per-chunk 256 bucket histograms for the parallel sort
+            std::vector<uint32_t> chunkHistograms;
+    };
+}
\ No newline at end of file
@@ -1,10 +1,20 @@
 #include "renderer.hpp"
 
+#include "engine/profiling/cpu_profiler.hpp"
+
 #include <stdexcept>
-#include <array>
 
 namespace Renderer{
-    Renderer::Renderer(Device& device, Window& window) : device{device}, window{window}{
+    Renderer::Renderer(Device& device, Window& window, const SwapChainSettings& settings) 
+    : device{device}, window{&window}, extent{window.getExtent()}, settings{settings}{
+        assert(settings.framesInFlight >= 1 && settings.framesInFlight <= SwapChain::MAX_FRAMES_IN_FLIGHT && "Frames in flight must be between 1 and SwapChain::MAX_FRAMES_IN_FLIGHT.");
+        recreateSwapChain();
+        createCommandBuffers();
+    }
+
+    Renderer::Renderer(Device& device, VkExtent2D extent, const SwapChainSettings& settings) : device{device}, extent{extent}, settings{settings}{
+        assert(device.isHeadless() && "Offscreen renderers need a headless device.");
+        assert(settings.framesInFlight >= 1 && settings.framesInFlight <= SwapChain::MAX_FRAMES_IN_FLIGHT && "Frames in flight must be between 1 and SwapChain::MAX_FRAMES_IN_FLIGHT.");
         recreateSwapChain();
         createCommandBuffers();
     }
@@ -14,17 +24,20 @@ namespace Renderer{
     }
 
     void Renderer::recreateSwapChain(){
-        auto extent = window.getExtent();
-        while(extent.width == 0 || extent.height == 0){
-            extent = window.getExtent();
-            glfwWaitEvents();
+        if(window != nullptr){
+            extent = window->getExtent();
+            while(extent.width == 0 || extent.height == 0){
+                extent = window->getExtent();
+                glfwWaitEvents();
+            }
         }
         vkDeviceWaitIdle(device.getDevice());
+        renderGraph.releaseFramebuffers();
         if(swapChain == nullptr)
-            swapChain = std::make_unique<SwapChain>(device, extent);
+            swapChain = std::make_unique<SwapChain>(device, extent, settings);
         else{
             std::shared_ptr<SwapChain> oldSwapChain = std::move(swapChain);
-            swapChain = std::make_unique<SwapChain>(device, extent, oldSwapChain);
+            swapChain = std::make_unique<SwapChain>(device, extent, settings, oldSwapChain);
 
             if (!oldSwapChain->compareSwapFormats(*swapChain.get()))
                 throw std::runtime_error("Swap chain image or depth format has changed.");
@@ -32,7 +45,7 @@ namespace Renderer{
     }
 
     void Renderer::createCommandBuffers(){
-        commandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        commandBuffers.resize(settings.framesInFlight);
         VkCommandBufferAllocateInfo bufferAllocInfo = {};
         bufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         bufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
@@ -49,7 +62,23 @@ namespace Renderer{
         commandBuffers.clear();
     }
 
+    void Renderer::setSwapChainSettings(const SwapChainSettings& newSettings){
+        assert(!isFrameStarted && "Can't change swap chain settings while a frame is in progress.");
+        assert(newSettings.framesInFlight >= 1 && newSettings.framesInFlight <= SwapChain::MAX_FRAMES_IN_FLIGHT && "Frames in flight must be between 1 and SwapChain::MAX_FRAMES_IN_FLIGHT.");
+
+        vkDeviceWaitIdle(device.getDevice());
+        settings = newSettings;
+        renderGraph.setFramesInFlight(settings.framesInFlight);
+        freeCommandBuffers();
+        recreateSwapChain();
+        createCommandBuffers();
+        // The new swap chain's sync objects start from frame 0, and its images haven't been rendered to
+        currentFrameIndex = 0;
+        lastSubmittedImageIndex = UINT32_MAX;
+    }
+
     VkCommandBuffer Renderer::beginFrame(){
+        RENDERER_PROFILE_SCOPE("Renderer::beginFrame");
         assert(!isFrameStarted && "Can't call beginFrame() while already in progress.");
         auto result = swapChain->acquireNextImage(&currentImageIndex);
         
@@ -62,6 +91,7 @@ namespace Renderer{
             throw std::runtime_error("Failed to acquire swap chain image.");
 
         isFrameStarted = true;
+        renderGraph.reset(currentFrameIndex);
         auto commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo = {};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -72,42 +102,59 @@ namespace Renderer{
     }
 
     void Renderer::endFrame(){
+        RENDERER_PROFILE_SCOPE("Renderer::endFrame");
         assert(isFrameStarted && "Can't call endFrame() when frame is not in progress.");
         auto commandBuffer = getCurrentCommandBuffer();
         if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
             throw std::runtime_error("Failed to end command buffer.");
 
         auto result = swapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
-        if(result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR || window.wasWindowResized()){
-            window.resetWindowResizedFlag();
+        lastSubmittedImageIndex = currentImageIndex;
+        if(result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR || (window != nullptr && window->wasWindowResized())){
+            if(window != nullptr)
+                window->resetWindowResizedFlag();
             recreateSwapChain();
         }
         else if(result != VK_SUCCESS)
             throw std::runtime_error("Failed to present swap chain image.");
 
         isFrameStarted = false;
-        currentFrameIndex = (currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+        currentFrameIndex = (currentFrameIndex + 1) % settings.framesInFlight;
     }
 
-    void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer){
-        assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
-        assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a different frame");
-
-        VkRenderPassBeginInfo renderPassInfo = {};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = swapChain->getRenderPass();
-        renderPassInfo.framebuffer = swapChain->getFrameBuffer(currentImageIndex);
-        renderPassInfo.renderArea.offset = { 0, 0 };
-        renderPassInfo.renderArea.extent = swapChain->getSwapChainExtent();
-        std::array<VkClearValue, 3> clearValues{};
-        clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f }; // Default "background colour" rendered
-        clearValues[1].depthStencil = { 1.0f, 0 }; // Default render depth
-        clearValues[2].color = { 0.01f, 0.01f, 0.01f, 1.0f }; // Also default "background colour" rendered
-        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-        renderPassInfo.pClearValues = clearValues.data();
-
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    void Renderer::readLastFrame(std::vector<uint8_t>& pixels){
+        assert(!isFrameStarted && "Can't read a frame back while one is being recorded.");
+        if(lastSubmittedImageIndex == UINT32_MAX)
+            throw std::runtime_error("No frame has been rendered yet.");
+        swapChain->readImage(lastSubmittedImageIndex, pixels);
+    }
+
+    Renderer::SwapChainTargets Renderer::importSwapChainTargets(){
+        assert(isFrameStarted && "Can't import the swap chain targets if frame is not in progress");
+
+        SwapChain::Attachments attachments = swapChain->getAttachments(currentImageIndex, static_cast<uint32_t>(currentFrameIndex));
+        VkExtent2D swapChainExtent = swapChain->getSwapChainExtent();
+        VkSampleCountFlagBits samples = swapChain->getSampleCount();
+
+        SwapChainTargets targets{};
+        targets.depth = renderGraph.importImage("Swap Chain Depth", {attachments.depthImage, attachments.depthImageView, 
+            {swapChain->getSwapChainDepthFormat(), swapChainExtent, samples}});
+        RenderGraph::Resource image = renderGraph.importImage("Swap Chain Image", {attachments.image, attachments.imageView, 
+            {swapChain->getSwapChainImageFormat(), swapChainExtent}, VK_IMAGE_LAYOUT_UNDEFINED, swapChain->getFinalLayout()});
+        if(samples == VK_SAMPLE_COUNT_1_BIT){
+            targets.colour = image;
+            targets.resolve = RenderGraph::nullResource;
+            return targets;
+        }
 
+        // The multisampled colour image is only needed until it is resolved, so its contents are never stored
+        targets.colour = renderGraph.importImage("Swap Chain Colour", {attachments.colourImage, attachments.colourImageView, 
+            {swapChain->getSwapChainImageFormat(), swapChainExtent, samples}});
+        targets.resolve = image;
+        return targets;
+    }
+
+    void Renderer::setViewportAndScissor(VkCommandBuffer commandBuffer) const {
         VkViewport viewport = {};
         viewport.x = 0.0f;
         viewport.y = 0.0f;
@@ -119,10 +166,4 @@ namespace Renderer{
         vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
         vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
     }
-
-    void Renderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer) {
-        assert(isFrameStarted && "Can't call endSwapChainRenderPass if frame is not in progress");
-        assert(commandBuffer == getCurrentCommandBuffer() && "Can't end render pass on command buffer from a different frame");
-        vkCmdEndRenderPass(commandBuffer);
-    }
 }
\ No newline at end of file
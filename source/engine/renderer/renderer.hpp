@@ -3,6 +3,7 @@
 #include "engine/device/device.hpp"
 #include "engine/swap_chain/swap_chain.hpp"
 #include "engine/window/window.hpp"
+#include "engine/render_graph/render_graph.hpp"
 #include "engine/systems/render_system/render_system.hpp"
 
 #include <memory>
@@ -12,12 +13,27 @@
 namespace Renderer{
     class Renderer{
         public:
-            Renderer(Device& device, Window& window);
+            Renderer(Device& device, Window& window, const SwapChainSettings& settings = {});
+            // Renders into offscreen images of a fixed extent, the device must be headless
+            Renderer(Device& device, VkExtent2D extent, const SwapChainSettings& settings = {});
             ~Renderer();
             
             int getCurrentFrameIndex() { return currentFrameIndex; }
-            VkRenderPass getSwapChainRenderPass() { return swapChain->getRenderPass(); }
             float getAspectRatio() const { return swapChain->extentAspectRatio(); }
+            uint32_t getFramesInFlight() const { return settings.framesInFlight; }
+            const SwapChainSettings& getSwapChainSettings() const { return settings; }
+            VkPresentModeKHR getPresentMode() const { return swapChain->getPresentMode(); }
+            VkExtent2D getExtent() const { return swapChain->getSwapChainExtent(); }
+            VkSampleCountFlagBits getSampleCount() const { return swapChain->getSampleCount(); }
+            // What pipelines drawing into the swap chain targets are created for
+            RenderTargetInfo getSwapChainRenderTarget() const { return {swapChain->getRenderPass(), {swapChain->getSwapChainImageFormat()}, 
+                swapChain->getSwapChainDepthFormat(), swapChain->getSampleCount()}; }
+            const SwapChain::FrameTimings& getLastFrameTimings() const { return swapChain->getLastFrameTimings(); }
+
+            // Recreates the swap chain and the per-frame command buffers, can't be called while a frame is in progress.
+            // Systems with their own per-frame resources have to be resized to the new frame count by the caller, and
+            // pipelines rebuilt for the new render pass when the MSAA tier changed.
+            void setSwapChainSettings(const SwapChainSettings& newSettings);
 
             VkCommandBuffer getCurrentCommandBuffer() const {
                 assert(isFrameStarted && "Cannot get command buffer when a frame is not in progress.");
@@ -29,11 +45,26 @@ namespace Renderer{
                 return currentFrameIndex;
             }
 
+            // Built from scratch each frame after beginFrame and executed into the frame's command buffer before endFrame
+            RenderGraph& getRenderGraph() { return renderGraph; }
+
+            // The current frame's swap chain image and the multisampled images resolved into it. Without MSAA colour is the
+            // swap chain image and resolve is nullResource.
+            struct SwapChainTargets{
+                RenderGraph::Resource colour;
+                RenderGraph::Resource depth;
+                RenderGraph::Resource resolve;
+            };
+            // Imports the current frame's targets into the render graph, the resolve target is the graph's output
+            SwapChainTargets importSwapChainTargets();
+
+            void setViewportAndScissor(VkCommandBuffer commandBuffer) const;
+
             VkCommandBuffer beginFrame();
             void endFrame();
 
-            void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
-            void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
+            // Copies out the most recently submitted frame as 8-bit RGBA rows, waiting for it to finish. Headless only.
+            void readLastFrame(std::vector<uint8_t>& pixels);
 
         private:
             void recreateSwapChain();
@@ -42,12 +73,18 @@ namespace Renderer{
 
 
             Device& device;
-            Window& window;
+            // Null when rendering offscreen
+            Window* window = nullptr;
+            VkExtent2D extent;
+            SwapChainSettings settings;
 
             std::unique_ptr<SwapChain> swapChain;
+            // After the swap chain so its framebuffers are destroyed before the swap chain's image views
+            RenderGraph renderGraph{device, settings.framesInFlight};
             std::vector<VkCommandBuffer> commandBuffers;
 
             uint32_t currentImageIndex;
+            uint32_t lastSubmittedImageIndex = UINT32_MAX;
             int currentFrameIndex{0};
             bool isFrameStarted{false};
     };
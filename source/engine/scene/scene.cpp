@@ -1,5 +1,7 @@
 #include "scene.hpp"
 
+#include "engine/profiling/cpu_profiler.hpp"
+
 #include <cassert>
 
 namespace Renderer{
@@ -13,42 +15,98 @@ namespace Renderer{
 
     }
 
-    void Scene::loadModels(Device& device){
-        std::shared_ptr<Renderer::Model> spongebob = Renderer::Model::createModelFromFile(device, "C:/Programming/C++_Projects/renderer/source/models/spongebob.obj");
-        models[spongebob->getId()] = spongebob;
+    Model::Id Scene::loadModel(Device& device, const std::string& filepath){
+        RENDERER_PROFILE_SCOPE("Scene::loadModel");
+        std::shared_ptr<Model> newModel = Model::createModelFromFile(device, filepath);
+        return models.insert(newModel);
+    }
 
-        std::shared_ptr<Renderer::Model> smoothVase = Renderer::Model::createModelFromFile(device, "C:/Programming/C++_Projects/renderer/source/models/smooth_vase.obj");
-        models[smoothVase->getId()] = smoothVase;
+    Texture::Id Scene::loadTexture(Device& device, const std::string& filepath, Sampler::Id samplerId){
+        RENDERER_PROFILE_SCOPE("Scene::loadTexture");
+        assert(samplers.contains(samplerId) && "No sampler with given ID exists.");
+        std::shared_ptr<Texture> newTexture = Texture::createTextureFromFile(device, filepath);
+        newTexture->samplerId = samplerId;
+        return textures.insert(newTexture);
     }
 
-    void Scene::loadTexturesWithSampler(Device& device, unsigned int samplerId){
-        assert(samplers.at(samplerId) != nullptr && "No sampler with given ID exists.");
-        std::shared_ptr<Renderer::Texture> spongeTexture = Renderer::Texture::createTextureFromFile(device, "C:/Programming/C++_Projects/renderer/source/textures/spongebob/spongebob.png");
-        spongeTexture->samplerId = samplerId;
-        textures[spongeTexture->getId()] = spongeTexture;
+    Object::Id Scene::createObject(){
+        return objects.emplace();
+    }
 
-        std::shared_ptr<Renderer::Texture> sampleImage = Renderer::Texture::createTextureFromFile(device, "C:/Programming/C++_Projects/renderer/source/textures/milkyway.jpg");
-        sampleImage->samplerId = samplerId;
-        textures[sampleImage->getId()] = sampleImage;
+    Mesh::Id Scene::createMesh(Model::Id modelId, Material::Id materialId){
+        assert(models.contains(modelId) && "No model with given ID exists.");
+        assert(materials.contains(materialId) && "No material with given ID exists.");
+        Mesh newMesh{};
+        newMesh.modelId = modelId;
+        newMesh.materialId = materialId;
+        return meshes.insert(newMesh);
     }
 
-    void Scene::createObject(){
-        Object newObject = Object::createObject();
-        objects.emplace(newObject.getId(), newObject);
+    Material::Id Scene::createMaterial(){
+        return materials.emplace();
     }
 
-    void Scene::createMesh(){
-        Mesh newMesh = Mesh::createMesh();
-        meshes.emplace(newMesh.getId(), newMesh);
+    Sampler::Id Scene::createSampler(Device& device, Sampler::SamplerConfig config){
+        RENDERER_PROFILE_SCOPE("Scene::createSampler");
+        std::shared_ptr<Sampler> newSampler = Sampler::createSampler(device, config);
+        return samplers.insert(newSampler);
     }
 
-    void Scene::createMaterial(){
-        Material newMaterial = Material::createMaterial();
-        materials.emplace(newMaterial.getId(), newMaterial);
+    void Scene::destroyObject(Object::Id objectId){
+        Object* object = objects.get(objectId);
+        if(object != nullptr && object->bvhProxy != BVH::nullNode)
+            objectTree.destroyProxy(object->bvhProxy);
+        objects.erase(objectId);
     }
 
-    void Scene::createSampler(Device& device, Sampler::SamplerConfig config){
-        std::shared_ptr<Sampler> newSampler = Sampler::createSampler(device, config);
-        samplers[newSampler->getId()] = newSampler;
+    void Scene::destroyMesh(Mesh::Id meshId){
+        meshes.erase(meshId);
+    }
+
+    void Scene::destroyMaterial(Material::Id materialId){
+        materials.erase(materialId);
+    }
+
+    void Scene::destroySampler(Sampler::Id samplerId){
+        samplers.erase(samplerId);
+    }
+
+    void Scene::unloadModel(Model::Id modelId){
+        models.erase(modelId);
+    }
+
+    void Scene::unloadTexture(Texture::Id textureId){
+        textures.erase(textureId);
+    }
+
+    AABB Scene::computeWorldBounds(Object& object){
+        AABB localBounds;
+        for(auto meshId : object.meshIds)
+            localBounds.expand(models.at(meshes.at(meshId).modelId)->getBounds());
+        return localBounds.transformed(object.transform.mat4());
+    }
+
+    void Scene::updateObjectBounds(Object::Id objectId){
+        Object& object = objects.at(objectId);
+        AABB worldBounds = computeWorldBounds(object);
+        if(worldBounds.isEmpty()){
+            if(object.bvhProxy != BVH::nullNode){
+                objectTree.destroyProxy(object.bvhProxy);
+                object.bvhProxy = BVH::nullNode;
+            }
+            return;
+        }
+
+        if(object.bvhProxy == BVH::nullNode)
+            object.bvhProxy = objectTree.createProxy(worldBounds, objectId.pack());
+        else
+            objectTree.moveProxy(object.bvhProxy, worldBounds);
+    }
+
+    void Scene::updateSpatialIndex(){
+        for(size_t i = 0; i < objects.size(); i++)
+            updateObjectBounds(objects.handleAt(i));
+        if(objectTree.shouldRebuild())
+            objectTree.rebuild();
     }
 }
\ No newline at end of file
@@ -3,10 +3,12 @@
 #include "engine/object/object.hpp"
 #include "engine/mesh/mesh.hpp"
 #include "engine/mesh/model.hpp"
+#include "engine/material/material.hpp"
 #include "engine/material/texture/texture.hpp"
 #include "engine/material/sampler/sampler.hpp"
+#include "engine/bvh/bvh.hpp"
 
-#include <unordered_map>
+#include <string>
 
 namespace Renderer{
     class Scene{
@@ -16,14 +18,29 @@ namespace Renderer{
             void save();
             void load();
 
-            void loadModels(Device& device);
-            void loadTexturesWithSampler(Device& device, unsigned int samplerId);
+            Model::Id loadModel(Device& device, const std::string& filepath);
+            Texture::Id loadTexture(Device& device, const std::string& filepath, Sampler::Id samplerId);
 
-            void createObject();
-            void createMesh();
-            void createMaterial();
+            Object::Id createObject();
+            Mesh::Id createMesh(Model::Id modelId, Material::Id materialId);
+            Material::Id createMaterial();
 
-            void createSampler(Device& device, Sampler::SamplerConfig config);
+            Sampler::Id createSampler(Device& device, Sampler::SamplerConfig config);
+
+            // Destroyed slots are recycled by the next create/load call, any handles still referring to them become stale.
+            void destroyObject(Object::Id objectId);
+            void destroyMesh(Mesh::Id meshId);
+            void destroyMaterial(Material::Id materialId);
+            void destroySampler(Sampler::Id samplerId);
+            void unloadModel(Model::Id modelId);
+            void unloadTexture(Texture::Id textureId);
+
+            // World-space bounds of all of an object's meshes
+            AABB computeWorldBounds(Object& object);
+            // Must be called after an object's transform or meshes change for spatial queries to see it
+            void updateObjectBounds(Object::Id objectId);
+            // Updates every object's bounds, then rebuilds the tree if refitting has degraded it enough
+            void updateSpatialIndex();
 
             // In-engine components (stuff the user will be interacting with)
             Object::Map objects;
@@ -31,10 +48,13 @@ namespace Renderer{
             Material::Map materials;
 
             // Samplers (created by user indirectly and can be shared between textures)
-            std::unordered_map<unsigned int, std::shared_ptr<Sampler>> samplers;
+            Sampler::Map samplers;
 
             // Raw assets (loaded from files the user specifies)
-            std::unordered_map<unsigned int, std::shared_ptr<Model>> models;
-            std::unordered_map<unsigned int, std::shared_ptr<Texture>> textures;
+            Model::Map models;
+            Texture::Map textures;
+
+            // Spatial index over object world bounds, leaf user data is the packed Object::Id
+            BVH objectTree;
     };
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <stdexcept>
+#include <functional>
+#include <utility>
+
+namespace Renderer{
+    // Handle into a SlotMap<T>. The generation lets the map detect handles to elements that have since been erased,
+    // even if their slot has been recycled for a new element.
+    template<typename T>
+    struct SlotHandle{
+        static constexpr uint32_t invalidIndex = UINT32_MAX;
+
+        uint32_t index = invalidIndex;
+        uint32_t generation = 0;
+
+        bool isValid() const { return index != invalidIndex; }
+
+        // Packs the handle into a single integer, useful for storing it in structures that don't know about T (e.g. GPU buffers).
+        uint64_t pack() const { return (static_cast<uint64_t>(generation) << 32) | index; }
+        static SlotHandle unpack(uint64_t packed) { return SlotHandle{static_cast<uint32_t>(packed), static_cast<uint32_t>(packed >> 32)}; }
+
+        bool operator==(const SlotHandle& other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+    };
+
+    // Generational slot map: O(1) insert, erase and lookup by handle with stale handle detection.
+    // Elements are kept densely packed so iterating over them is a linear walk over contiguous memory,
+    // and erased slots are recycled so the index space does not grow when elements are streamed in and out.
+    // Tag selects the handle type, so maps of owning pointers (e.g. std::shared_ptr<Model>) can still hand out SlotHandle<Model>.
+    template<typename T, typename Tag = T>
+    class SlotMap{
+        public:
+            using Handle = SlotHandle<Tag>;
+            using iterator = typename std::vector<T>::iterator;
+            using const_iterator = typename std::vector<T>::const_iterator;
+
+            Handle insert(const T& value){ return emplace(value); }
+            Handle insert(T&& value){ return emplace(std::move(value)); }
+
+            template<typename... Args>
+            Handle emplace(Args&&... args){
+                uint32_t slotIndex;
+                if(freeListHead != Handle::invalidIndex){
+                    slotIndex = freeListHead;
+                    freeListHead = slots[slotIndex].denseIndex; // Free slots store the next free slot in denseIndex
+                }
+                else{
+                    slotIndex = static_cast<uint32_t>(slots.size());
+                    slots.push_back({});
+                }
+
+                Slot& slot = slots[slotIndex];
+                slot.denseIndex = static_cast<uint32_t>(data.size());
+                slot.occupied = true;
+                data.emplace_back(std::forward<Args>(args)...);
+                denseToSlot.push_back(slotIndex);
+                return Handle{slotIndex, slot.generation};
+            }
+
+            // Returns false if the handle was already stale.
+            bool erase(Handle handle){
+                if(!contains(handle))
+                    return false;
+
+                Slot& slot = slots[handle.index];
+                uint32_t denseIndex = slot.denseIndex;
+                uint32_t lastDenseIndex = static_cast<uint32_t>(data.size() - 1);
+
+                // Keep the data packed by moving the last element into the hole
+                if(denseIndex != lastDenseIndex){
+                    data[denseIndex] = std::move(data[lastDenseIndex]);
+                    denseToSlot[denseIndex] = denseToSlot[lastDenseIndex];
+                    slots[denseToSlot[denseIndex]].denseIndex = denseIndex;
+                }
+                data.pop_back();
+                denseToSlot.pop_back();
+
+                // Bumping the generation invalidates every outstanding handle to this slot
+                slot.generation++;
+                slot.occupied = false;
+                slot.denseIndex = freeListHead;
+                freeListHead = handle.index;
+                return true;
+            }
+
+            bool contains(Handle handle) const {
+                return handle.index < slots.size() && slots[handle.index].occupied && slots[handle.index].generation == handle.generation;
+            }
+
+            // Returns nullptr for stale handles.
+            T* get(Handle handle){ return contains(handle) ? &data[slots[handle.index].denseIndex] : nullptr; }
+            const T* get(Handle handle) const { return contains(handle) ? &data[slots[handle.index].denseIndex] : nullptr; }
+
+            T& at(Handle handle){
+                if(!contains(handle))
+                    throw std::out_of_range("Stale or invalid slot map handle.");
+                return data[slots[handle.index].denseIndex];
+            }
+            const T& at(Handle handle) const {
+                if(!contains(handle))
+                    throw std::out_of_range("Stale or invalid slot map handle.");
+                return data[slots[handle.index].denseIndex];
+            }
+
+            T& operator[](Handle handle){
+                assert(contains(handle) && "Stale or invalid slot map handle.");
+                return data[slots[handle.index].denseIndex];
+            }
+            const T& operator[](Handle handle) const {
+                assert(contains(handle) && "Stale or invalid slot map handle.");
+                return data[slots[handle.index].denseIndex];
+            }
+
+            // Handle of the element stored at the given position in dense (iteration) order
+            Handle handleAt(size_t denseIndex) const {
+                uint32_t slotIndex = denseToSlot[denseIndex];
+                return Handle{slotIndex, slots[slotIndex].generation};
+            }
+
+            void reserve(size_t capacity){
+                slots.reserve(capacity);
+                data.reserve(capacity);
+                denseToSlot.reserve(capacity);
+            }
+
+            void clear(){
+                // Erase everything individually so outstanding handles become stale rather than aliasing new elements
+                while(!data.empty())
+                    erase(handleAt(data.size() - 1));
+            }
+
+            size_t size() const { return data.size(); }
+            bool empty() const { return data.empty(); }
+            // Number of slots ever allocated, i.e. the size of the index space
+            size_t capacity() const { return slots.size(); }
+
+            iterator begin(){ return data.begin(); }
+            iterator end(){ return data.end(); }
+            const_iterator begin() const { return data.begin(); }
+            const_iterator end() const { return data.end(); }
+
+            T* dataPtr(){ return data.data(); }
+            const T* dataPtr() const { return data.data(); }
+
+        private:
+            struct Slot{
+                uint32_t denseIndex = Handle::invalidIndex;
+                uint32_t generation = 0;
+                bool occupied = false;
+            };
+
+            std::vector<Slot> slots;
+            std::vector<T> data;
+            std::vector<uint32_t> denseToSlot;
+            uint32_t freeListHead = Handle::invalidIndex;
+    };
+}
+
+namespace std{
+    template<typename T>
+    struct hash<Renderer::SlotHandle<T>>{
+        size_t operator()(const Renderer::SlotHandle<T>& handle) const{
+            return hash<uint64_t>{}(handle.pack());
+        }
+    };
+}
\ No newline at end of file
@@ -1,18 +1,30 @@
 #include "swap_chain.hpp"
 
+#include "engine/profiling/cpu_profiler.hpp"
+#include "engine/buffer/buffer.hpp"
+
 #include <iostream>
 #include <stdexcept>
 #include <limits>
 #include <array>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+#include <chrono>
 
 namespace Renderer{
+    namespace{
+        float millisecondsSince(std::chrono::steady_clock::time_point start){
+            return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
 
-    SwapChain::SwapChain(Device& device, VkExtent2D windowExtent) : device{device}, windowExtent{windowExtent}{
+    SwapChain::SwapChain(Device& device, VkExtent2D windowExtent, const SwapChainSettings& settings) : device{device}, windowExtent{windowExtent}, settings{settings}{
         initSwapChain();
     }
 
-    SwapChain::SwapChain(Device& device, VkExtent2D extent, std::shared_ptr<SwapChain> previous)
-    : device{ device }, windowExtent{ windowExtent }, oldSwapChain{ previous } {
+    SwapChain::SwapChain(Device& device, VkExtent2D extent, const SwapChainSettings& settings, std::shared_ptr<SwapChain> previous)
+    : device{ device }, windowExtent{ extent }, settings{ settings }, oldSwapChain{ previous } {
         initSwapChain();
         oldSwapChain = nullptr;
     }
@@ -27,7 +39,12 @@ namespace Renderer{
             swapChain = nullptr;
         }
 
-        for (int i = 0; i < depthImages.size(); i++) {
+        for (size_t i = 0; i < offscreenImageMemories.size(); i++) {
+            vkDestroyImage(device.getDevice(), swapChainImages[i], nullptr);
+            vkFreeMemory(device.getDevice(), offscreenImageMemories[i], nullptr);
+        }
+
+        for (int i = 0; i < colourImages.size(); i++) {
             vkDestroyImageView(device.getDevice(), colourImageViews[i], nullptr);
             vkDestroyImage(device.getDevice(), colourImages[i], nullptr);
             vkFreeMemory(device.getDevice(), colourImageMemories[i], nullptr);
@@ -39,12 +56,10 @@ namespace Renderer{
             vkFreeMemory(device.getDevice(), depthImageMemories[i], nullptr);
         }
 
-        for(auto frameBuffer : swapChainFramebuffers)
-            vkDestroyFramebuffer(device.getDevice(), frameBuffer, nullptr);
+        if (renderPass != VK_NULL_HANDLE)
+            vkDestroyRenderPass(device.getDevice(), renderPass, nullptr);
 
-        vkDestroyRenderPass(device.getDevice(), renderPass, nullptr);
-
-        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        for (size_t i = 0; i < inFlightFences.size(); i++) {
             vkDestroySemaphore(device.getDevice(), renderFinishedSemaphores[i], nullptr);
             vkDestroySemaphore(device.getDevice(), imageAvailableSemaphores[i], nullptr);
             vkDestroyFence(device.getDevice(), inFlightFences[i], nullptr);
@@ -52,22 +67,28 @@ namespace Renderer{
     }
 
     void SwapChain::initSwapChain(){
-        createSwapChain();
+        // Sample count bits are powers of two, so the smaller bit is the lower tier
+        msaaSamples = std::min(settings.msaaSamples, device.getMaxUsableSampleCount());
+        if (device.isHeadless())
+            createOffscreenImages();
+        else
+            createSwapChain();
         createImageViews();
         createColourResources();
         createDepthResources();
-        createRenderPass();
-        createFramebuffers();
+        if (!device.supportsDynamicRendering())
+            createRenderPass();
         createSyncObjects();
     }
 
     void SwapChain::createSwapChain(){
         SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
         VkSurfaceFormatKHR surfaceFormat = chooseSurfaceFormat(swapChainSupport.formats);
-        VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes, VK_PRESENT_MODE_FIFO_KHR);
+        presentMode = chooseSwapPresentMode(swapChainSupport.presentModes, settings.presentMode);
         VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-        uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+        // Enough images that every frame in flight can hold one without waiting on presentation
+        uint32_t imageCount = std::max(swapChainSupport.capabilities.minImageCount + 1, settings.framesInFlight);
         if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount)
             imageCount = swapChainSupport.capabilities.maxImageCount;
 
@@ -107,6 +128,34 @@ namespace Renderer{
         swapChainExtent = extent;
     }
 
+    void SwapChain::createOffscreenImages(){
+        // Same format the windowed path prefers, so pipelines and output match
+        swapChainImageFormat = VK_FORMAT_B8G8R8A8_SRGB;
+        swapChainExtent = windowExtent;
+        presentMode = settings.presentMode;
+
+        // Nothing holds on to an image after its frame's fence signals, so one per frame in flight is enough
+        swapChainImages.resize(settings.framesInFlight);
+        offscreenImageMemories.resize(settings.framesInFlight);
+        for (size_t i = 0; i < swapChainImages.size(); i++) {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = swapChainExtent.width;
+            imageInfo.extent.height = swapChainExtent.height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = swapChainImageFormat;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapChainImages[i], offscreenImageMemories[i]);
+        }
+    }
+
     void SwapChain::createImageViews() {
         VkExtent2D swapChainExtent = swapChainExtent;
         swapChainImageViews.resize(swapChainImages.size());
@@ -116,12 +165,15 @@ namespace Renderer{
     }
 
     void SwapChain::createColourResources() {
+        // Without MSAA the swap chain images are the colour attachments
+        if (msaaSamples == VK_SAMPLE_COUNT_1_BIT)
+            return;
         VkFormat swapChainColourFormat = swapChainImageFormat;
         VkExtent2D swapChainExtent = getSwapChainExtent();
 
-        colourImages.resize(getImageCount());
-        colourImageMemories.resize(getImageCount());
-        colourImageViews.resize(getImageCount());
+        colourImages.resize(settings.framesInFlight);
+        colourImageMemories.resize(settings.framesInFlight);
+        colourImageViews.resize(settings.framesInFlight);
 
         for (int i = 0; i < colourImages.size(); i++) {
             VkImageCreateInfo imageInfo{};
@@ -135,11 +187,12 @@ namespace Renderer{
             imageInfo.format = swapChainColourFormat;
             imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
             imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-            imageInfo.samples = device.getMaxUsableSampleCount();
+            // Never stored, so tile based GPUs can keep it in on-chip memory without ever backing it
+            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+            imageInfo.samples = msaaSamples;
             imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
             imageInfo.flags = 0;
-            device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colourImages[i], colourImageMemories[i]);
+            device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colourImages[i], colourImageMemories[i], VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
             colourImageViews[i] = createImageView(colourImages[i], swapChainColourFormat, 1, VK_IMAGE_ASPECT_COLOR_BIT); // Does not need mipmaps as we're not using this as a texture (leave at 1)
         }
     }
@@ -148,9 +201,9 @@ namespace Renderer{
         swapChainDepthFormat = findDepthFormat();
         VkExtent2D swapChainExtent = getSwapChainExtent();
 
-        depthImages.resize(getImageCount());
-        depthImageMemories.resize(getImageCount());
-        depthImageViews.resize(getImageCount());
+        depthImages.resize(settings.framesInFlight);
+        depthImageMemories.resize(settings.framesInFlight);
+        depthImageViews.resize(settings.framesInFlight);
 
         for (int i = 0; i < depthImages.size(); i++) {
             VkImageCreateInfo imageInfo{};
@@ -164,11 +217,11 @@ namespace Renderer{
             imageInfo.format = swapChainDepthFormat;
             imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
             imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-            imageInfo.samples = device.getMaxUsableSampleCount();
+            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+            imageInfo.samples = msaaSamples;
             imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
             imageInfo.flags = 0;
-            device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImages[i], depthImageMemories[i]);
+            device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImages[i], depthImageMemories[i], VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
             depthImageViews[i] = createImageView(depthImages[i], swapChainDepthFormat, 1, VK_IMAGE_ASPECT_DEPTH_BIT); // Does not need mipmaps as we're not using this as a texture (leave at 1)
         }
     }
@@ -176,13 +229,14 @@ namespace Renderer{
     void SwapChain::createRenderPass(){
         VkAttachmentDescription colorAttachment = {};
         colorAttachment.format = getSwapChainImageFormat();
-        colorAttachment.samples = device.getMaxUsableSampleCount();
+        colorAttachment.samples = msaaSamples;
         colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
         colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
         colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        // Without MSAA there is nothing to resolve, the colour attachment is the swap chain image
+        colorAttachment.finalLayout = msaaSamples == VK_SAMPLE_COUNT_1_BIT ? getFinalLayout() : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
         VkAttachmentReference colorAttachmentRef = {};
         colorAttachmentRef.attachment = 0;
@@ -190,7 +244,7 @@ namespace Renderer{
 
         VkAttachmentDescription depthAttachment{};
         depthAttachment.format = findDepthFormat();
-        depthAttachment.samples = device.getMaxUsableSampleCount();
+        depthAttachment.samples = msaaSamples;
         depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
         depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
         depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
@@ -210,7 +264,7 @@ namespace Renderer{
         colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        colorAttachmentResolve.finalLayout = getFinalLayout();
 
         VkAttachmentReference colorAttachmentResolveRef = {};
         colorAttachmentResolveRef.attachment = 2;
@@ -221,54 +275,28 @@ namespace Renderer{
         subpass.colorAttachmentCount = 1;
         subpass.pColorAttachments = &colorAttachmentRef;
         subpass.pDepthStencilAttachment = &depthAttachmentRef;
-        subpass.pResolveAttachments = &colorAttachmentResolveRef;
-
-        VkSubpassDependency dependency = {};
-        dependency.dstSubpass = 0;
-        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-        dependency.srcAccessMask = 0;
-        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        subpass.pResolveAttachments = msaaSamples == VK_SAMPLE_COUNT_1_BIT ? nullptr : &colorAttachmentResolveRef;
 
         std::array<VkAttachmentDescription, 3> attachments = {colorAttachment, depthAttachment, colorAttachmentResolve};
         VkRenderPassCreateInfo renderPassInfo = {};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-        renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        renderPassInfo.attachmentCount = msaaSamples == VK_SAMPLE_COUNT_1_BIT ? 2 : static_cast<uint32_t>(attachments.size());
         renderPassInfo.pAttachments = attachments.data();
         renderPassInfo.subpassCount = 1;
         renderPassInfo.pSubpasses = &subpass;
-        renderPassInfo.dependencyCount = 1;
-        renderPassInfo.pDependencies = &dependency;
+        // No dependencies, like the render graph's passes: compatible render passes may only differ in layouts and load/store ops,
+        // and the graph synchronises the attachments with its own barriers
+        renderPassInfo.dependencyCount = 0;
+        renderPassInfo.pDependencies = nullptr;
 
         if (vkCreateRenderPass(device.getDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
             throw std::runtime_error("Failed to create render pass.");
     }
 
-    void SwapChain::createFramebuffers() {
-        swapChainFramebuffers.resize(getImageCount());
-        for (size_t i = 0; i < getImageCount(); i++) {
-            std::array<VkImageView, 3> attachments = { colourImageViews[i], depthImageViews[i], swapChainImageViews[i]};
-
-            VkExtent2D swapChainExtent = getSwapChainExtent();
-            VkFramebufferCreateInfo framebufferInfo = {};
-            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            framebufferInfo.renderPass = renderPass;
-            framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-            framebufferInfo.pAttachments = attachments.data();
-            framebufferInfo.width = swapChainExtent.width;
-            framebufferInfo.height = swapChainExtent.height;
-            framebufferInfo.layers = 1;
-
-            if (vkCreateFramebuffer(device.getDevice(), &framebufferInfo, nullptr, &swapChainFramebuffers[i]) != VK_SUCCESS)
-                throw std::runtime_error("Failed to create framebuffer.");
-        }
-    }
-
     void SwapChain::createSyncObjects() {
-        imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+        imageAvailableSemaphores.resize(settings.framesInFlight);
+        renderFinishedSemaphores.resize(settings.framesInFlight);
+        inFlightFences.resize(settings.framesInFlight);
         imagesInFlight.resize(getImageCount(), VK_NULL_HANDLE);
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
@@ -278,7 +306,7 @@ namespace Renderer{
         fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
         fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        for (size_t i = 0; i < settings.framesInFlight; i++)
             if (vkCreateSemaphore(device.getDevice(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
                 vkCreateSemaphore(device.getDevice(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
                 vkCreateFence(device.getDevice(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS)
@@ -286,37 +314,64 @@ namespace Renderer{
     }
 
     VkResult SwapChain::acquireNextImage(uint32_t* imageIndex) {
-        vkWaitForFences(device.getDevice(), 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+        frameTimings = {};
+        {
+            RENDERER_PROFILE_SCOPE("Wait Frame Fence");
+            auto waitStart = std::chrono::steady_clock::now();
+            vkWaitForFences(device.getDevice(), 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+            frameTimings.fenceWaitMilliseconds = millisecondsSince(waitStart);
+        }
 
+        // Offscreen images are owned per frame, there is no presentation engine to wait on
+        if (device.isHeadless()) {
+            *imageIndex = static_cast<uint32_t>(currentFrame);
+            return VK_SUCCESS;
+        }
+
+        RENDERER_PROFILE_SCOPE("Acquire Image");
+        auto acquireStart = std::chrono::steady_clock::now();
         VkResult result = vkAcquireNextImageKHR(device.getDevice(), swapChain, std::numeric_limits<uint64_t>::max(), 
         imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, imageIndex);
+        frameTimings.acquireMilliseconds = millisecondsSince(acquireStart);
 
         return result;
     }
 
     VkResult SwapChain::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) {
-        if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE)
+        if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE){
+            RENDERER_PROFILE_SCOPE("Wait Image Fence");
+            auto waitStart = std::chrono::steady_clock::now();
             vkWaitForFences(device.getDevice(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
+            frameTimings.fenceWaitMilliseconds += millisecondsSince(waitStart);
+        }
         imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
 
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
+        // Headless frames weren't acquired and won't be presented, so they neither wait on nor signal a semaphore
         VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
         VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.waitSemaphoreCount = device.isHeadless() ? 0 : 1;
         submitInfo.pWaitSemaphores = waitSemaphores;
         submitInfo.pWaitDstStageMask = waitStages;
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = buffers;
 
         VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
-        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.signalSemaphoreCount = device.isHeadless() ? 0 : 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
+        auto submitStart = std::chrono::steady_clock::now();
         vkResetFences(device.getDevice(), 1, &inFlightFences[currentFrame]);
         if (vkQueueSubmit(device.getGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
             throw std::runtime_error("Failed to submit draw command buffer.");
+        frameTimings.submitMilliseconds = millisecondsSince(submitStart);
+
+        if (device.isHeadless()) {
+            currentFrame = (currentFrame + 1) % settings.framesInFlight;
+            return VK_SUCCESS;
+        }
 
         VkPresentInfoKHR presentInfo = {};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -328,12 +383,50 @@ namespace Renderer{
         presentInfo.pSwapchains = swapChains;
         presentInfo.pImageIndices = imageIndex;
 
+        RENDERER_PROFILE_SCOPE("Present");
+        auto presentStart = std::chrono::steady_clock::now();
         auto result = vkQueuePresentKHR(device.getPresentQueue(), &presentInfo);
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        frameTimings.presentMilliseconds = millisecondsSince(presentStart);
+        currentFrame = (currentFrame + 1) % settings.framesInFlight;
 
         return result;
     }
 
+    void SwapChain::readImage(uint32_t imageIndex, std::vector<uint8_t>& pixels) {
+        assert(device.isHeadless() && "Only offscreen swap chain images can be read back.");
+        if (imagesInFlight[imageIndex] != VK_NULL_HANDLE)
+            vkWaitForFences(device.getDevice(), 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+
+        VkDeviceSize size = static_cast<VkDeviceSize>(swapChainExtent.width) * swapChainExtent.height * 4;
+        Buffer stagingBuffer{device, 1, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE, 
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+
+        VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+        // The fence wait only makes the frame's colour writes available, the copy still needs them made visible to transfer reads
+        VkMemoryBarrier memoryBarrier{};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+        VkBufferImageCopy region{};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { swapChainExtent.width, swapChainExtent.height, 1 };
+        // The render pass leaves the image in TRANSFER_SRC_OPTIMAL, an image that was never rendered to is read as garbage
+        vkCmdCopyImageToBuffer(commandBuffer, swapChainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stagingBuffer.getBuffer(), 1, &region);
+        device.endSingleTimeCommands(commandBuffer);
+
+        pixels.resize(size);
+        stagingBuffer.map();
+        std::memcpy(pixels.data(), stagingBuffer.getMappedMemory(), size);
+        stagingBuffer.unmap();
+
+        // BGRA to RGBA
+        for (size_t i = 0; i < pixels.size(); i += 4)
+            std::swap(pixels[i], pixels[i + 2]);
+    }
+
     VkImageView SwapChain::createImageView(VkImage image, VkFormat format, uint32_t mipLevels, VkImageAspectFlagBits imageAspect) {
         VkImageViewCreateInfo viewInfo{};
         viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -368,7 +461,9 @@ namespace Renderer{
                 return availablePresentMode;
             }
         }
-        throw std::runtime_error("Desired present mode not available.");
+        // FIFO is the only mode every surface has to support
+        std::cout << "Present mode " << desiredMode << " not available, using FIFO." << std::endl;
+        return VK_PRESENT_MODE_FIFO_KHR;
     }
 
     VkExtent2D SwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities){
@@ -2,22 +2,69 @@
 
 #include "engine/device/device.hpp"
 #include <memory>
+#include <vector>
 
 namespace Renderer{
+    // Latency/throughput tuning, changed at runtime through Renderer::setSwapChainSettings
+    struct SwapChainSettings{
+        // 1 to MAX_FRAMES_IN_FLIGHT, fewer frames queued means less input latency, more lets the CPU run further ahead
+        uint32_t framesInFlight = 2;
+        // Preferred mode, FIFO is used when the surface doesn't support it. Ignored by headless devices, which never present.
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+        // MSAA tier, clamped to the device's maximum. VK_SAMPLE_COUNT_1_BIT turns MSAA off and renders straight into the swap chain images.
+        VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_4_BIT;
+    };
+
+    // On a headless device the swap chain images are plain offscreen images, one per frame in flight, which are rendered
+    // through the same render pass but never presented and can be read back with readImage.
     class SwapChain{
         public:
-            SwapChain(Device& device, VkExtent2D windowExtent);
-            SwapChain(Device& device, VkExtent2D windowExtent, std::shared_ptr<SwapChain> previous);
+            SwapChain(Device& device, VkExtent2D windowExtent, const SwapChainSettings& settings = {});
+            SwapChain(Device& device, VkExtent2D windowExtent, const SwapChainSettings& settings, std::shared_ptr<SwapChain> previous);
             ~SwapChain();
 
-            static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+            // Upper bound of SwapChainSettings::framesInFlight
+            static constexpr int MAX_FRAMES_IN_FLIGHT = 4;
+
+            // CPU time spent in the last acquireNextImage and submitCommandBuffers
+            struct FrameTimings{
+                // The frame's fence before acquiring plus the image's fence before submitting
+                float fenceWaitMilliseconds = 0.f;
+                float acquireMilliseconds = 0.f;
+                float submitMilliseconds = 0.f;
+                float presentMilliseconds = 0.f;
+            };
+
+            // Images a frame renders to, imported into the render graph
+            struct Attachments{
+                // Multisampled, resolved into image. VK_NULL_HANDLE without MSAA, image is the colour attachment then.
+                VkImage colourImage;
+                VkImageView colourImageView;
+                VkImage depthImage;
+                VkImageView depthImageView;
+                VkImage image;
+                VkImageView imageView;
+            };
 
             // Getter functions
             VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
             VkExtent2D getSwapChainExtent() { return swapChainExtent; }
             size_t getImageCount() { return swapChainImages.size(); }
+            uint32_t getFramesInFlight() const { return settings.framesInFlight; }
+            VkPresentModeKHR getPresentMode() const { return presentMode; }
+            VkFormat getSwapChainDepthFormat() const { return swapChainDepthFormat; }
+            // The MSAA tier in use, pipelines drawing into the swap chain must be created with it
+            VkSampleCountFlagBits getSampleCount() const { return msaaSamples; }
+            // Layout the image is left in at the end of a frame, offscreen images are left ready to be copied out by readImage
+            VkImageLayout getFinalLayout() const { return device.isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; }
+            // Never begun, frames are rendered through the render graph, which builds a compatible render pass. Pipelines are created
+            // against it. VK_NULL_HANDLE with dynamic rendering, where pipelines only need the formats.
             VkRenderPass getRenderPass() { return renderPass; }
-            VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
+            // The multisampled images belong to the frame in flight, the resolved one to the acquired image
+            Attachments getAttachments(uint32_t imageIndex, uint32_t frameIndex) const { return {colourImages.empty() ? VK_NULL_HANDLE : colourImages[frameIndex], 
+                colourImageViews.empty() ? VK_NULL_HANDLE : colourImageViews[frameIndex], 
+                depthImages[frameIndex], depthImageViews[frameIndex], swapChainImages[imageIndex], swapChainImageViews[imageIndex]}; }
+            const FrameTimings& getLastFrameTimings() const { return frameTimings; }
             float extentAspectRatio() { return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height); }
 
             // Other functions
@@ -25,17 +72,19 @@ namespace Renderer{
                 swapChain.swapChainImageFormat == swapChainImageFormat; }
             VkResult acquireNextImage(uint32_t* imageIndex);
             VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+            // Waits for the last frame rendered to the image and copies it out as tightly packed 8-bit RGBA rows, headless only
+            void readImage(uint32_t imageIndex, std::vector<uint8_t>& pixels);
 
         private:
             // Calls all main functions
             void initSwapChain();
             // Main Functions
             void createSwapChain();
+            void createOffscreenImages();
             void createImageViews();
             void createColourResources();
             void createDepthResources();
             void createRenderPass();
-            void createFramebuffers();
             void createSyncObjects();
 
             // Helper Functions
@@ -47,13 +96,16 @@ namespace Renderer{
 
             Device& device;
             VkExtent2D windowExtent;
+            SwapChainSettings settings;
+            VkPresentModeKHR presentMode;
 
-            VkSwapchainKHR swapChain;
+            VkSwapchainKHR swapChain = VK_NULL_HANDLE;
 
             std::shared_ptr<SwapChain> oldSwapChain;
 
-            std::vector<VkFramebuffer> swapChainFramebuffers;
-
+            // The multisampled attachments are cleared and resolved within a frame and never stored, so only the frames in flight
+            // need their own rather than every swap chain image. Lazily allocated where the device supports it.
+            // Empty without MSAA
             std::vector<VkImage> colourImages;
             std::vector<VkDeviceMemory> colourImageMemories;
             std::vector<VkImageView> colourImageViews;
@@ -63,11 +115,14 @@ namespace Renderer{
             std::vector<VkImageView> depthImageViews;
 
             std::vector<VkImage> swapChainImages;
+            // Backing memory of swapChainImages when they are offscreen images
+            std::vector<VkDeviceMemory> offscreenImageMemories;
             std::vector<VkImageView> swapChainImageViews;
 
             VkFormat swapChainImageFormat;
             VkFormat swapChainDepthFormat;
             VkExtent2D swapChainExtent;
+            VkSampleCountFlagBits msaaSamples;
 
             std::vector<VkSemaphore> imageAvailableSemaphores;
             std::vector<VkSemaphore> renderFinishedSemaphores;
@@ -75,6 +130,8 @@ namespace Renderer{
             std::vector<VkFence> imagesInFlight;
             size_t currentFrame = 0;
 
-            VkRenderPass renderPass;
+            FrameTimings frameTimings;
+
+            VkRenderPass renderPass = VK_NULL_HANDLE;
     };
 }
\ No newline at end of file
@@ -4,7 +4,11 @@
 #include <cassert>
 
 namespace Renderer{
-    MaterialSystem::MaterialSystem(Device& device, VkRenderPass renderPass) : device{device}, renderPass{renderPass}{
+    // GLSL sources, compiled at runtime by the device's ShaderRegistry
+    static const std::string vertShaderFilepath = "C:/Programming/C++_Projects/renderer/source/shaders/material.vert";
+    static const std::string fragShaderFilepath = "C:/Programming/C++_Projects/renderer/source/shaders/material.frag";
+
+    MaterialSystem::MaterialSystem(Device& device, const RenderTargetInfo& renderTarget) : device{device}, renderTarget{renderTarget}{
         createPipelineLayout();
         createPipeline();
     }
@@ -14,12 +18,14 @@ namespace Renderer{
     }
 
     void MaterialSystem::createPipelineLayout(){
+        VkPushConstantRange pushConstantRange = GraphicsPipeline::reflectPushConstantRange(device, vertShaderFilepath, fragShaderFilepath);
+
         VkPipelineLayoutCreateInfo layoutInfo{};
         layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         layoutInfo.setLayoutCount = 0;
         layoutInfo.pSetLayouts = nullptr;
-        layoutInfo.pushConstantRangeCount = 0;
-        layoutInfo.pPushConstantRanges = nullptr;
+        layoutInfo.pushConstantRangeCount = pushConstantRange.size > 0 ? 1 : 0;
+        layoutInfo.pPushConstantRanges = pushConstantRange.size > 0 ? &pushConstantRange : nullptr;
 
         if(vkCreatePipelineLayout(device.getDevice(), &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
             throw std::runtime_error("Failed to create pipeline layout.");
@@ -29,18 +35,14 @@ namespace Renderer{
         assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout.");
 
         GraphicsPipelineConfigInfo configInfo{};
+        GraphicsPipeline::defaultPipelineConfigInfo(configInfo);
         configInfo.pipelineLayout = pipelineLayout;
-        configInfo.renderPass = renderPass;
-
-        pipeline = std::make_unique<GraphicsPipeline>(
-            device,
-            "C:/Programming/C++_Projects/renderer/source/shaders/material.vert",
-            "C:/Programming/C++_Projects/renderer/source/shaders/material.frag",
-            configInfo
-        );
+        configInfo.renderTarget = renderTarget;
+
+        pipeline = std::make_unique<GraphicsPipeline>(device, vertShaderFilepath, fragShaderFilepath, configInfo);
     }
 
     void MaterialSystem::addMaterial(Material newMaterial){
-        materials.emplace(1, newMaterial);
+        materials.insert(newMaterial);
     }
 }
\ No newline at end of file
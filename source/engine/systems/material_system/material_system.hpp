@@ -4,12 +4,11 @@
 #include "engine/pipeline/pipeline.hpp"
 #include "engine/material/material.hpp"
 
-#include <unordered_map>
 
 namespace Renderer{
     class MaterialSystem{
         public:
-            MaterialSystem(Device& device, VkRenderPass renderPass);
+            MaterialSystem(Device& device, const RenderTargetInfo& renderTarget);
             ~MaterialSystem();
 
             void addMaterial(Material newMaterial); // Add a material to the vector for rendering
@@ -19,7 +18,7 @@ namespace Renderer{
             void createPipeline();
 
             Device& device;
-            VkRenderPass renderPass;
+            RenderTargetInfo renderTarget;
 
             VkPipelineLayout pipelineLayout;
             std::unique_ptr<GraphicsPipeline> pipeline;
@@ -1,5 +1,7 @@
 #include "render_system.hpp"
 
+#include "engine/profiling/cpu_profiler.hpp"
+
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
@@ -8,28 +10,77 @@
 #include <stdexcept>
 #include <cassert>
 #include <algorithm>
+#include <unordered_map>
+#include <array>
+
+#ifndef RENDERER_ASSET_DIR
+    #define RENDERER_ASSET_DIR "source/"
+#endif
 
 namespace Renderer{
-    RenderSystem::RenderSystem(Device& device, VkRenderPass renderPass) 
-    : device{device}, renderPass{renderPass}{}
+    static const std::string vertShaderFilepath = "C:/Programming/C++_Projects/renderer/source/spirv_shaders/main.vert.spv";
+    static const std::string fragShaderFilepath = "C:/Programming/C++_Projects/renderer/source/spirv_shaders/main.frag.spv";
+    static const std::string cullShaderFilepath = "C:/Programming/C++_Projects/renderer/source/spirv_shaders/cull.comp.spv";
+
+    RenderSystem::RenderSystem(Device& device, const RenderTargetInfo& renderTarget, ThreadPool& threadPool, uint32_t framesInFlight) 
+    : device{device}, renderTarget{renderTarget}, framesInFlight{framesInFlight}, cpuCuller{threadPool}, renderQueue{threadPool}, recorder{device, threadPool, framesInFlight}, pipelineBuilder{device}{}
 
     RenderSystem::~RenderSystem(){
-        vkDestroyDescriptorSetLayout(device.getDevice(), globalSetLayout->getLayout(), nullptr);
+        // Pipelines still compiling use the layout destroyed below
+        pipelineBuilder.waitIdle();
         vkDestroyPipelineLayout(device.getDevice(), pipelineLayout, nullptr);
     }
 
-    void RenderSystem::initializeRenderSystem(){
-        setupScene();
-        setupDescriptorSets();
+    void RenderSystem::initializeRenderSystem(const SceneSetup& sceneSetup){
+        if(sceneSetup){
+            sceneSetup(device, scene);
+            scene.updateSpatialIndex();
+        }
+        else
+            setupScene();
+        if(cullingMode == CullingMode::GPU && !device.supportsDrawIndirectCount())
+            cullingMode = CullingMode::CPU;
+        createFrameResources();
+        setupMaterialSet();
 
         createGraphicsPipelineLayout();
         createGraphicsPipeline();
+    }
 
-        createComputePipelineLayout();
-        createComputePipeline();
+    void RenderSystem::waitForPipelines(){
+        pipelineBuilder.waitIdle();
+    }
+
+    void RenderSystem::setFramesInFlight(uint32_t count){
+        if(count == framesInFlight)
+            return;
+        vkDeviceWaitIdle(device.getDevice());
+        framesInFlight = count;
+        recorder.setFramesInFlight(count);
+        // The set layout comes from the device's cache, so the pipeline layout and pipelines stay valid
+        createFrameResources();
+    }
+
+    void RenderSystem::setRenderTarget(const RenderTargetInfo& newRenderTarget){
+        // Pipelines only depend on the formats and sample counts, so a recreated but compatible render pass can keep them
+        bool compatible = newRenderTarget.isCompatible(renderTarget);
+        renderTarget = newRenderTarget;
+        if(!compatible && renderPipeline.isValid())
+            createGraphicsPipeline();
+    }
 
+    void RenderSystem::createFrameResources(){
+        // Buffers referenced by the descriptor sets have to exist before the sets are written
         createIndirectCommands();
         setupInstanceData();
+
+        gpuCuller.reset();
+        if(cullingMode == CullingMode::GPU)
+            gpuCuller = std::make_unique<GpuCuller>(device, cullShaderFilepath, instanceBuffers);
+
+        updateObjectData();
+
+        setupDescriptorSets();
     }
 
     void RenderSystem::setupScene(){
@@ -40,82 +91,146 @@ namespace Renderer{
         textureSamplerConfig.maxAnisotropy = 16.f;
         textureSamplerConfig.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
         textureSamplerConfig.maxLod = 100.f;
-        scene.createSampler(device, textureSamplerConfig);
+        auto textureSampler = scene.createSampler(device, textureSamplerConfig);
 
         // Load assets
-        scene.loadTexturesWithSampler(device, 0);
-        scene.loadModels(device);
+        const std::string directory = assetDirectory.empty() ? RENDERER_ASSET_DIR : assetDirectory;
+        auto spongeTexture = scene.loadTexture(device, directory + "textures/spongebob/spongebob.png", textureSampler);
+        auto sampleTexture = scene.loadTexture(device, directory + "textures/milkyway.jpg", textureSampler);
+        auto spongebobModel = scene.loadModel(device, directory + "models/spongebob.obj");
+        auto smoothVaseModel = scene.loadModel(device, directory + "models/smooth_vase.obj");
 
         // spongebob material
-        scene.createMaterial();
-        scene.materials.end()->second.diffuseTextureIds.push_back(0);
+        auto spongeMaterial = scene.createMaterial();
+        scene.materials[spongeMaterial].diffuseTextureIds.push_back(spongeTexture);
 
         // spongebob mesh
-        scene.createMesh();
-        scene.meshes.end()->second.modelId = 0; // spongebob model
-        scene.meshes.end()->second.materialId = 0; // spongebob material
+        auto spongeMesh = scene.createMesh(spongebobModel, spongeMaterial);
 
         // spongebob object
-        scene.createObject();
-        scene.objects.end()->second.transform.translation = {1.5f, .5f, 0.f};
-        scene.objects.end()->second.transform.rotation = {glm::radians(180.f), 0.f, 0.f};
-        scene.objects.end()->second.meshIds.push_back(0);
+        auto spongeObject = scene.createObject();
+        scene.objects[spongeObject].transform.translation = {1.5f, .5f, 0.f};
+        scene.objects[spongeObject].transform.rotation = {glm::radians(180.f), 0.f, 0.f};
+        scene.objects[spongeObject].meshIds.push_back(spongeMesh);
 
         // sample material
-        scene.createMaterial();
-        scene.materials.end()->second.diffuseTextureIds.push_back(1);
+        auto sampleMaterial = scene.createMaterial();
+        scene.materials[sampleMaterial].diffuseTextureIds.push_back(sampleTexture);
 
         // sample mesh
-        scene.createMesh();
-        scene.meshes.end()->second.modelId = 1;
-        scene.meshes.end()->second.materialId = 1;
+        auto sampleMesh = scene.createMesh(smoothVaseModel, sampleMaterial);
 
         // sample object
-        scene.createObject();
-        scene.objects.end()->second.transform.translation = {-.5f, .5f, 0.f};
-        scene.objects.end()->second.transform.scale = {4.f, 4.f, 4.f};
+        auto sampleObject = scene.createObject();
+        scene.objects[sampleObject].transform.translation = {-.5f, .5f, 0.f};
+        scene.objects[sampleObject].transform.scale = {4.f, 4.f, 4.f};
+        scene.objects[sampleObject].meshIds.push_back(sampleMesh);
+
+        scene.updateSpatialIndex();
     }
 
     void RenderSystem::setupDescriptorSets(){
         // Universal Matrix Data
-        uniformBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        uniformBuffers.resize(framesInFlight);
         for (int i = 0; i < uniformBuffers.size(); i++) {
             uniformBuffers[i] = std::make_unique<Buffer>(device, 1, sizeof(UniformData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
             uniformBuffers[i]->map();
         } 
         
-        // Pool Setup
-        globalPool = std::make_unique<DescriptorPool>(device);
-        globalPool->addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT);        // Uniform data
-        globalPool->buildPool(SwapChain::MAX_FRAMES_IN_FLIGHT);
-        // Layout Setup
-        globalSetLayout = std::make_unique<DescriptorSetLayout>(device);
-        // Bindings are set in order of when they are added
-        globalSetLayout->addBinding(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS);    // binding 0 (Uniform data)
-        globalSetLayout->buildLayout();
-
-        for(int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++){
-            // Fill universal matrix buffer info
-            VkDescriptorBufferInfo uniformDataInfo = uniformBuffers[i]->descriptorInfo();
-
-            // Writes list
-            std::vector<VkWriteDescriptorSet> writes{
-                globalSetLayout->writeBuffer(0, &uniformDataInfo), 
-            };
-
-            globalPool->allocateSet(globalSetLayout->getLayout());
-            globalPool->updateSet(i, writes);
+        // Layout Setup, the pipeline layout is built against it so it is only created once
+        if(!globalSetLayout){
+            globalSetLayout = std::make_unique<DescriptorSetLayout>(device);
+            // Bindings are set in order of when they are added
+            globalSetLayout->addBinding(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS);    // binding 0 (Uniform data)
+            globalSetLayout->addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);      // binding 1 (Instance data)
+            globalSetLayout->buildLayout();
         }
+
+        // The global sets are transient, allocated from the frame's allocator in beginFrame. Existing allocators keep their pools.
+        size_t existingAllocators = frameDescriptorAllocators.size();
+        frameDescriptorAllocators.resize(framesInFlight);
+        for(size_t i = existingAllocators; i < framesInFlight; i++)
+            frameDescriptorAllocators[i] = std::make_unique<DescriptorAllocator>(device);
+        globalSets.assign(framesInFlight, VK_NULL_HANDLE);
+    }
+
+    void RenderSystem::allocateGlobalSet(uint32_t frameIndex){
+        // The frame's fence has signalled, so every set allocated for it last time is free to recycle at once
+        DescriptorAllocator& allocator = *frameDescriptorAllocators[frameIndex];
+        allocator.reset();
+
+        VkDescriptorBufferInfo uniformDataInfo = uniformBuffers[frameIndex]->descriptorInfo();
+        VkDescriptorBufferInfo instanceDataInfo = instanceBuffers[frameIndex]->descriptorInfo();
+        std::vector<VkWriteDescriptorSet> writes{
+            globalSetLayout->writeBuffer(0, &uniformDataInfo), 
+            globalSetLayout->writeBuffer(1, &instanceDataInfo),
+        };
+
+        globalSets[frameIndex] = allocator.allocate(globalSetLayout->getLayout());
+        allocator.updateSet(globalSets[frameIndex], writes);
+    }
+
+    void RenderSystem::setupMaterialSet(){
+        // Texture slot i is array element i + 1, element 0 and erased slots get the fallback
+        textureDescriptorCount = static_cast<uint32_t>(scene.textures.capacity()) + 1;
+        if(!fallbackTexture){
+            const uint8_t white[4] = {255, 255, 255, 255};
+            fallbackTexture = Texture::createTextureFromPixels(device, 1, 1, white);
+            fallbackSampler = Sampler::createSampler(device, Sampler::SamplerConfig{});
+        }
+        VkDescriptorImageInfo fallbackInfo = fallbackTexture->descriptorImageInfo();
+        fallbackInfo.sampler = fallbackSampler->getSampler();
+        std::vector<VkDescriptorImageInfo> textureInfos(textureDescriptorCount, fallbackInfo);
+        for(size_t i = 0; i < scene.textures.size(); i++){
+            const std::shared_ptr<Texture>& texture = scene.textures.dataPtr()[i];
+            VkDescriptorImageInfo& info = textureInfos[scene.textures.handleAt(i).index + 1];
+            info = texture->descriptorImageInfo();
+            info.sampler = scene.samplers.at(texture->samplerId)->getSampler();
+        }
+
+        // Indexed by material slot, so the material index in a mesh's handle can be pushed as is
+        std::vector<MaterialData> materialData(std::max<size_t>(scene.materials.capacity(), 1), MaterialData{0});
+        for(size_t i = 0; i < scene.materials.size(); i++){
+            const Material& material = scene.materials.dataPtr()[i];
+            if(!material.diffuseTextureIds.empty() && scene.textures.contains(material.diffuseTextureIds.front()))
+                materialData[scene.materials.handleAt(i).index].diffuseTexture = material.diffuseTextureIds.front().index + 1;
+        }
+        materialBuffer = std::make_unique<Buffer>(device, 1, materialData.size() * sizeof(MaterialData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
+            VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        materialBuffer->map();
+        materialBuffer->writeToBuffer(materialData.data(), materialData.size() * sizeof(MaterialData));
+
+        // Sized for exactly this one set, the texture array would overflow a pool sized by the default ratios
+        materialDescriptorAllocator = std::make_unique<DescriptorAllocator>(device, std::vector<DescriptorAllocator::PoolSizeRatio>{
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.f},
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, static_cast<float>(textureDescriptorCount)}
+        }, 1);
+        materialSetLayout = std::make_unique<DescriptorSetLayout>(device);
+        materialSetLayout->addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT);                               // binding 0 (Material data)
+        materialSetLayout->addBinding(textureDescriptorCount, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);   // binding 1 (Textures)
+        materialSetLayout->buildLayout();
+
+        VkDescriptorBufferInfo materialDataInfo = materialBuffer->descriptorInfo();
+        std::vector<VkWriteDescriptorSet> writes{
+            materialSetLayout->writeBuffer(0, &materialDataInfo),
+            materialSetLayout->writeImage(1, textureInfos.data()),
+        };
+        materialSet = materialDescriptorAllocator->allocate(materialSetLayout->getLayout());
+        materialDescriptorAllocator->updateSet(materialSet, writes);
     }
 
     void RenderSystem::createGraphicsPipelineLayout(){
-        auto layout = globalSetLayout->getLayout();
+        std::array<VkDescriptorSetLayout, 2> layouts{globalSetLayout->getLayout(), materialSetLayout->getLayout()};
+        // Sized from the shaders themselves so the layout can't drift from the DrawPush block
+        VkPushConstantRange pushConstantRange = GraphicsPipeline::reflectPushConstantRange(device, vertShaderFilepath, fragShaderFilepath);
+        assert(pushConstantRange.size >= sizeof(DrawPushData) && "main.frag's push constant block doesn't match DrawPushData.");
+
         VkPipelineLayoutCreateInfo layoutInfo = {};
         layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        layoutInfo.setLayoutCount = 1;
-        layoutInfo.pSetLayouts = &layout;
-        layoutInfo.pushConstantRangeCount = 0;
-        layoutInfo.pPushConstantRanges = nullptr;
+        layoutInfo.setLayoutCount = static_cast<uint32_t>(layouts.size());
+        layoutInfo.pSetLayouts = layouts.data();
+        layoutInfo.pushConstantRangeCount = pushConstantRange.size > 0 ? 1 : 0;
+        layoutInfo.pPushConstantRanges = pushConstantRange.size > 0 ? &pushConstantRange : nullptr;
 
         if(vkCreatePipelineLayout(device.getDevice(), &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
             throw std::runtime_error("Failed to create graphics pipeline layout.");
@@ -124,131 +239,340 @@ namespace Renderer{
     void RenderSystem::createGraphicsPipeline(){
         assert(pipelineLayout != nullptr && "Cannot create graphics pipeline before graphics pipeline layout.");
 
-        GraphicsPipelineConfigInfo configInfo = {};
-        GraphicsPipeline::defaultPipelineConfigInfo(configInfo);
-        configInfo.pipelineLayout = pipelineLayout;
-        configInfo.renderPass = renderPass;
-        renderPipeline = std::make_unique<GraphicsPipeline>(
-            device,
-            "C:/Programming/C++_Projects/renderer/source/spirv_shaders/main.vert.spv",
-            "C:/Programming/C++_Projects/renderer/source/spirv_shaders/main.frag.spv",
-            configInfo
-        );
+        VkPipelineLayout layout = pipelineLayout;
+        RenderTargetInfo target = renderTarget;
+        uint32_t textureCount = textureDescriptorCount;
+        renderPipeline = pipelineBuilder.buildGraphics({
+            vertShaderFilepath,
+            fragShaderFilepath,
+            [layout, target, textureCount](GraphicsPipelineConfigInfo& configInfo){
+                configInfo.pipelineLayout = layout;
+                configInfo.renderTarget = target;
+                configInfo.specialization.set(TextureCountId, textureCount);
+            }
+        });
     }
 
-    void RenderSystem::createComputePipelineLayout(){
-        VkPipelineLayoutCreateInfo layoutInfo = {};
-        layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        layoutInfo.setLayoutCount = 0;
-        layoutInfo.pSetLayouts = nullptr;
-        layoutInfo.pushConstantRangeCount = 0;
-        layoutInfo.pPushConstantRanges = nullptr;
+    void RenderSystem::createIndirectCommands(){
+        objectCount = static_cast<uint32_t>(scene.objects.size());
 
-        if(vkCreatePipelineLayout(device.getDevice(), &layoutInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS)
-            throw std::runtime_error("Failed to create compute pipeline layout.");
+        // Worst case is every mesh of every object being visible
+        // TODO: sort through models that don't have indices and create commands for them and draw them seperately.
+        maxIndirectCommands = 0;
+        for(auto& obj : scene.objects)
+            maxIndirectCommands += static_cast<uint32_t>(obj.meshIds.size());
+        indirectCommands.reserve(maxIndirectCommands);
+        renderQueue.reserve(maxIndirectCommands);
+        instanceData.reserve(maxIndirectCommands);
+
+        indirectCommandsBuffers.resize(framesInFlight);
+        frameModelRuns.resize(framesInFlight);
+        for(uint32_t i = 0; i < framesInFlight; i++){
+            indirectCommandsBuffers[i] = std::make_unique<Buffer>(
+                device,
+                1,
+                std::max(maxIndirectCommands, 1u) * sizeof(VkDrawIndexedIndirectCommand),
+                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                VK_SHARING_MODE_EXCLUSIVE,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+            indirectCommandsBuffers[i]->map();
+        }
     }
 
-    void RenderSystem::createComputePipeline(){
-        assert(cullPipelineLayout != nullptr && "Cannot create compute pipeline before compute pipeline layout.");
+    void RenderSystem::updateObjectData(){
+        // Culler and instance data indices both follow the dense order of scene.objects
+        uint32_t count = static_cast<uint32_t>(scene.objects.size());
+        cpuCuller.resize(count);
+        objectInstanceData.resize(count);
+        std::vector<AABB> objectBounds(count);
+        for(uint32_t i = 0; i < count; i++){
+            Object& object = scene.objects.dataPtr()[i];
+            objectBounds[i] = scene.computeWorldBounds(object);
+            cpuCuller.setBounds(i, objectBounds[i]);
+
+            objectInstanceData[i].modelMatrix = object.transform.mat4();
+            objectInstanceData[i].normalMatrix = glm::mat4(object.transform.normalMatrix());
+        }
 
-        cullPipeline = std::make_unique<ComputePipeline>(
-            device,
-            "C:/Programming/C++_Projects/renderer/source/shaders/cull.comp",
-            cullPipelineLayout
-        );
+        if(gpuCuller)
+            updateGpuDraws(objectBounds);
     }
 
-    void RenderSystem::createIndirectCommands(){
-        instanceCount = static_cast<uint32_t>(scene.objects.size());
+    void RenderSystem::updateGpuDraws(const std::vector<AABB>& objectBounds){
+        // One slot per mesh, sorted by model and material so each pair's commands are a contiguous run the draw count can cover
+        std::vector<Mesh::Id> slotMeshes;
+        std::unordered_map<Mesh::Id, uint32_t> meshSlots;
+        for(const auto& obj : scene.objects)
+            for(auto meshId : obj.meshIds)
+                if(meshSlots.emplace(meshId, 0).second)
+                    slotMeshes.push_back(meshId);
+        std::sort(slotMeshes.begin(), slotMeshes.end(), [this](Mesh::Id a, Mesh::Id b){
+            const Mesh& meshA = scene.meshes.at(a);
+            const Mesh& meshB = scene.meshes.at(b);
+            if(meshA.modelId.index != meshB.modelId.index)
+                return meshA.modelId.index < meshB.modelId.index;
+            return meshA.materialId.index != meshB.materialId.index ? meshA.materialId.index < meshB.materialId.index : a.index < b.index;
+        });
+
+        std::vector<GpuCuller::DrawSlot> slots(slotMeshes.size());
+        gpuModelRuns.clear();
+        for(uint32_t i = 0; i < slotMeshes.size(); i++){
+            meshSlots[slotMeshes[i]] = i;
+            Model::Id modelId = scene.meshes.at(slotMeshes[i]).modelId;
+            uint32_t materialIndex = scene.meshes.at(slotMeshes[i]).materialId.index;
+            if(gpuModelRuns.empty() || gpuModelRuns.back().modelId != modelId || gpuModelRuns.back().materialIndex != materialIndex)
+                gpuModelRuns.push_back({modelId, materialIndex, i, 0});
+            gpuModelRuns.back().commandCount++;
+
+            slots[i].indexCount = scene.models.at(modelId)->getIndexCount();
+            slots[i].instanceBase = 0;
+            slots[i].run = static_cast<uint32_t>(gpuModelRuns.size() - 1);
+            slots[i].runCommandBase = gpuModelRuns.back().firstCommand;
+        }
 
-        // Where I left off, need to finish instanced rendering and indirect drawing + gpu-based culling
-        // TODO: sort through models that don't have indices and create commands for them and draw them seperately.
-        for(auto obj : scene.objects){
-            for(int i = 0; i < obj.second.meshIds.size(); i++){
-                VkDrawIndexedIndirectCommand newIndexedIndirectCommand;
-                newIndexedIndirectCommand.firstIndex = 0;
-                newIndexedIndirectCommand.instanceCount = instanceCount;
-                newIndexedIndirectCommand.firstInstance = i * instanceCount;
-                newIndexedIndirectCommand.indexCount = scene.models.at(scene.meshes.at(i).modelId)->getIndexCount();
-                indirectCommands.push_back(newIndexedIndirectCommand);
+        std::vector<GpuCuller::CullItem> items;
+        items.reserve(maxIndirectCommands);
+        for(uint32_t objectIndex = 0; objectIndex < scene.objects.size(); objectIndex++){
+            const AABB& bounds = objectBounds[objectIndex];
+            glm::vec3 extent = bounds.getExtent();
+            for(auto meshId : scene.objects.dataPtr()[objectIndex].meshIds){
+                const Mesh& mesh = scene.meshes.at(meshId);
+                GpuCuller::CullItem item{};
+                item.sphere = glm::vec4(bounds.getCenter(), glm::length(extent));
+                item.extent = glm::vec4(extent, 0.f);
+                item.objectIndex = objectIndex;
+                item.slot = meshSlots[meshId];
+                item.materialId = mesh.materialId.index;
+                item.modelId = mesh.modelId.index;
+                items.push_back(item);
+                slots[item.slot].instanceBase++;
             }
         }
 
-        objectCount = 0;
-        for(auto indCmd : indirectCommands)
-            objectCount += indCmd.indexCount;
-
-        Buffer stagingBuffer{
-            device,
-            1,
-            indirectCommands.size() * sizeof(VkDrawIndexedIndirectCommand),
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_SHARING_MODE_EXCLUSIVE,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        };
+        gpuDrawStats = {};
+        gpuDrawStats.objectCount = static_cast<uint32_t>(scene.objects.size());
+        gpuDrawStats.visibleObjectCount = gpuDrawStats.objectCount;
+        gpuDrawStats.drawCommandCount = static_cast<uint32_t>(slots.size());
+        gpuDrawStats.modelRunCount = static_cast<uint32_t>(gpuModelRuns.size());
+        for(const auto& item : items)
+            gpuDrawStats.triangleCount += slots[item.slot].indexCount / 3;
+        gpuDrawStats.exact = false;
+
+        // Turn per-slot item counts into the start of each slot's instance range
+        uint32_t instanceBase = 0;
+        for(auto& slot : slots){
+            uint32_t slotItems = slot.instanceBase;
+            slot.instanceBase = instanceBase;
+            instanceBase += slotItems;
+        }
 
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer(indirectCommands.data());
+        gpuCuller->setDraws(items, slots, static_cast<uint32_t>(gpuModelRuns.size()), objectInstanceData.data(), static_cast<uint32_t>(objectInstanceData.size()), sizeof(InstanceData));
+    }
 
-        indirectCommandsBuffer = std::make_unique<Buffer>(
-            device,
-            1,
-            stagingBuffer.getSize(),
-            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_SHARING_MODE_EXCLUSIVE,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        );
+    void RenderSystem::cullScene(VkCommandBuffer commandBuffer, const Camera& camera, uint32_t frameIndex){
+        RENDERER_PROFILE_SCOPE("RenderSystem::cullScene");
+        if(cullingMode == CullingMode::GPU && gpuCuller){
+            gpuCuller->record(commandBuffer, frameIndex, camera.getFrustum(), camera.enableFrustumCulling);
+            drawStats = gpuDrawStats;
+            return;
+        }
 
-        stagingBuffer.copyBuffer(indirectCommandsBuffer->getBuffer(), indirectCommandsBuffer->getSize());
-    }
+        // Also the fallback when GPU culling was requested but isn't available
+        if(cullingMode != CullingMode::None && camera.enableFrustumCulling)
+            cpuCuller.cull(camera.getFrustum(), visibleObjects);
+        else{
+            visibleObjects.resize(scene.objects.size());
+            for(uint32_t i = 0; i < visibleObjects.size(); i++)
+                visibleObjects[i] = i;
+        }
 
-    void RenderSystem::setupInstanceData(){
-        instanceData.resize(objectCount);
-
-        // Info set once as for all objects as the default, this info can be updated in the updateScene() function.
-        /*for(uint32_t i = 0; i < objectCount; i++){
-            auto object = scene.objects.at(i);
-            instanceData[i].modelMatrix = object.transform.mat4();
-            instanceData[i].normalMatrix = object.transform.normalMatrix();
-            instanceData[i].translation = object.transform.translation;
-            instanceData[i].scale = object.transform.scale;
-            instanceData[i].rotation = object.transform.rotation;
-            instanceData[i].modelId = object.modelId;
-            instanceData[i].materialId = object.materialId;
-        }*/
-        // Two instance data buffers needed with duplicate data since we're double buffering
-        for(int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++){
-            Buffer stagingBuffer{
-                device,
-                1,
-                instanceData.size() * sizeof(InstanceData),
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                VK_SHARING_MODE_EXCLUSIVE,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-            };
+        // Sort the visible draws by state and let the queue merge draws of the same mesh into instanced batches
+        glm::vec3 cameraPosition = camera.getPosition();
+        renderQueue.clear();
+        for(uint32_t objectIndex : visibleObjects){
+            const Object& obj = scene.objects.dataPtr()[objectIndex];
+            float distance = glm::length(cpuCuller.getCenter(objectIndex) - cameraPosition);
+            for(auto meshId : obj.meshIds){
+                // Only one graphics pipeline exists so far, so the pipeline field is always 0
+                uint64_t key = RenderQueue::makeKey(0, scene.meshes.at(meshId).materialId.index, meshId.index, distance / (distance + 1.f));
+                renderQueue.push(key, objectIndex, meshId);
+            }
+        }
+        renderQueue.sort();
+
+        // Lay the instance data out in sorted order so every batch's instances are one contiguous range starting at firstInstance
+        instanceData.clear();
+        for(const auto& item : renderQueue.getItems()){
+            instanceData.push_back(objectInstanceData[item.objectIndex]);
+            const Mesh& mesh = scene.meshes.at(item.meshId);
+            instanceData.back().materialId = mesh.materialId.index;
+            instanceData.back().modelId = mesh.modelId.index;
+        }
 
-            stagingBuffer.map();
-            stagingBuffer.writeToBuffer(instanceData.data());
+        indirectCommands.clear();
+        auto& modelRuns = frameModelRuns[frameIndex];
+        modelRuns.clear();
+        for(const auto& batch : renderQueue.getBatches()){
+            Model::Id modelId = scene.meshes.at(batch.meshId).modelId;
+            uint32_t materialIndex = scene.meshes.at(batch.meshId).materialId.index;
+
+            VkDrawIndexedIndirectCommand newIndexedIndirectCommand{};
+            newIndexedIndirectCommand.indexCount = scene.models.at(modelId)->getIndexCount();
+            newIndexedIndirectCommand.instanceCount = batch.instanceCount;
+            newIndexedIndirectCommand.firstIndex = 0;
+            newIndexedIndirectCommand.vertexOffset = 0;
+            newIndexedIndirectCommand.firstInstance = batch.firstInstance;
+
+            // The material is pushed per multi-draw, so a material change also starts a new run
+            if(modelRuns.empty() || modelRuns.back().modelId != modelId || modelRuns.back().materialIndex != materialIndex)
+                modelRuns.push_back({modelId, materialIndex, static_cast<uint32_t>(indirectCommands.size()), 0});
+            modelRuns.back().commandCount++;
+            indirectCommands.push_back(newIndexedIndirectCommand);
+        }
 
+        drawStats = {};
+        drawStats.objectCount = static_cast<uint32_t>(scene.objects.size());
+        drawStats.visibleObjectCount = static_cast<uint32_t>(visibleObjects.size());
+        drawStats.drawCommandCount = static_cast<uint32_t>(indirectCommands.size());
+        drawStats.modelRunCount = static_cast<uint32_t>(modelRuns.size());
+        for(const auto& command : indirectCommands)
+            drawStats.triangleCount += static_cast<uint64_t>(command.indexCount / 3) * command.instanceCount;
+
+        assert(indirectCommands.size() <= maxIndirectCommands && "Scene changed without recreating indirect command buffers.");
+        if(!indirectCommands.empty()){
+            indirectCommandsBuffers[frameIndex]->writeToBuffer(indirectCommands.data(), indirectCommands.size() * sizeof(VkDrawIndexedIndirectCommand));
+            instanceBuffers[frameIndex]->writeToBuffer(instanceData.data(), instanceData.size() * sizeof(InstanceData));
+        }
+    }
+
+    void RenderSystem::setupInstanceData(){
+        // Written every frame from the sorted visible draws, so these stay host visible and mapped
+        instanceBuffers.resize(framesInFlight);
+        for(uint32_t i = 0; i < framesInFlight; i++){
             instanceBuffers[i] = std::make_unique<Buffer>(
                 device,
                 1,
-                stagingBuffer.getSize(),
-                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                std::max(maxIndirectCommands, 1u) * sizeof(InstanceData),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
                 VK_SHARING_MODE_EXCLUSIVE,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
             );
-
-            stagingBuffer.copyBuffer(instanceBuffers[i]->getBuffer(), instanceBuffers[i]->getSize());
+            instanceBuffers[i]->map();
         }
     }
 
+    void RenderSystem::beginFrame(uint32_t frameIndex){
+        recorder.beginFrame(frameIndex);
+        allocateGlobalSet(frameIndex);
+    }
+
+    uint32_t RenderSystem::getDrawRunCount(uint32_t frameIndex) const {
+        if(cullingMode == CullingMode::GPU && gpuCuller)
+            return static_cast<uint32_t>(gpuModelRuns.size());
+        return static_cast<uint32_t>(frameModelRuns[frameIndex].size());
+    }
+
     void RenderSystem::drawScene(VkCommandBuffer commandBuffer, uint32_t frameIndex){
-        renderPipeline->bind(commandBuffer);
-        vkCmdDrawIndexedIndirect(commandBuffer, indirectCommandsBuffer->getBuffer(), 0, static_cast<uint32_t>(indirectCommands.size()), sizeof(VkDrawIndexedIndirectCommand));
+        RENDERER_PROFILE_SCOPE("RenderSystem::drawScene");
+        if(GraphicsPipeline* pipeline = renderPipeline.tryGet())
+            drawRuns(commandBuffer, *pipeline, frameIndex, 0, getDrawRunCount(frameIndex));
+    }
+
+    void RenderSystem::drawSceneParallel(VkCommandBuffer primaryCommandBuffer, uint32_t frameIndex, const VkCommandBufferInheritanceInfo& inheritanceInfo, const std::function<void(VkCommandBuffer)>& setDynamicState){
+        RENDERER_PROFILE_SCOPE("RenderSystem::drawSceneParallel");
+        // Split the model runs into contiguous ranges, one secondary command buffer each, executed in order so the draw order is unchanged
+        // Resolved here rather than in the jobs, PendingPipeline isn't thread safe. An empty secondary is still recorded
+        // while the pipeline compiles, since the render pass was begun expecting secondaries.
+        GraphicsPipeline* pipeline = renderPipeline.tryGet();
+        uint32_t runCount = pipeline ? getDrawRunCount(frameIndex) : 0;
+        uint32_t jobCount = std::clamp((runCount + minRunsPerRecordingJob - 1) / minRunsPerRecordingJob, 1u, recorder.getMaxJobCount());
+        uint32_t runsPerJob = (runCount + jobCount - 1) / jobCount;
+
+        recorder.recordRenderPass(primaryCommandBuffer, inheritanceInfo, jobCount, [&](VkCommandBuffer commandBuffer, uint32_t job){
+            setDynamicState(commandBuffer);
+            if(pipeline == nullptr)
+                return;
+            uint32_t beginRun = std::min(job * runsPerJob, runCount);
+            drawRuns(commandBuffer, *pipeline, frameIndex, beginRun, std::min(beginRun + runsPerJob, runCount));
+        });
+    }
+
+    void RenderSystem::addPasses(RenderGraph& graph, const Camera& camera, uint32_t frameIndex, RenderGraph::Resource colour, RenderGraph::Resource depth, 
+        RenderGraph::Resource resolve, const std::function<void(VkCommandBuffer)>& setDynamicState){
+        // CPU culling writes the buffers through their mappings before the frame is submitted, GPU culling in the compute pass
+        bool gpuCulling = cullingMode == CullingMode::GPU && gpuCuller;
+        RenderGraph::Access cullAccess = gpuCulling ? RenderGraph::Access::ComputeShaderWrite : RenderGraph::Access::HostWrite;
+        RenderGraph::Resource instances = graph.importBuffer("Instances", instanceBuffers[frameIndex]->getBuffer());
+        RenderGraph::Resource commands = graph.importBuffer("Draw Commands", gpuCulling ? gpuCuller->getCommandBuffer(frameIndex) 
+            : indirectCommandsBuffers[frameIndex]->getBuffer());
+        RenderGraph::Resource counts = gpuCulling ? graph.importBuffer("Draw Counts", gpuCuller->getRunCountBuffer(frameIndex)) : RenderGraph::nullResource;
+
+        graph.addPass("Cull", [&](RenderGraph::PassBuilder& builder){
+            builder.write(instances, cullAccess);
+            builder.write(commands, cullAccess);
+            if(counts != RenderGraph::nullResource)
+                builder.write(counts, cullAccess);
+        }, [this, camera, frameIndex](const RenderGraph::PassContext& context){
+            cullScene(context.commandBuffer, camera, frameIndex);
+        });
+
+        graph.addPass("Draw", [&](RenderGraph::PassBuilder& builder){
+            builder.read(instances, RenderGraph::Access::VertexShaderRead);
+            builder.read(commands, RenderGraph::Access::IndirectBuffer);
+            if(counts != RenderGraph::nullResource)
+                builder.read(counts, RenderGraph::Access::IndirectBuffer);
+            builder.colourAttachment(colour, VkClearColorValue{{0.01f, 0.01f, 0.01f, 1.0f}}); // Default "background colour" rendered
+            builder.depthAttachment(depth, VkClearDepthStencilValue{1.0f, 0});
+            if(resolve != RenderGraph::nullResource)
+                builder.resolveAttachment(resolve);
+            builder.useSecondaryCommandBuffers();
+        }, [this, frameIndex, setDynamicState](const RenderGraph::PassContext& context){
+            drawSceneParallel(context.commandBuffer, frameIndex, context.inheritanceInfo, setDynamicState);
+        });
+    }
+
+    void RenderSystem::drawRuns(VkCommandBuffer commandBuffer, GraphicsPipeline& pipeline, uint32_t frameIndex, uint32_t beginRun, uint32_t endRun){
+        // Bound per command buffer, secondaries don't inherit bindings
+        pipeline.bind(commandBuffer);
+        std::array<VkDescriptorSet, 2> sets{globalSets[frameIndex], materialSet};
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
+
+        if(cullingMode == CullingMode::GPU && gpuCuller){
+            // Only the upper bound of each run is known here, the actual count was written by the culling pass
+            for(uint32_t run = beginRun; run < endRun; run++){
+                scene.models.at(gpuModelRuns[run].modelId)->bind(commandBuffer);
+                pipeline.push(commandBuffer, DrawPushData{gpuModelRuns[run].materialIndex});
+                vkCmdDrawIndexedIndirectCount(
+                    commandBuffer,
+                    gpuCuller->getCommandBuffer(frameIndex),
+                    gpuModelRuns[run].firstCommand * sizeof(VkDrawIndexedIndirectCommand),
+                    gpuCuller->getRunCountBuffer(frameIndex),
+                    run * sizeof(uint32_t),
+                    gpuModelRuns[run].commandCount,
+                    sizeof(VkDrawIndexedIndirectCommand)
+                );
+            }
+            return;
+        }
+
+        // One multi-draw per run of batches sharing a model and material, instances of a batch are found through gl_InstanceIndex
+        const auto& modelRuns = frameModelRuns[frameIndex];
+        for(uint32_t run = beginRun; run < endRun; run++){
+            scene.models.at(modelRuns[run].modelId)->bind(commandBuffer);
+            pipeline.push(commandBuffer, DrawPushData{modelRuns[run].materialIndex});
+            vkCmdDrawIndexedIndirect(
+                commandBuffer,
+                indirectCommandsBuffers[frameIndex]->getBuffer(),
+                modelRuns[run].firstCommand * sizeof(VkDrawIndexedIndirectCommand),
+                modelRuns[run].commandCount,
+                sizeof(VkDrawIndexedIndirectCommand)
+            );
+        }
     }
 
     void RenderSystem::updateUniformBuffer(Camera camera, uint32_t frameIndex){
+        RENDERER_PROFILE_SCOPE("RenderSystem::updateUniformBuffer");
         // TODO: add check to see if camera view changed so needless updates are not performed
         uniformData.projection = camera.getProjection();
         uniformData.view = camera.getView();
@@ -257,18 +581,6 @@ namespace Renderer{
 
         uniformBuffers[frameIndex]->writeToBuffer(&uniformData);
         uniformBuffers[frameIndex]->flush();
-
-        // TODO: move per-instance updates to the GPU as this method here is very slow when there is a large number of objects
-        // Update per-instance data
-        /*for(int i = 0; i < objectCount; i++){
-            auto object = scene.objects.at(i);
-
-            instanceData[i].modelMatrix = object.transform.mat4();
-            instanceData[i].normalMatrix = object.transform.normalMatrix();
-            
-            instanceBuffers[frameIndex]->writeToBuffer(&instanceData[i]);
-            instanceBuffers[frameIndex]->flush();
-        }*/
     }
 
     size_t RenderSystem::padUniformBufferSize(size_t originalSize){
@@ -7,22 +7,47 @@
 #include "engine/buffer/buffer.hpp"
 #include "engine/camera/camera.hpp"
 #include "engine/scene/scene.hpp"
+#include "engine/culling/cpu_culler.hpp"
+#include "engine/culling/gpu_culler.hpp"
+#include "engine/render_queue/render_queue.hpp"
+#include "engine/threading/thread_pool.hpp"
+#include "engine/parallel_recorder/parallel_recorder.hpp"
+#include "engine/pipeline/pipeline_builder/pipeline_builder.hpp"
+#include "engine/render_graph/render_graph.hpp"
 
 #include <memory>
+#include <string>
+#include <functional>
 
 namespace Renderer{
     class RenderSystem{
         public:
+            // Matches the std430 InstanceData struct in main.vert, keep the size a multiple of 16 bytes
             struct InstanceData{
                 glm::mat4 modelMatrix{1.f};
                 glm::mat4 normalMatrix{1.f};
 
-                glm::vec3 translation;
-                glm::vec3 scale;
-                glm::vec3 rotation;
+                uint32_t materialId;
+                uint32_t modelId;
+                uint32_t padding[2];
+            };
+
+            // Matches the DrawPush push constant block in main.frag, pushed once per multi-draw instead of rebinding descriptors
+            struct DrawPushData{
+                uint32_t materialIndex;
+            };
+
+            // Matches the std430 MaterialData struct in main.frag, one per material slot
+            struct MaterialData{
+                uint32_t diffuseTexture;    // Index into the texture array, 0 is the white fallback
+            };
 
-                unsigned int materialId;
-                unsigned int modelId;
+            // Consecutive indirect commands that draw from the same model's vertex and index buffers with the same material
+            struct ModelRun{
+                Model::Id modelId;
+                uint32_t materialIndex;
+                uint32_t firstCommand;
+                uint32_t commandCount;
             };
 
             struct UniformData{
@@ -37,55 +62,147 @@ namespace Renderer{
                 uint32_t shapesToCull;
             } uniformData;
 
-            RenderSystem(Device& device, VkRenderPass renderPass);
-            ~RenderSystem();
+            // What the last cullScene submitted
+            struct DrawStats{
+                uint32_t objectCount = 0;
+                uint32_t visibleObjectCount = 0;
+                uint32_t drawCommandCount = 0;
+                uint32_t modelRunCount = 0;
+                uint64_t triangleCount = 0;
+                // False with GPU culling, the counts never come back to the CPU so the above are upper bounds
+                bool exact = true;
+            };
+
+            // Fills the scene in place of the built-in test scene, the spatial index is updated afterwards
+            using SceneSetup = std::function<void(Device& device, Scene& scene)>;
+
+            enum class CullingMode{
+                None,   // Draw every object
+                CPU,    // Frustum cull on the CPU before writing the indirect commands
+                GPU     // Cull and write the indirect commands and draw counts in a compute pass, falls back to CPU without drawIndirectCount
+            };
 
-            void initializeRenderSystem();
+            // Pipelines are created for renderTarget, which the Draw pass's colour and depth attachments must match
+            RenderSystem(Device& device, const RenderTargetInfo& renderTarget, ThreadPool& threadPool, uint32_t framesInFlight);
+            ~RenderSystem();
 
+            void initializeRenderSystem(const SceneSetup& sceneSetup = {});
+            // Blocks until the pipelines compiling on the thread pool are ready, so the next frame draws the scene
+            void waitForPipelines();
+            bool arePipelinesReady() { return pipelineBuilder.isIdle(); }
+            // Recreates every per-frame buffer and descriptor set, waits for the device to go idle
+            void setFramesInFlight(uint32_t count);
+            // Rebuilds the pipelines unless the new target is compatible, the scene isn't drawn until they are ready. The device must be idle.
+            void setRenderTarget(const RenderTargetInfo& renderTarget);
+
+            // Must be the first call of each frame, after the frame's fence has been waited on
+            void beginFrame(uint32_t frameIndex);
             void updateUniformBuffer(Camera camera, uint32_t frameIndex);
+            // Culls the scene against the camera and writes this frame's indirect commands, must be called before drawScene.
+            // In GPU mode this records the culling dispatches, so it has to happen outside of the render pass.
+            void cullScene(VkCommandBuffer commandBuffer, const Camera& camera, uint32_t frameIndex);
             void drawScene(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+            // Records the draws into secondary command buffers on the thread pool and executes them into primaryCommandBuffer.
+            // The render pass must have been begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, setDynamicState is
+            // called on every secondary to set the viewport and scissor.
+            void drawSceneParallel(VkCommandBuffer primaryCommandBuffer, uint32_t frameIndex, const VkCommandBufferInheritanceInfo& inheritanceInfo, const std::function<void(VkCommandBuffer)>& setDynamicState);
+            // Adds a "Cull" pass running cullScene and a "Draw" pass running drawSceneParallel into the colour and depth targets,
+            // resolving colour into resolve unless it is nullResource. The graph orders the draws after the culling writes.
+            void addPasses(RenderGraph& graph, const Camera& camera, uint32_t frameIndex, RenderGraph::Resource colour, RenderGraph::Resource depth, 
+                RenderGraph::Resource resolve, const std::function<void(VkCommandBuffer)>& setDynamicState);
+
+            // Must be called after objects move or are added/removed for culling and drawing to see the change
+            void updateObjectData();
+
+            const DrawStats& getDrawStats() const { return drawStats; }
+
+            CullingMode cullingMode = CullingMode::GPU;
+            // Models and textures of the built-in scene are loaded from here, must end with a slash. Empty uses the RENDERER_ASSET_DIR the build was configured with.
+            std::string assetDirectory;
+            // Fewer model runs than this per recording job aren't worth a secondary command buffer of their own
+            uint32_t minRunsPerRecordingJob = 32;
 
         private:
             void setupScene();
+            void createFrameResources();
             void setupDescriptorSets();
+            void allocateGlobalSet(uint32_t frameIndex);
+            // Material table and texture array, fixed until the scene's materials or textures change
+            void setupMaterialSet();
 
             void createGraphicsPipelineLayout();
             void createGraphicsPipeline();
 
-            void createComputePipelineLayout();
-            void createComputePipeline();
-
             void createIndirectCommands();
             void setupInstanceData();
+            void updateGpuDraws(const std::vector<AABB>& objectBounds);
+
+            uint32_t getDrawRunCount(uint32_t frameIndex) const;
+            void drawRuns(VkCommandBuffer commandBuffer, GraphicsPipeline& pipeline, uint32_t frameIndex, uint32_t beginRun, uint32_t endRun);
             
             size_t padUniformBufferSize(size_t originalSize);
             uint32_t maxMiplevels();
 
             Device& device;
-            VkRenderPass renderPass;
+            RenderTargetInfo renderTarget;
+            uint32_t framesInFlight;
 
             Scene scene;
 
-            std::unique_ptr<GraphicsPipeline> renderPipeline;
+            // Compiled on the thread pool, the scene isn't drawn until it's ready
+            PendingPipeline<GraphicsPipeline> renderPipeline;
             VkPipelineLayout pipelineLayout;
 
-            std::unique_ptr<ComputePipeline> cullPipeline;
-            VkPipelineLayout cullPipelineLayout;
-
+            // Per-frame instance data of the visible draws in sorted order, so each batch reads a contiguous range
             std::vector<std::unique_ptr<Buffer>> instanceBuffers;
-            
+            // Per-object instance data in the dense order of scene.objects
+            std::vector<InstanceData> objectInstanceData;
             std::vector<InstanceData> instanceData;
 
-            std::unique_ptr<Buffer> indirectCommandsBuffer;
+            // Rewritten every frame from the visible object list, so one host visible buffer per frame in flight
+            std::vector<std::unique_ptr<Buffer>> indirectCommandsBuffers;
+            std::vector<std::vector<ModelRun>> frameModelRuns;
             std::vector<VkDrawIndexedIndirectCommand> indirectCommands;
+            uint32_t maxIndirectCommands = 0;
 
-            std::unique_ptr<DescriptorPool> globalPool;
+            CpuCuller cpuCuller;
+            // Dense indices into scene.objects that survived culling this frame
+            std::vector<uint32_t> visibleObjects;
+
+            RenderQueue renderQueue;
+
+            std::unique_ptr<GpuCuller> gpuCuller;
+            // Command ranges and draw count index of each model in the GPU culler's buffers, fixed until the scene changes
+            std::vector<ModelRun> gpuModelRuns;
+
+            ParallelRecorder recorder;
+            // Declared after the pipelines it builds so it is destroyed (and waits for pending builds) first
+            PipelineBuilder pipelineBuilder;
+
+            // One per frame in flight, reset at the start of its frame so transient sets are recycled a whole pool at a time
+            std::vector<std::unique_ptr<DescriptorAllocator>> frameDescriptorAllocators;
             std::unique_ptr<DescriptorSetLayout> globalSetLayout;
+            // Reallocated every frame from the frame's allocator
+            std::vector<VkDescriptorSet> globalSets;
+
+            // Specialization constant sizing the texture array in main.frag
+            static constexpr uint32_t TextureCountId = 0;
+            // Bound to materials without a diffuse texture and to erased texture slots, so every array element is valid
+            std::unique_ptr<Texture> fallbackTexture;
+            std::unique_ptr<Sampler> fallbackSampler;
+            std::unique_ptr<Buffer> materialBuffer;
+            std::unique_ptr<DescriptorAllocator> materialDescriptorAllocator;
+            std::unique_ptr<DescriptorSetLayout> materialSetLayout;
+            VkDescriptorSet materialSet = VK_NULL_HANDLE;
+            uint32_t textureDescriptorCount = 1;
 
             std::vector<std::unique_ptr<Buffer>> uniformBuffers;
             uint32_t latestBinding = 0;
 
-            uint32_t instanceCount;
             uint32_t objectCount;
+
+            DrawStats drawStats;
+            // Every draw of the scene, which is what the GPU culler is given
+            DrawStats gpuDrawStats;
     };
 }
\ No newline at end of file
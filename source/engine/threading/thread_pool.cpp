@@ -0,0 +1,128 @@
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <exception>
+
+namespace Renderer{
+    namespace{
+        thread_local uint32_t currentThreadIndex = 0;
+        thread_local const char* currentPoolName = nullptr;
+    }
+
+    ThreadPool::ThreadPool(uint32_t threadCount, std::string name) : name{std::move(name)}{
+        if(threadCount == 0){
+            uint32_t hardwareThreads = std::thread::hardware_concurrency();
+            threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+        workers.reserve(threadCount);
+        for(uint32_t i = 0; i < threadCount; i++)
+            workers.emplace_back([this, i]{
+                currentThreadIndex = i + 1;
+                currentPoolName = this->name.c_str();
+                workerLoop();
+            });
+    }
+
+    ThreadPool::~ThreadPool(){
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stopping = true;
+        }
+        condition.notify_all();
+        for(auto& worker : workers)
+            worker.join();
+    }
+
+    uint32_t ThreadPool::getCurrentThreadIndex(){
+        return currentThreadIndex;
+    }
+
+    const char* ThreadPool::getCurrentPoolName(){
+        return currentPoolName;
+    }
+
+    void ThreadPool::workerLoop(){
+        while(true){
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                condition.wait(lock, [this]{ return stopping || !tasks.empty(); });
+                if(stopping && tasks.empty())
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::future<void> ThreadPool::submit(std::function<void()> task){
+        // packaged_task is move-only while std::function must be copyable, so share it
+        auto packagedTask = std::make_shared<std::packaged_task<void()>>(std::move(task));
+        std::future<void> future = packagedTask->get_future();
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            tasks.push([packagedTask]{ (*packagedTask)(); });
+        }
+        condition.notify_one();
+        return future;
+    }
+
+    void ThreadPool::parallelFor(uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t begin, uint32_t end)>& function){
+        if(count == 0)
+            return;
+        minBatchSize = std::max(minBatchSize, 1u);
+        uint32_t batchCount = (count + minBatchSize - 1) / minBatchSize;
+        if(batchCount <= 1 || workers.empty()){
+            function(0, count);
+            return;
+        }
+
+        // Oversplit a little so uneven batches balance out, batches are claimed from a shared counter
+        batchCount = std::min(batchCount, (getThreadCount() + 1) * 4);
+        uint32_t batchSize = (count + batchCount - 1) / batchCount;
+        std::atomic<uint32_t> nextBatch{0};
+        auto runBatches = [&]{
+            try{
+                for(uint32_t batch = nextBatch++; batch < batchCount; batch = nextBatch++){
+                    uint32_t begin = batch * batchSize;
+                    uint32_t end = std::min(begin + batchSize, count);
+                    if(begin < end)
+                        function(begin, end);
+                }
+            }
+            catch(...){
+                // Stop handing out batches, the other threads finish the ones they hold
+                nextBatch = batchCount;
+                throw;
+            }
+        };
+
+        uint32_t helperCount = std::min(getThreadCount(), batchCount - 1);
+        std::vector<std::future<void>> helpers;
+        helpers.reserve(helperCount);
+        for(uint32_t i = 0; i < helperCount; i++)
+            helpers.push_back(submit(runBatches));
+        // The helpers reference this stack frame, so every one is joined before the first exception is rethrown
+        std::exception_ptr exception;
+        try{
+            runBatches();
+        }
+        catch(...){
+            exception = std::current_exception();
+        }
+        for(auto& helper : helpers){
+            try{
+                helper.get();
+            }
+            catch(...){
+                if(!exception)
+                    exception = std::current_exception();
+            }
+        }
+        if(exception)
+            std::rethrow_exception(exception);
+    }
+}
\ No newline at end of file
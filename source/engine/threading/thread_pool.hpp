@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <cstdint>
+#include <string>
+
+namespace Renderer{
+    // Fixed-size pool of worker threads shared by the engine's per-frame parallel CPU work (culling, sorting, recording).
+    class ThreadPool{
+        public:
+            // A thread count of 0 uses one worker per hardware thread, minus the calling thread. name labels the workers in traces.
+            ThreadPool(uint32_t threadCount = 0, std::string name = "Worker");
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+            // 0 on threads that aren't pool workers, otherwise 1 + the worker's index, so per-thread resources can be indexed
+            // with [0, getThreadCount()]. Only meaningful for a single pool.
+            static uint32_t getCurrentThreadIndex();
+            // Name of the pool the calling thread works for, nullptr on threads that aren't pool workers
+            static const char* getCurrentPoolName();
+
+            std::future<void> submit(std::function<void()> task);
+
+            // Splits [0, count) into batches of at least minBatchSize items and runs them on the workers and the calling thread,
+            // returning once every batch is done. Small ranges run inline on the calling thread.
+            void parallelFor(uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t begin, uint32_t end)>& function);
+
+        private:
+            void workerLoop();
+
+            std::string name;
+            std::vector<std::thread> workers;
+            std::queue<std::function<void()>> tasks;
+            std::mutex mutex;
+            std::condition_variable condition;
+            bool stopping = false;
+    };
+}
\ No newline at end of file
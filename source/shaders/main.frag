@@ -13,18 +13,28 @@ layout(set = 0, binding = 0) uniform sceneUbo{
   mat4 inverseView;
 } globalUBO;
 
-layout(set = 0, binding = 1) uniform modelDubo{
-  mat4 modelMatrix;
-  mat4 normalMatrix;
-  uint textureIndex;
-} model;
+// Per-draw data pushed before each multi-draw, matches RenderSystem::DrawPushData
+layout(push_constant) uniform DrawPush{
+  uint materialIndex;  // Slot index of the material every draw of the multi-draw uses
+} draw;
 
-layout(set = 0, binding = 2) uniform sampler texSampler;
-layout(set = 0, binding = 3) uniform texture2D textures[1];
+// Matches RenderSystem::MaterialData, indexed by material slot index
+struct MaterialData{
+  uint diffuseTexture;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer materialBuffer{
+  MaterialData materials[];
+};
+
+// Sized by RenderSystem to the scene's texture count, element 0 is a plain white texture for materials without one
+layout(constant_id = 0) const uint TEXTURE_COUNT = 1;
+layout(set = 1, binding = 1) uniform sampler2D textures[TEXTURE_COUNT];
 
 void main(){
     vec3 cameraPosWorld = globalUBO.inverseView[3].xyz;
     vec3 viewDirection = normalize(cameraPosWorld - inFragPosWorld);
 
-    outColor = texture(sampler2D(textures[model.textureIndex], texSampler), inFragTexCoord);
+    // Derived only from the push constant, so the index is dynamically uniform and needs no nonuniformEXT
+    outColor = texture(textures[materials[draw.materialIndex].diffuseTexture], inFragTexCoord);
 }
\ No newline at end of file
@@ -16,16 +16,23 @@ layout(set = 0, binding = 0) uniform sceneUbo{
   mat4 inverseView;
 } globalUBO;
 
-layout(set = 0, binding = 1) uniform modelDubo{
+struct InstanceData{
   mat4 modelMatrix;
   mat4 normalMatrix;
-  uint textureIndex;
-} model;
+  uint materialId;
+  uint modelId;
+};
+
+// Sorted so each indirect command's instances are contiguous from its firstInstance
+layout(std430, set = 0, binding = 1) readonly buffer instanceBuffer{
+  InstanceData instances[];
+};
 
 void main(){
-  vec4 positionWorld = model.modelMatrix * vec4(inPosition, 1.0);
+  InstanceData instance = instances[gl_InstanceIndex];
+  vec4 positionWorld = instance.modelMatrix * vec4(inPosition, 1.0);
   gl_Position = globalUBO.projection * globalUBO.view * positionWorld;
-  fragNormalWorld = normalize(mat3(model.normalMatrix) * inNormal);
+  fragNormalWorld = normalize(mat3(instance.normalMatrix) * inNormal);
   fragPosWorld = positionWorld.xyz;
   fragColor = inColor;
   fragTexCoord = inTexCoord;